@@ -6,14 +6,23 @@
 #include "DeauthDetector.h"
 #include "Config.h"
 
+// Events per POST; keeps the payload inside the JSON document below
+static constexpr size_t API_BATCH_MAX = 16;
+
+enum ReportResult {
+    REPORT_OK,          // 2xx
+    REPORT_RETRY,       // network error, timeout or 5xx; keep the events queued
+    REPORT_REJECTED     // 4xx; the server will never accept this batch
+};
+
 class APIReporter {
 public:
     APIReporter(APIConfig& config);
-    bool sendBatch(const std::vector<DeauthEvent>& events);
+    ReportResult sendBatch(const DeauthEvent* events, size_t count);
 
 private:
     APIConfig& apiConfig;
-    String buildPayload(const std::vector<DeauthEvent>& events);
+    String buildPayload(const DeauthEvent* events, size_t count);
 };
 
 #endif
@@ -8,7 +8,7 @@ class AlertManager {
 public:
     AlertManager(HardwareConfig& config);
     void begin();
-    void triggerAlert();
+    void triggerAlert(bool escalated = false);   // escalated: denylisted sender
     void update();
     bool isAlerting() { return alertActive; }    
     void setBuzzer(bool state);
@@ -21,6 +21,7 @@ public:
 private:
     HardwareConfig& hwConfig;
     bool alertActive;
+    bool escalatedActive;
     unsigned long alertStartTime;
     unsigned long lastPacketTime;
     unsigned long ledTimer;
@@ -0,0 +1,72 @@
+#ifndef ATTACK_FINGERPRINTER_H
+#define ATTACK_FINGERPRINTER_H
+
+#include <Arduino.h>
+#include <vector>
+
+static constexpr size_t MAX_TRACKED_ATTACKERS = 16;
+
+enum SequencePattern : uint8_t {
+    SEQ_ANY = 0,
+    SEQ_INCREMENT,      // sequence number steps by one per frame
+    SEQ_CONSTANT,       // same sequence number every frame (hand-crafted frames)
+    SEQ_RANDOM          // no relation between consecutive frames
+};
+
+// One tool signature, loaded from /deauthdetector/signatures.json.
+// Unset fields don't take part in scoring.
+struct AttackSignature {
+    String          name;
+    uint32_t        reasonMask;     // bit n = reason code n accepted (codes < 32); 0 = any
+    uint32_t        minGapUs;       // mean inter-frame gap window; max 0 = any
+    uint32_t        maxGapUs;
+    uint32_t        minBurst;       // frames per burst window; max 0 = any
+    uint32_t        maxBurst;
+    int8_t          broadcast;      // 1 = broadcast, 0 = targeted, -1 = any
+    SequencePattern sequence;
+    uint16_t        minFrames;      // evidence needed before this signature can be reported
+};
+
+// Running per-sender statistics. Updated in O(1) per frame; signatures are
+// only re-scored every few frames.
+struct AttackerState {
+    uint8_t  mac[6];
+    bool     used;
+    uint32_t frames;
+    uint32_t lastRxUs;
+    uint32_t meanGapUs;         // EWMA of inter-frame gaps within a burst
+    uint32_t burstFrames;       // frames in the current burst
+    uint32_t lastBurstFrames;   // size of the last finished burst
+    uint32_t reasonMask;        // every reason code seen (codes < 32)
+    uint32_t broadcastFrames;
+    uint16_t lastSeq;
+    uint32_t seqStep;           // consecutive frames with seq + 1
+    uint32_t seqSame;           // consecutive frames with the same seq
+    uint32_t seqOther;
+    unsigned long lastSeenMs;
+    int16_t  match;             // best signature index, -1 = none
+    uint8_t  confidence;        // 0-100
+};
+
+class AttackFingerprinter {
+public:
+    AttackFingerprinter();
+    bool loadSignatures(const char* path);
+    size_t signatureCount() const { return signatures.size(); }
+
+    // Feed one captured frame; returns the sender's current best match or -1
+    int update(const uint8_t* sender, const uint8_t* receiver, uint16_t reason,
+               uint16_t seq, uint32_t rxUs, uint8_t& confidence);
+    const String& signatureName(int index) const { return signatures[index].name; }
+    void reset();
+
+private:
+    std::vector<AttackSignature> signatures;
+    AttackerState attackers[MAX_TRACKED_ATTACKERS];
+
+    bool parseSignatures(const char* json, size_t len);
+    AttackerState& slotFor(const uint8_t* mac);
+    void score(AttackerState& a);
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Binary session log (*.ddb): the on-card format, shared by the firmware's
+// writer, the web portal's /events export and tools/ddbexport.
+//
+//   0     header, 64 bytes
+//   64    name dictionary, BLOG_DICT_ENTRIES x 40 bytes, filled in place
+//   8192  blocks of BLOG_BLOCK_RECORDS x 32-byte records
+//
+// Every block starts with an index record (times of its first and last
+// event, event count) followed by up to 63 events. Blocks have a fixed size,
+// so block k sits at BLOG_DATA_START + k * BLOG_BLOCK_BYTES and a time range
+// is found by binary search over index records without touching events.
+// SSIDs and tool names are stored once in the dictionary and events refer to
+// them by id. All fields are little-endian, as on both the ESP32-S3 and x86.
+//
+// The trailing block may be partly written; readers stop at the first slot
+// that isn't an event.
+
+static const char     BLOG_MAGIC[4] = {'D', 'D', 'B', '1'};
+static const uint16_t BLOG_VERSION = 1;
+static const size_t   BLOG_RECORD_SIZE = 32;
+static const size_t   BLOG_BLOCK_RECORDS = 64;      // index record + 63 events
+static const size_t   BLOG_BLOCK_BYTES = BLOG_BLOCK_RECORDS * BLOG_RECORD_SIZE;
+static const size_t   BLOG_DICT_START = 64;
+static const size_t   BLOG_DICT_ENTRY_SIZE = 40;
+static const size_t   BLOG_DICT_ENTRIES = 200;
+static const size_t   BLOG_DATA_START = 8192;       // sector aligned, past the dictionary
+
+// Record types, the first byte of every record
+static const uint8_t BLOG_INDEX = 'I';
+static const uint8_t BLOG_EVENT = 'E';
+
+// Dictionary ids: 0 is the empty string, 1..BLOG_DICT_ENTRIES are entries,
+// BLOG_NAME_LOST is a name that arrived after the dictionary filled up
+static const uint8_t BLOG_NAME_NONE = 0;
+static const uint8_t BLOG_NAME_LOST = 255;
+
+// Event flags
+static const uint8_t BLOG_DENYLISTED = 1 << 0;
+static const uint8_t BLOG_RANDOMIZED = 1 << 1;
+
+struct BlogHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    uint16_t blockRecords;
+    uint16_t dictEntries;
+    uint16_t dictEntrySize;
+    uint16_t reserved0;
+    int64_t  createdUs;         // wall clock when the session started
+    uint8_t  reserved[40];
+};
+
+struct BlogDictEntry {
+    uint8_t len;                // 0 = unused
+    char    name[39];           // not NUL-terminated; see len
+};
+
+struct BlogIndex {
+    uint8_t  type;              // BLOG_INDEX
+    uint8_t  reserved0;
+    uint16_t count;             // events in the block so far
+    uint32_t block;
+    int64_t  firstUs;
+    int64_t  lastUs;
+    uint32_t firstSeq;          // low 32 bits of the first event's sequence number
+    uint32_t reserved1;
+};
+
+struct BlogEvent {
+    uint8_t  type;              // BLOG_EVENT
+    uint8_t  channel;
+    int8_t   rssi;
+    uint8_t  flags;             // BLOG_DENYLISTED | BLOG_RANDOMIZED
+    uint32_t packetCount;
+    int64_t  timeUs;            // wall clock, microseconds since the epoch
+    uint8_t  bssid[6];
+    uint8_t  attacker[6];
+    uint8_t  ssid;              // dictionary id
+    uint8_t  tool;              // dictionary id
+    uint8_t  toolConfidence;
+    uint8_t  vendor;            // OuiLookup vendor index
+};
+
+static_assert(sizeof(BlogHeader) == 64, "BlogHeader layout");
+static_assert(sizeof(BlogDictEntry) == BLOG_DICT_ENTRY_SIZE, "BlogDictEntry layout");
+static_assert(sizeof(BlogIndex) == BLOG_RECORD_SIZE, "BlogIndex layout");
+static_assert(sizeof(BlogEvent) == BLOG_RECORD_SIZE, "BlogEvent layout");
+static_assert(BLOG_DICT_START + BLOG_DICT_ENTRIES * BLOG_DICT_ENTRY_SIZE <= BLOG_DATA_START, "dictionary overlaps data");
+
+inline size_t blogBlockOffset(uint32_t block) {
+    return BLOG_DATA_START + (size_t)block * BLOG_BLOCK_BYTES;
+}
+
+// "AA:BB:CC:DD:EE:FF" to bytes; false if malformed
+inline bool blogParseMac(const char* s, uint8_t* mac) {
+    for (int i = 0; i < 6; i++) {
+        uint8_t v = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = *s++;
+            uint8_t d = c >= '0' && c <= '9' ? c - '0'
+                      : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                      : c >= 'a' && c <= 'f' ? c - 'a' + 10 : 0xFF;
+            if (d == 0xFF) return false;
+            v = (uint8_t)(v << 4 | d);
+        }
+        mac[i] = v;
+        if (i < 5 && *s++ != ':') return false;
+    }
+    return true;
+}
+
+inline void blogFormatMac(const uint8_t* mac, char* out) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (int i = 0; i < 6; i++) {
+        out[i * 3] = hex[mac[i] >> 4];
+        out[i * 3 + 1] = hex[mac[i] & 0x0F];
+        out[i * 3 + 2] = i < 5 ? ':' : '\0';
+    }
+}
+
+// Reads a .ddb through Source, which provides
+//   size_t size();
+//   bool readAt(size_t offset, void* buf, size_t n);
+// The caller supplies room for the dictionary (BLOG_DICT_ENTRIES entries),
+// so the reader itself allocates nothing.
+template <typename Source>
+class BlogReader {
+public:
+    BlogReader(Source& source, BlogDictEntry* dictionary) : src(source), dict(dictionary), blocks(0) {}
+
+    bool open() {
+        BlogHeader h;
+        if (!src.readAt(0, &h, sizeof(h)) || memcmp(h.magic, BLOG_MAGIC, 4) != 0 ||
+            h.version != BLOG_VERSION || h.recordSize != BLOG_RECORD_SIZE ||
+            h.blockRecords != BLOG_BLOCK_RECORDS || h.dictEntries != BLOG_DICT_ENTRIES) {
+            return false;
+        }
+        header = h;
+        if (!src.readAt(BLOG_DICT_START, dict, BLOG_DICT_ENTRIES * sizeof(BlogDictEntry))) {
+            return false;
+        }
+        size_t bytes = src.size();
+        blocks = bytes > BLOG_DATA_START ? (uint32_t)((bytes - BLOG_DATA_START + BLOG_BLOCK_BYTES - 1) / BLOG_BLOCK_BYTES) : 0;
+        return true;
+    }
+
+    const BlogHeader& getHeader() const { return header; }
+    uint32_t blockCount() const { return blocks; }
+
+    // Name for a dictionary id, copied into out (at least 40 bytes)
+    const char* name(uint8_t id, char* out) const {
+        out[0] = '\0';
+        if (id == BLOG_NAME_LOST) {
+            strcpy(out, "?");
+        } else if (id != BLOG_NAME_NONE && id <= BLOG_DICT_ENTRIES) {
+            const BlogDictEntry& e = dict[id - 1];
+            size_t n = e.len < sizeof(e.name) ? e.len : sizeof(e.name);
+            memcpy(out, e.name, n);
+            out[n] = '\0';
+        }
+        return out;
+    }
+
+    bool readIndex(uint32_t block, BlogIndex& index) {
+        return block < blocks && src.readAt(blogBlockOffset(block), &index, sizeof(index)) &&
+               index.type == BLOG_INDEX && index.count > 0;
+    }
+
+    // First block that can hold events at or after fromUs
+    uint32_t findBlock(int64_t fromUs) {
+        uint32_t lo = 0, hi = blocks;
+        BlogIndex index;
+        // Last block whose first event is at or before fromUs
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (readIndex(mid, index) && index.firstUs <= fromUs) lo = mid;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Calls f(const BlogEvent&) for each event in [fromUs, toUs], oldest
+    // first; stops early if f returns false. Returns the number visited.
+    template <typename F>
+    size_t scan(int64_t fromUs, int64_t toUs, F f) {
+        size_t visited = 0;
+        BlogEvent events[BLOG_BLOCK_RECORDS - 1];
+        for (uint32_t b = findBlock(fromUs); b < blocks; b++) {
+            BlogIndex index;
+            if (!readIndex(b, index)) break;
+            if (index.firstUs > toUs) break;
+            size_t n = index.count < BLOG_BLOCK_RECORDS - 1 ? index.count : BLOG_BLOCK_RECORDS - 1;
+            size_t offset = blogBlockOffset(b) + BLOG_RECORD_SIZE;
+            size_t avail = src.size() > offset ? (src.size() - offset) / BLOG_RECORD_SIZE : 0;
+            if (n > avail) n = avail;
+            if (n == 0 || !src.readAt(offset, events, n * BLOG_RECORD_SIZE)) break;
+            for (size_t i = 0; i < n; i++) {
+                if (events[i].type != BLOG_EVENT) break;
+                if (events[i].timeUs < fromUs || events[i].timeUs > toUs) continue;
+                visited++;
+                if (!f(events[i])) return visited;
+            }
+        }
+        return visited;
+    }
+
+private:
+    Source& src;
+    BlogDictEntry* dict;
+    BlogHeader header;
+    uint32_t blocks;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BINARY_LOG_WRITER_H
+#define BINARY_LOG_WRITER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "BinaryLog.h"
+#include "EventRing.h"
+
+// BlogReader source over an open SD file
+struct BlogFileSource {
+    File& file;
+    size_t size() { return file.size(); }
+    bool readAt(size_t offset, void* buf, size_t n) {
+        return file.seek(offset) && file.read((uint8_t*)buf, n) == n;
+    }
+};
+
+// Writes a .ddb session log (see BinaryLog.h). Used from the session writer
+// task only, so it needs no locking.
+//
+// The open block is kept in RAM. Each flush writes any new dictionary
+// entries, the block's index record and the events added since the last
+// flush, so the file on the card is always readable up to the last flush.
+// Buffers are allocated by the first begin() and reused for later files.
+class BinaryLogWriter {
+public:
+    BinaryLogWriter();
+
+    bool begin(const char* path, int64_t createdUs);
+    bool isOpen() const { return opened; }
+    // Flushes and closes the file
+    void close();
+    // Size of the file as of the last flush
+    size_t bytes() const { return blogBlockOffset(blockNo) + flushedSlots * BLOG_RECORD_SIZE; }
+
+    void append(const DeauthEvent& event);
+    bool flush();
+
+private:
+    String path;
+    File file;
+    uint8_t* block;             // BLOG_BLOCK_BYTES, the open block
+    BlogDictEntry* dict;        // BLOG_DICT_ENTRIES
+    uint32_t* dictHash;         // BLOG_DICT_ENTRIES, to skip most compares
+    size_t slots;               // records in the open block, index included
+    size_t flushedSlots;        // records of the open block already on the card
+    uint32_t blockNo;
+    size_t dictUsed;
+    size_t dictFlushed;
+    bool opened;
+
+    uint8_t nameId(const char* name);
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Small LZ77 codec in the LZ4 block format, for log blocks of up to 64 KB.
+//
+// The compressor is greedy with a single-entry hash table of
+// LZ_HASH_SIZE 16-bit positions, which the caller provides, so it needs
+// 2 KB of scratch and no heap. Log lines repeat the same MACs, SSIDs and
+// field layout; session CSV compressed in 4 KB blocks typically shrinks
+// to a third or less. The decompressor checks every length and
+// offset against both buffers, so a corrupt block fails instead of
+// overrunning.
+//
+// No Arduino dependencies; tools/ddunzip uses the same code.
+
+static const unsigned LZ_HASH_BITS = 10;
+static const size_t   LZ_HASH_SIZE = (size_t)1 << LZ_HASH_BITS;
+static const size_t   LZ_MAX_INPUT = 65536;
+static const size_t   LZ_MIN_MATCH = 4;
+static const size_t   LZ_LAST_LITERALS = 5;     // the format ends with at least this many literals
+static const size_t   LZ_MATCH_LIMIT = 12;      // no match starts closer than this to the end
+static const size_t   LZ_ERROR = (size_t)-1;
+
+// Worst-case compressed size of n bytes
+inline size_t lzBound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+inline uint32_t lzRead32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t lzHash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Writes a length that didn't fit in the token's four bits
+inline bool lzPutLength(uint8_t*& op, const uint8_t* end, size_t n) {
+    for (; n >= 255; n -= 255) {
+        if (op == end) return false;
+        *op++ = 255;
+    }
+    if (op == end) return false;
+    *op++ = (uint8_t)n;
+    return true;
+}
+
+// One sequence: literals, then a match of len bytes offset back (len 0 for
+// the final literals-only sequence)
+inline bool lzSequence(uint8_t*& op, const uint8_t* end, const uint8_t* literals, size_t lit,
+                       size_t offset, size_t len) {
+    if (op == end) return false;
+    uint8_t* token = op++;
+    *token = (uint8_t)((lit < 15 ? lit : 15) << 4);
+    if (lit >= 15 && !lzPutLength(op, end, lit - 15)) return false;
+    if ((size_t)(end - op) < lit) return false;
+    memcpy(op, literals, lit);
+    op += lit;
+    if (len == 0) {
+        return true;
+    }
+    if (end - op < 2) return false;
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t extra = len - LZ_MIN_MATCH;
+    *token |= (uint8_t)(extra < 15 ? extra : 15);
+    return extra < 15 || lzPutLength(op, end, extra - 15);
+}
+
+// Compresses n bytes (at most LZ_MAX_INPUT) of src into dst; returns the
+// compressed size, or 0 if it doesn't fit in cap
+inline size_t lzCompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap, uint16_t* table) {
+    if (n > LZ_MAX_INPUT) {
+        return 0;
+    }
+    uint8_t* op = dst;
+    const uint8_t* end = dst + cap;
+    size_t anchor = 0;
+    memset(table, 0, LZ_HASH_SIZE * sizeof(uint16_t));
+
+    if (n > LZ_MATCH_LIMIT) {
+        size_t limit = n - LZ_MATCH_LIMIT;
+        size_t matchEnd = n - LZ_LAST_LITERALS;
+        size_t ip = 1;
+        while (ip < limit) {
+            uint32_t seq = lzRead32(src + ip);
+            uint32_t h = lzHash(seq);
+            size_t ref = table[h];
+            table[h] = (uint16_t)ip;
+            if (ref >= ip || lzRead32(src + ref) != seq) {
+                ip++;
+                continue;
+            }
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t len = LZ_MIN_MATCH;
+            while (ip + len < matchEnd && src[ip + len] == src[ref + len]) {
+                len++;
+            }
+            if (!lzSequence(op, end, src + anchor, ip - anchor, ip - ref, len)) {
+                return 0;
+            }
+            ip += len;
+            anchor = ip;
+            if (ip - 2 < limit) {
+                table[lzHash(lzRead32(src + ip - 2))] = (uint16_t)(ip - 2);
+            }
+        }
+    }
+    if (!lzSequence(op, end, src + anchor, n - anchor, 0, 0)) {
+        return 0;
+    }
+    return (size_t)(op - dst);
+}
+
+// Expands n compressed bytes into dst; returns the size, or LZ_ERROR if the
+// input is malformed or would not fit in cap
+inline size_t lzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < n) {
+        uint8_t token = src[ip++];
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= n) return LZ_ERROR;
+                b = src[ip++];
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > n - ip || lit > cap - op) return LZ_ERROR;
+        memcpy(dst + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == n) {
+            break;      // the last sequence has no match
+        }
+
+        if (n - ip < 2) return LZ_ERROR;
+        size_t offset = src[ip] | (size_t)src[ip + 1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > op) return LZ_ERROR;
+        size_t len = token & 0x0F;
+        if (len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= n) return LZ_ERROR;
+                b = src[ip++];
+                len += b;
+            } while (b == 255);
+        }
+        len += LZ_MIN_MATCH;
+        if (len > cap - op) return LZ_ERROR;
+        // Byte by byte: the match may overlap what it is producing
+        for (size_t i = 0; i < len; i++) {
+            dst[op + i] = dst[op - offset + i];
+        }
+        op += len;
+    }
+    return op;
+}
+
+#endif
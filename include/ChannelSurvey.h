@@ -0,0 +1,67 @@
+#ifndef CHANNEL_SURVEY_H
+#define CHANNEL_SURVEY_H
+
+#include <Arduino.h>
+
+static constexpr int SURVEY_CHANNELS = 14;
+static constexpr int SURVEY_RSSI_BINS = 6;     // <-90, -90..-81, -80..-71, -70..-61, -60..-51, >=-50
+static constexpr int SURVEY_HISTORY = 6;       // completed buckets kept per channel
+
+// Counters for one channel over one time bucket
+struct SurveyCounters {
+    uint32_t frames;
+    uint32_t mgmt;
+    uint32_t retries;
+    uint32_t rssiBins[SURVEY_RSSI_BINS];
+    uint32_t dwellMs;   // time the radio was actually tuned to this channel
+};
+
+// Per-channel occupancy counters fed from the promiscuous callback.
+//
+// The WiFi task is the only writer of the live bucket, so record() is a few
+// plain increments with no lock. The main loop owns bucket rotation: it clears
+// the next slot before publishing it as live, so the writer never sees a
+// half-cleared bucket. A frame counted during the rotation itself may land in
+// the bucket that just closed, which is fine for a survey.
+class ChannelSurvey {
+public:
+    ChannelSurvey();
+    void begin(uint32_t bucketMs);
+    void reset();
+
+    // Promiscuous callback context
+    inline void record(int channel, bool mgmt, bool retry, int rssi) {
+        if (channel < 1 || channel > SURVEY_CHANNELS) return;
+        SurveyCounters& c = buckets[liveBucket][channel - 1];
+        c.frames++;
+        if (mgmt) c.mgmt++;
+        if (retry) c.retries++;
+        c.rssiBins[rssiBin(rssi)]++;
+    }
+
+    // Main loop context
+    void addDwell(int channel, uint32_t ms);
+    void update(unsigned long now);
+
+    // Completed bucket, 0 = most recent. Returns false if not yet available.
+    bool getBucket(int age, int channel, SurveyCounters& out) const;
+    int completedBuckets() const { return completed; }
+    uint32_t bucketMs() const { return bucketLengthMs; }
+
+    static int rssiBin(int rssi) {
+        if (rssi < -90) return 0;
+        if (rssi >= -50) return SURVEY_RSSI_BINS - 1;
+        return (rssi + 100) / 10;
+    }
+    static int rssiBinFloor(int bin) { return bin == 0 ? -127 : -100 + bin * 10; }
+    static int approxRssi(const SurveyCounters& c);
+
+private:
+    SurveyCounters buckets[SURVEY_HISTORY + 1][SURVEY_CHANNELS];
+    volatile int liveBucket;
+    int completed;
+    uint32_t bucketLengthMs;
+    unsigned long bucketStart;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef COMPRESSED_LOG_H
+#define COMPRESSED_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "BlockCodec.h"
+#include "Crc32.h"
+
+// Block-compressed text log (*.ddz): the on-card format of compressed
+// session CSVs and debug logs, shared by the firmware's writer, the web
+// portal and tools/ddunzip.
+//
+//   0     header, 32 bytes
+//   32    block header (32 bytes) + payload, repeated
+//
+// A block holds up to DDZ_BLOCK_RAW bytes of whole lines, compressed on
+// its own (BlockCodec.h) or stored as is when that is no smaller. Its header
+// carries the text and payload sizes, the time of its first and last line
+// and a CRC-32, so the headers double as the index: a time range is found by
+// hopping from header to header without decompressing anything, and any one
+// block can be expanded without the others. All fields are little-endian.
+//
+// The writer rewrites the last block in place as it grows, until it holds
+// about 1 KB of text. After a power cut the file may end in a torn block or
+// in stale bytes from an earlier version of it; readers stop at the first
+// block whose magic, sizes or CRC don't check out.
+
+static const char     DDZ_MAGIC[4] = {'D', 'D', 'Z', '1'};
+static const uint16_t DDZ_VERSION = 1;
+static const size_t   DDZ_BLOCK_RAW = 4096;
+static const uint32_t DDZ_BLOCK_MAGIC = 0x4B4C425A;     // "ZBLK"
+static const uint32_t DDZ_STORED = 1 << 0;              // payload is the text itself
+
+struct DdzHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t blockRaw;          // DDZ_BLOCK_RAW of the writer
+    uint32_t reserved[5];
+};
+
+struct DdzBlock {
+    uint32_t magic;             // DDZ_BLOCK_MAGIC
+    uint32_t crc;               // CRC-32 of the rest of this header and the payload
+    uint32_t rawLen;            // text bytes
+    uint32_t storedLen;         // payload bytes that follow
+    uint32_t firstTime;         // Unix seconds of the first and last line
+    uint32_t lastTime;
+    uint32_t lines;
+    uint32_t flags;             // DDZ_STORED
+};
+
+static_assert(sizeof(DdzHeader) == 32, "DdzHeader layout");
+static_assert(sizeof(DdzBlock) == 32, "DdzBlock layout");
+
+// Largest payload a block can have
+static const size_t DDZ_STORED_MAX = DDZ_BLOCK_RAW + DDZ_BLOCK_RAW / 255 + 16;
+
+inline uint32_t ddzBlockCrc(const DdzBlock& block, const void* payload) {
+    const uint8_t* rest = (const uint8_t*)&block + 2 * sizeof(uint32_t);
+    uint32_t crc = crc32Update(0, rest, sizeof(block) - 2 * sizeof(uint32_t));
+    return crc32Update(crc, payload, block.storedLen);
+}
+
+inline void ddzInitHeader(DdzHeader& h) {
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DDZ_MAGIC, sizeof(h.magic));
+    h.version = DDZ_VERSION;
+    h.blockRaw = DDZ_BLOCK_RAW;
+}
+
+// Reads a .ddz through Source, which provides
+//   size_t size();
+//   bool readAt(size_t offset, void* buf, size_t n);
+// The caller supplies the payload and text buffers (DDZ_STORED_MAX and
+// DDZ_BLOCK_RAW bytes), so the reader itself allocates nothing.
+template <typename Source>
+class DdzReader {
+public:
+    DdzReader(Source& source, uint8_t* payloadBuf, uint8_t* textBuf)
+        : src(source), payload(payloadBuf), text(textBuf), offset(0), current(0), end(0) {}
+
+    bool open() {
+        DdzHeader h;
+        if (!src.readAt(0, &h, sizeof(h)) || memcmp(h.magic, DDZ_MAGIC, 4) != 0 ||
+            h.version != DDZ_VERSION || h.blockRaw > DDZ_BLOCK_RAW) {
+            return false;
+        }
+        offset = sizeof(h);
+        end = src.size();
+        return true;
+    }
+
+    // Header of the next block, or false at the end of the log
+    bool next(DdzBlock& block) {
+        if (end - offset < sizeof(block) || !src.readAt(offset, &block, sizeof(block)) ||
+            block.magic != DDZ_BLOCK_MAGIC || block.rawLen > DDZ_BLOCK_RAW ||
+            block.storedLen > DDZ_STORED_MAX || block.storedLen > end - offset - sizeof(block)) {
+            return false;
+        }
+        current = offset;
+        offset += sizeof(block) + block.storedLen;
+        return true;
+    }
+
+    // Text of the block next() just returned, in the text buffer; nullptr
+    // if the block is damaged
+    const char* expand(const DdzBlock& block) {
+        if (!src.readAt(current + sizeof(block), payload, block.storedLen) ||
+            ddzBlockCrc(block, payload) != block.crc) {
+            return nullptr;
+        }
+        if (block.flags & DDZ_STORED) {
+            if (block.storedLen != block.rawLen) return nullptr;
+            memcpy(text, payload, block.rawLen);
+        } else if (lzDecompress(payload, block.storedLen, text, DDZ_BLOCK_RAW) != block.rawLen) {
+            return nullptr;
+        }
+        return (const char*)text;
+    }
+
+    // Calls fn(text, len, block) for every block whose time range overlaps
+    // [from, to]; stops early when fn returns false or at a damaged block.
+    // Blocks without times (0) always match.
+    template <typename Fn>
+    void scan(uint32_t from, uint32_t to, Fn fn) {
+        DdzBlock block;
+        while (next(block)) {
+            if (block.lastTime != 0 && (block.lastTime < from || block.firstTime > to)) {
+                continue;
+            }
+            const char* t = expand(block);
+            if (!t || !fn(t, (size_t)block.rawLen, block)) {
+                return;
+            }
+        }
+    }
+
+private:
+    Source& src;
+    uint8_t* payload;
+    uint8_t* text;
+    size_t offset;              // next block header
+    size_t current;             // header of the block next() returned
+    size_t end;
+};
+
+#endif
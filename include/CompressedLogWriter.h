@@ -0,0 +1,64 @@
+#ifndef COMPRESSED_LOG_WRITER_H
+#define COMPRESSED_LOG_WRITER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "CompressedLog.h"
+
+// DdzReader source over an open SD file
+struct DdzFileSource {
+    File& file;
+    size_t size() { return file.size(); }
+    bool readAt(size_t offset, void* buf, size_t n) {
+        return file.seek(offset) && file.read((uint8_t*)buf, n) == n;
+    }
+};
+
+// Writes a block-compressed text log (see CompressedLog.h). Not
+// thread-safe; each owner calls it from its own writer task.
+//
+// The open block's text is kept in RAM. Each flush compresses the whole
+// block again and rewrites it at its place in the file, so the file is
+// readable up to the last flush. A power cut during that rewrite loses the
+// block's earlier version too, so a flush seals the block once it holds
+// COMPRESSED_SEAL_RAW bytes of text; a torn rewrite then costs less than
+// that of what earlier flushes wrote. A block is also sealed when the next
+// lines don't fit. Buffers are allocated by the first begin() and reused
+// for later files.
+static const size_t COMPRESSED_SEAL_RAW = 1024;
+
+class CompressedLogWriter {
+public:
+    CompressedLogWriter();
+
+    // Creates (truncates) path and writes the file header
+    bool begin(const char* path);
+    bool isOpen() const { return opened; }
+    // Flushes and closes the file
+    void close();
+    // Size of the file as of the last flush
+    size_t bytes() const { return sealedBytes + openBytes; }
+
+    // Whole lines, first and last stamped with Unix seconds
+    void append(const char* text, size_t len, uint32_t firstTime, uint32_t lastTime);
+    bool flush();
+
+private:
+    String path;
+    File file;
+    uint8_t* raw;               // DDZ_BLOCK_RAW, the open block's text
+    uint8_t* packed;            // block header + DDZ_STORED_MAX
+    uint16_t* table;            // LZ_HASH_SIZE, compressor scratch
+    DdzBlock block;             // header of the open block, sizes filled at flush
+    size_t rawUsed;
+    size_t flushedRaw;          // rawUsed at the last flush
+    size_t sealedBytes;         // where the open block starts
+    size_t openBytes;           // the open block as last written
+    bool opened;
+
+    bool writeOpen();
+    void seal();
+    void startBlock();
+};
+
+#endif
@@ -12,6 +12,17 @@
 #define DEFAULT_PACKET_THRESHOLD 250
 #define DEFAULT_CHANNEL_SCAN_TIME_MS 100
 #define DEFAULT_CHANNEL_HOP_INTERVAL_MS 75
+#define DEFAULT_SURVEY_BUCKET_SECONDS 10
+
+// Session log segments
+#define DEFAULT_SEGMENT_MAX_KB 1024
+#define DEFAULT_SEGMENT_MAX_MINUTES 1440
+#define DEFAULT_LOG_BUDGET_MB 512
+#define DEFAULT_LOG_COMPRESS false
+
+// pcapng frame capture
+#define DEFAULT_CAPTURE_FILE_MAX_KB 1024
+#define DEFAULT_CAPTURE_MAX_FILES 20
 
 struct WiFiConfig {
     String sta_ssid;
@@ -35,6 +46,11 @@ struct DetectionConfig {
     int channel_hop_interval_ms;
 };
 
+struct SurveyConfig {
+    bool enabled;
+    int bucket_seconds;
+};
+
 struct APIConfig {
     String endpoint_url;
     String custom_header_name;
@@ -50,15 +66,34 @@ struct HardwareConfig {
 
 struct DebugConfig {
     bool enabled;
+    String trace;               // binary trace output: "off", "serial" or "sd"
+};
+
+// 0 turns the corresponding limit off
+struct LoggingConfig {
+    int segment_max_kb;         // rotate when the segment's CSV reaches this size
+    int segment_max_minutes;    // ...or when the segment is this old
+    int budget_mb;              // delete the oldest segments beyond this total
+    bool compress;              // session CSV and debug log as block-compressed .ddz
+};
+
+// Raw deauth/disassoc frames to pcapng files; 0 turns a limit off
+struct CaptureConfig {
+    bool enabled;
+    int file_max_kb;            // start a new file at this size
+    int max_files;              // delete the oldest files beyond this many
 };
 
 struct AppConfig {
     WiFiConfig wifi;
     NTPConfig ntp;
     DetectionConfig detection;
+    SurveyConfig survey;
     APIConfig api;
     HardwareConfig hardware;
     DebugConfig debug;
+    LoggingConfig logging;
+    CaptureConfig capture;
 };
 
 #endif
@@ -3,66 +3,219 @@
 
 #include <Arduino.h>
 #include <vector>
-#include <map>
+#include <atomic>
 #include <freertos/semphr.h>
 #include "Config.h"
+#include "SSIDMatcher.h"
+#include "ChannelSurvey.h"
+#include "HopScheduler.h"
+#include "AttackFingerprinter.h"
+#include "EventRing.h"
+#include "TrendStore.h"
+#include "MacFilter.h"
+#include "MacBatch.h"
+#include "DetectorPolicy.h"
+#include "PsramAllocator.h"
+
+// Sender's standing, looked up in the capture path
+enum MacListing : uint8_t {
+    MAC_UNLISTED = 0,
+    MAC_ALLOWLISTED,    // known-good sender: counted, never an event
+    MAC_DENYLISTED      // known-hostile sender: no threshold, escalated alert
+};
 
 // Lightweight POD captured in ISR context — no heap allocations
 struct RawDeauthCapture {
-    uint8_t addr2[6];   // sender MAC
-    uint8_t addr3[6];   // BSSID
-    int     channel;
-    int     rssi;
-    time_t  timestamp;
+    uint8_t  addr1[6];  // receiver MAC (FF:FF:FF:FF:FF:FF = broadcast)
+    uint8_t  addr2[6];  // sender MAC
+    uint8_t  addr3[6];  // BSSID
+    uint8_t  subtype;   // 0x0C deauth, 0x0A disassoc
+    uint16_t reason;    // 802.11 reason code
+    uint16_t seq;       // 12-bit sequence number
+    uint32_t rxUs;      // radio timestamp, microseconds
+    MacListing listed;  // sender on the allow/deny list
+    int      channel;
+    int      rssi;
+    int64_t  timeUs;    // wall clock, microseconds; set at drain time under STAMP_PER_DRAIN
+};
+
+// SSID learned from a probe response or (re)association request
+struct RawSsidCapture {
+    uint8_t bssid[6];
+    uint8_t len;
+    uint8_t channel;
+    char    ssid[32];   // not NUL-terminated; see len
 };
 
-static constexpr size_t RAW_RING_SIZE = 64;
+static constexpr size_t SSID_SEEN_SLOTS = 64;
+static constexpr size_t DENIED_SENDER_SLOTS = 16;
+
+// Running totals for one protected_ssids entry, kept up to date as events
+// are processed so dashboard reads don't depend on event volume
+struct SsidStats {
+    uint32_t events;        // events in the current reporting window
+    uint32_t frames;        // attack frames since boot, past the threshold too
+    int channel;            // 0 = not seen yet
+    DeauthEvent last;       // last.seq == 0 if none
+};
 
-struct DeauthEvent {
-    time_t timestamp;
-    String target_ssid;
-    String target_bssid;
-    String attacker_mac;
-    int channel;
-    int rssi;
-    int packet_count;
+// Independent readers of the event stream, each with its own cursor
+enum EventConsumer {
+    CONSUMER_LOGGER = 0,    // session CSV
+    CONSUMER_ALERTS,        // buzzer/LED
+    CONSUMER_REPORTER,      // API batches, acked only after a 2xx
+    CONSUMER_COUNT
 };
 
-class DeauthDetector {
+static constexpr size_t SNAPSHOT_RECENT = 8;
+static constexpr size_t SNAPSHOT_BUFFERS = 3;
+
+// Immutable copy of what the UI and reporting need. Published by the
+// processing side with a pointer swap; a snapshot is never modified while a
+// reader holds it.
+struct DetectorSnapshot {
+    uint64_t latestSeq;                     // newest event, 0 if none
+    std::vector<SsidStats> ssids;           // by protected_ssids position
+    DeauthEvent recent[SNAPSHOT_RECENT];    // newest first
+    size_t recentCount;
+    mutable std::atomic<int> readers;
+};
+
+// Detector core, specialized at compile time by a policy from
+// DetectorPolicy.h. Only ActiveDetectorPolicy is instantiated (at the end of
+// DeauthDetector.cpp); the rest of the firmware uses the DeauthDetector alias.
+template <typename Policy>
+class DeauthDetectorCore {
 public:
-    DeauthDetector();
+    typedef typename Policy::Counter Counter;
+
+    DeauthDetectorCore();
     void begin(const std::vector<String>& protected_ssids, const DetectionConfig& config);
     void startMonitoring();
     void stopMonitoring();
-    bool hasEvents();
-    std::vector<DeauthEvent> getEvents();
+    // Starts a new reporting window: resets per-BSSID thresholds and counts
     void clearEvents();
-    int getEventCountForSSID(const String& ssid);
-    DeauthEvent getLastEventForSSID(const String& ssid);
-    int getChannelForSSID(const String& ssid);
+
+    // Consumer cursors: each call returns only events this consumer hasn't
+    // read yet. ackEvents() confirms everything read so far; rewindEvents()
+    // goes back to the last ack so the next read retries.
+    size_t readEvents(EventConsumer consumer, DeauthEvent* out, size_t max, uint64_t* lost = nullptr);
+    void ackEvents(EventConsumer consumer);
+    void rewindEvents(EventConsumer consumer);
+    uint64_t pendingEvents(EventConsumer consumer);
+
+    size_t getRecentEvents(DeauthEvent* out, size_t max);   // newest first
+    uint64_t getLatestSeq();
+    // Consistent copy of one entry's totals, by protected_ssids position
+    bool getSsidStats(size_t index, SsidStats& out) const;
+
+    // Lock-free read side. Never blocks and never returns nullptr; release
+    // promptly so the buffer can be reused. Prefer SnapshotRef.
+    const DetectorSnapshot* acquireSnapshot() const;
+    void releaseSnapshot(const DetectorSnapshot* snapshot) const;
     void updateChannelHop();
+    void enableSurvey(const SurveyConfig& config);
+    bool loadSignatures(const char* path) { return fingerprinter.loadSignatures(path); }
+    // Call before startMonitoring(); the capture path reads the lists unlocked
+    void loadMacLists(const char* allowPath, const char* denyPath);
+    uint32_t getAllowlistedFrames() const { return allowlistedFrames; }
+    // Deauth/disassoc frames from senders not allowlisted, since boot
+    uint32_t getAttackFrames() const { return attackFrames; }
+    bool isSurveyEnabled() const { return Policy::SURVEY && surveyEnabled; }
+    static const char* presetName() { return Policy::NAME; }
+    const ChannelSurvey& getSurvey() const { return survey; }
+    TrendStore& getTrends() { return trends; }
+    bool loadTrends(const char* path) { return trends.load(path, time(nullptr)); }
+    bool saveTrends(const char* path) { return trends.save(path); }
+    bool saveTrendChanges(const char* path) { return trends.saveChanges(path); }
 
 private:
-    std::vector<String> protectedSSIDs;
-    std::vector<DeauthEvent> events;
+    SSIDMatcher ssidMatcher;
+    EventRing events;
     std::vector<int> activeChannels;
-    std::map<String, int> ssidChannelMap;
-    std::map<String, String> bssidToSsidMap;  // BSSID -> SSID lookup
+    std::vector<SsidStats> ssidStats;   // writer side, guarded by mutex
+
+    // Three buffers: one published, one possibly still held by a reader of
+    // the previous snapshot, one free for the next publish
+    DetectorSnapshot snapshots[SNAPSHOT_BUFFERS];
+    std::atomic<DetectorSnapshot*> published;
+    bool snapshotDirty;         // a publish was skipped because every buffer was held
+    // BSSID -> network lookup for the per-frame path, without String keys
+    struct BssidInfo {
+        String   ssid;              // "Unknown" until learned
+        int      protectedIndex;    // matching protected_ssids entry, -1 if none
+        Counter  packets;           // counted toward packet_threshold this window
+    };
+    BssidTable bssidIndex;
+    PsramVector<BssidInfo, MEM_BSSIDS> bssidInfo;
+    PsramVector<uint64_t, MEM_BSSIDS> bssidKeys;   // MAC of each bssidInfo entry, for compaction
+    Counter  overflowPackets;       // BSSIDs first seen after the table filled
     bool monitoring;
     DetectionConfig detectionConfig;
-    int currentChannelIndex;
-    unsigned long lastChannelHopTime;
+    HopScheduler hopScheduler;
+    bool surveyEnabled;
+    ChannelSurvey survey;
+    AttackFingerprinter fingerprinter;
+    TrendStore trends;
+    MacFilter allowlist;
+    MacFilter denylist;
+    uint32_t allowlistedFrames;
+    uint32_t attackFrames;
 
     // Thread-safe ring buffer for raw captures from ISR
     SemaphoreHandle_t mutex;
-    RawDeauthCapture rawRing[RAW_RING_SIZE];
+    RawDeauthCapture rawRing[Policy::RAW_RING_SIZE];
     volatile size_t rawHead;  // next write position (ISR)
     volatile size_t rawTail;  // next read position (main loop)
 
+    // Passive SSID learning for hidden networks, same single-producer scheme
+    RawSsidCapture ssidRing[Policy::SSID_RING_SIZE];
+    volatile size_t ssidHead;
+    volatile size_t ssidTail;
+    // Direct-mapped BSSID/SSID-hash cache, touched only by the WiFi task,
+    // so repeated probe responses from one AP don't refill the ring
+    struct SeenSsid { uint8_t bssid[6]; uint32_t ssidHash; };
+    SeenSsid ssidSeen[SSID_SEEN_SLOTS];
+    // Denylisted senders skip packet_threshold but get one event a second
+    // each. Direct-mapped by MAC; two senders sharing a slot only cost an
+    // extra event now and then
+    struct DeniedSender { uint64_t mac; uint32_t second; };
+    DeniedSender deniedSenders[DENIED_SENDER_SLOTS];
+
     void discoverChannels();
+    void publishSnapshot();
+    void noteChannel(int index, int channel);
     void processRawEvents();
+    void processCapture(const RawDeauthCapture& cap, int entry);
+    bool deniedSenderDue(const uint8_t* mac, uint32_t second);
+    int bssidEntry(const uint8_t* mac);
+    bool setBssidName(const uint8_t* mac, const String& ssid);
+    void processRawSsids();
+    void captureSsid(const uint8_t* bssid, const uint8_t* ies, int len, int channel);
+    void applyPromiscuousFilter();
     static void packetHandler(void* buf, wifi_promiscuous_pkt_type_t type);
     bool isProtectedSSID(const String& ssid);
+
+    static DeauthDetectorCore* instance;    // for the promiscuous callback
+};
+
+typedef DeauthDetectorCore<ActiveDetectorPolicy> DeauthDetector;
+
+// Scoped snapshot reference:
+//   SnapshotRef snap(detector);
+//   if (snap->latestSeq > seen) ...
+class SnapshotRef {
+public:
+    explicit SnapshotRef(const DeauthDetector& d) : detector(d), snapshot(d.acquireSnapshot()) {}
+    ~SnapshotRef() { detector.releaseSnapshot(snapshot); }
+    const DetectorSnapshot* operator->() const { return snapshot; }
+    const DetectorSnapshot& operator*() const { return *snapshot; }
+
+private:
+    SnapshotRef(const SnapshotRef&);
+    SnapshotRef& operator=(const SnapshotRef&);
+    const DeauthDetector& detector;
+    const DetectorSnapshot* snapshot;
 };
 
 #endif
@@ -0,0 +1,100 @@
+#ifndef DEBUG_LOG_WRITER_H
+#define DEBUG_LOG_WRITER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "SlotRing.h"
+#include "CompressedLogWriter.h"
+
+static const size_t   DEBUG_LOG_SLOTS = 64;         // power of two
+static const size_t   DEBUG_LOG_LINE = 120;         // longer messages are truncated
+static const size_t   DEBUG_LOG_BATCH = 2048;
+static const uint32_t DEBUG_LOG_DRAIN_MS = 100;
+
+enum TraceOutput : uint8_t {
+    TRACE_OUTPUT_OFF = 0,
+    TRACE_OUTPUT_SERIAL,
+    TRACE_OUTPUT_SD
+};
+
+struct DebugLogStats {
+    uint32_t queued;            // messages accepted by write()
+    uint32_t dropped;           // refused because the ring was full
+    uint32_t written;           // handed to Serial (and the file, if enabled)
+    uint32_t writeErrors;       // batches the debug file could not take
+    uint32_t traceRecords;      // trace records written out
+    uint32_t traceDropped;      // trace records lost to a full ring
+};
+
+// Debug log with deferred output.
+//
+// write() formats the message straight into a slot of a SlotRing and
+// returns; it takes no lock and never waits on Serial or the card, so any
+// task may write. A full ring drops the message and counts it rather than
+// stall the caller.
+//
+// A low-priority task wakes every DEBUG_LOG_DRAIN_MS, copies the published
+// messages into one batch and sends it to Serial and, when enabled, appends
+// it to the debug file with a single open/write/close. The same task writes
+// out the binary trace (Trace.h), so text and trace frames never interleave
+// on Serial.
+//
+// With compress set the debug file is a block-compressed log
+// (CompressedLog.h), kept open and flushed after every batch.
+//
+// Before begin() messages go to Serial directly, which only happens during
+// boot.
+class DebugLogWriter {
+public:
+    DebugLogWriter();
+
+    bool begin(const char* path, bool compress);
+    bool isRunning() const { return task != nullptr; }
+    void setFileEnabled(bool enabled) { fileEnabled.store(enabled); }
+    // Where trace records go; tracePath is truncated for TRACE_OUTPUT_SD
+    bool setTraceOutput(TraceOutput output, const char* tracePath);
+
+    bool write(uint8_t level, const char* fmt, va_list args);
+
+    // Truncates the debug file and starts it with banner
+    bool resetFile(const char* banner);
+
+    DebugLogStats getStats() const;
+
+private:
+    struct Line {
+        uint8_t level;
+        uint32_t ms;
+        char text[DEBUG_LOG_LINE];
+    };
+
+    String path;
+    String tracePath;
+    bool compress;
+    CompressedLogWriter packed;     // the debug file, when compressed
+    SlotRing<Line, DEBUG_LOG_SLOTS> ring;
+    char* batch;
+    SemaphoreHandle_t fileLock;     // debug file, vs. resetFile()
+    TaskHandle_t task;
+    std::atomic<bool> fileEnabled;
+    std::atomic<TraceOutput> traceOutput;
+    std::atomic<uint32_t> queued;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> written;
+    std::atomic<uint32_t> writeErrors;
+    std::atomic<uint32_t> traceRecords;
+    std::atomic<uint32_t> traceLost;
+
+    static void taskEntry(void* arg);
+    void run();
+    void drain();
+    void drainTrace();
+    void output(size_t len);
+    void outputTrace(size_t len);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef DETECTOR_POLICY_H
+#define DETECTOR_POLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time deployment presets for DeauthDetectorCore.
+//
+// Everything here is fixed per firmware build: ring sizes, the width of the
+// per-BSSID threshold counters, where capture timestamps come from and which
+// management subtypes count as attacks. The detector tests these with
+// if constexpr, so code a preset doesn't use is never compiled into the
+// capture callback or the drain loop. Runtime settings (thresholds, hop
+// interval, survey on/off) still come from config.txt.
+//
+// A preset is chosen with a build flag; see the envs in platformio.ini:
+//   (none)                        StandardPolicy
+//   -DDETECTOR_PRESET_LOW_MEMORY  LowMemoryPolicy
+//   -DDETECTOR_PRESET_STORM       StormPolicy
+//   -DDETECTOR_PRESET_SURVEY      SurveyPolicy
+
+// Management frame subtypes, as bits for DETECT_SUBTYPES
+static constexpr uint16_t FRAME_DISASSOC = 1u << 0x0A;
+static constexpr uint16_t FRAME_DEAUTH   = 1u << 0x0C;
+
+enum TimestampSource {
+    STAMP_PER_FRAME,    // gettimeofday() in the capture callback, for every frame
+    STAMP_PER_DRAIN     // gettimeofday() once per drain; off by at most one loop pass
+};
+
+struct StandardPolicy {
+    static constexpr const char* NAME = "standard";
+    static constexpr size_t RAW_RING_SIZE = 64;
+    static constexpr size_t SSID_RING_SIZE = 16;
+    typedef uint32_t Counter;
+    static constexpr TimestampSource TIMESTAMPS = STAMP_PER_FRAME;
+    static constexpr uint16_t DETECT_SUBTYPES = FRAME_DEAUTH;
+    static constexpr bool LEARN_SSIDS = true;   // hidden networks, from probe/assoc frames
+    static constexpr bool SURVEY = true;        // channel survey can be enabled in config
+};
+
+// Smallest footprint: short ring, 16-bit counters, no hidden-SSID learning
+// and no survey counters in the callback.
+struct LowMemoryPolicy {
+    static constexpr const char* NAME = "low-memory";
+    static constexpr size_t RAW_RING_SIZE = 32;
+    static constexpr size_t SSID_RING_SIZE = 2;     // unused
+    typedef uint16_t Counter;
+    static constexpr TimestampSource TIMESTAMPS = STAMP_PER_DRAIN;
+    static constexpr uint16_t DETECT_SUBTYPES = FRAME_DEAUTH;
+    static constexpr bool LEARN_SSIDS = false;
+    static constexpr bool SURVEY = false;
+};
+
+// Sustained floods: a deep ring to ride out slow loop passes, the cheapest
+// possible callback, and disassociation floods counted as well.
+struct StormPolicy {
+    static constexpr const char* NAME = "storm";
+    static constexpr size_t RAW_RING_SIZE = 256;
+    static constexpr size_t SSID_RING_SIZE = 16;
+    typedef uint32_t Counter;
+    static constexpr TimestampSource TIMESTAMPS = STAMP_PER_DRAIN;
+    static constexpr uint16_t DETECT_SUBTYPES = FRAME_DEAUTH | FRAME_DISASSOC;
+    static constexpr bool LEARN_SSIDS = true;
+    static constexpr bool SURVEY = false;
+};
+
+// Site surveys: the survey sees data and control frames too, so the SSID
+// ring is larger to keep up with busy channels.
+struct SurveyPolicy {
+    static constexpr const char* NAME = "survey";
+    static constexpr size_t RAW_RING_SIZE = 64;
+    static constexpr size_t SSID_RING_SIZE = 32;
+    typedef uint32_t Counter;
+    static constexpr TimestampSource TIMESTAMPS = STAMP_PER_FRAME;
+    static constexpr uint16_t DETECT_SUBTYPES = FRAME_DEAUTH | FRAME_DISASSOC;
+    static constexpr bool LEARN_SSIDS = true;
+    static constexpr bool SURVEY = true;
+};
+
+#if defined(DETECTOR_PRESET_LOW_MEMORY)
+typedef LowMemoryPolicy ActiveDetectorPolicy;
+#elif defined(DETECTOR_PRESET_STORM)
+typedef StormPolicy ActiveDetectorPolicy;
+#elif defined(DETECTOR_PRESET_SURVEY)
+typedef SurveyPolicy ActiveDetectorPolicy;
+#else
+typedef StandardPolicy ActiveDetectorPolicy;
+#endif
+
+#endif
@@ -8,7 +8,9 @@
 enum DisplayView {
     VIEW_DASHBOARD,
     VIEW_LIVE_LOG,
-    VIEW_DETAILED
+    VIEW_DETAILED,
+    VIEW_SURVEY,
+    VIEW_TRENDS
 };
 
 class Display {
@@ -20,8 +22,10 @@ public:
     void showConfigMode();
     void showMonitoring();
     void showDashboard(const std::vector<String>& ssids, DeauthDetector& detector);
-    void showLiveLog(const std::vector<DeauthEvent>& events);
+    void showLiveLog(const DeauthEvent* events, size_t count);   // newest first
     void showDetailed(const std::vector<String>& ssids, DeauthDetector& detector);
+    void showSurvey(const DeauthDetector& detector);
+    void showTrends(DeauthDetector& detector);
     void nextView();
     void nextDetailedPage(int maxIndex);
     void prevDetailedPage(int maxIndex);
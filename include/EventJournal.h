@@ -0,0 +1,112 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <atomic>
+#include "EventRing.h"
+#include "PsramAllocator.h"
+
+static const char     JOURNAL_MAGIC[4] = {'D', 'D', 'J', '1'};
+static const uint16_t JOURNAL_VERSION = 1;
+static const size_t   JOURNAL_BUFFER_SIZE = 4096;
+static const size_t   JOURNAL_BACKLOG_MAX = 1024;       // events replayed from earlier boots
+static const size_t   JOURNAL_COMPACT_BYTES = 65536;    // truncate once all is acked and past this
+static const size_t   JOURNAL_MAX_BYTES = 1048576;      // stop journaling events past this
+
+enum JournalRecordType : uint8_t {
+    JOURNAL_EVENT = 1,      // payload: DeauthEvent
+    JOURNAL_ACK,            // payload: uint64_t seq; this boot's events up to seq were delivered
+    JOURNAL_CLEAR           // no payload; every event of earlier boots was delivered
+};
+
+struct JournalHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t eventSize;     // sizeof(DeauthEvent) of the firmware that wrote it
+    uint32_t reserved[2];
+};
+
+struct JournalRecordHeader {
+    uint32_t crc;           // CRC-32 of the rest of the header and the payload
+    uint8_t  type;
+    uint8_t  reserved;
+    uint16_t boot;          // boot number, counted by the journal itself
+    uint32_t length;        // payload bytes
+};
+
+struct JournalStats {
+    bool     open;          // false without an API endpoint or a card
+    uint32_t backlog;       // events from earlier boots still to be delivered
+    uint32_t replayed;      // delivered from the backlog this boot
+    uint32_t records;       // records appended this boot
+    uint32_t writeErrors;
+    uint32_t compactions;
+    uint32_t overflow;      // events not journaled, the journal being full
+};
+
+// Write-ahead journal of events not yet acknowledged by the API.
+//
+// Append-only: every event the session writer takes is journaled, and the
+// reporter's acknowledgements are journaled as ACK records. Records carry a
+// CRC-32, so a torn write at power loss ends the journal at the last good
+// record instead of corrupting it.
+//
+// begin() reads the journal left by earlier boots. Events without a later
+// ACK (or CLEAR) form the backlog, which the main loop sends to the API
+// before new events; the journal is then rewritten to hold just that
+// backlog. Delivery is at least once: a reboot during replay sends the
+// backlog again. Once everything journaled is acknowledged and the file has
+// passed JOURNAL_COMPACT_BYTES it is truncated; while the API is out of
+// reach it grows to JOURNAL_MAX_BYTES and then stops taking events.
+//
+// Writes are buffered and go out with the session writer's group commit,
+// on its task. The backlog belongs to the main loop.
+class EventJournal {
+public:
+    EventJournal();
+
+    bool begin(const char* path);
+    bool isOpen() const { return opened; }
+
+    // Session writer task
+    void append(const DeauthEvent& event);
+    void ack(uint64_t seq);
+    void clearBacklog();
+    bool flush();
+    bool pending() const { return used > 0; }
+
+    // Main loop
+    size_t backlogSize() const { return backlog.size() - replayPos; }
+    size_t copyBacklog(DeauthEvent* out, size_t max) const;
+    // Drops count delivered events; true once the backlog is empty
+    bool consumeBacklog(size_t count);
+
+    JournalStats getStats() const;
+
+private:
+    String path;
+    File file;
+    uint8_t* buffer;
+    size_t used;
+    size_t fileBytes;
+    uint16_t boot;
+    uint64_t journaledThrough;      // highest seq journaled this boot
+    uint64_t ackedThrough;
+    bool backlogCleared;
+    bool opened;
+    PsramVector<DeauthEvent, MEM_EVENTS> backlog;
+    size_t replayPos;
+    std::atomic<uint32_t> replayed;
+    std::atomic<uint32_t> records;
+    std::atomic<uint32_t> writeErrors;
+    std::atomic<uint32_t> compactions;
+    std::atomic<uint32_t> overflow;
+
+    bool load();
+    bool rewrite();
+    void record(JournalRecordType type, const void* payload, size_t length);
+    void compactIfDone();
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <Arduino.h>
+
+static constexpr size_t EVENT_RING_CAPACITY = 2048;        // PSRAM
+static constexpr size_t EVENT_RING_FALLBACK_CAPACITY = 128; // internal RAM, no PSRAM
+static constexpr size_t EVENT_TOOL_LEN = 24;
+static constexpr size_t EVENT_MAX_CONSUMERS = 4;
+
+// Fixed-size so a slot can be overwritten in place and copied out with no
+// heap traffic. Strings longer than a field are truncated.
+struct DeauthEvent {
+    uint64_t seq;           // monotonic, first event is 1; 0 = no event
+    time_t timestamp;
+    int64_t timestamp_us;   // same instant, microseconds since the epoch
+    char target_ssid[33];
+    char target_bssid[18];
+    char attacker_mac[18];
+    int channel;
+    int rssi;
+    int packet_count;
+    int protected_index;    // matching protected_ssids entry, -1 if none
+    char tool[EVENT_TOOL_LEN];  // likely attack tool, empty if unknown
+    int tool_confidence;    // 0-100
+    bool denylisted;        // sender is on the denylist
+    uint8_t vendor;         // sender's vendor, see OuiLookup.h; 0 = unknown
+    bool randomized;        // sender MAC is locally administered
+};
+
+// Fixed-capacity event history addressed by sequence number.
+//
+// Slot for sequence s is (s - 1) % capacity. When the ring is full the oldest
+// event is overwritten; readers that fall behind find out through the
+// 'dropped' count instead of blocking the writer. Not thread-safe on its own;
+// DeauthDetector guards it with its mutex.
+//
+// Consumers (logger, alerts, reporter...) each own a cursor: read() hands
+// out events past the read position, ack() marks everything read so far as
+// done, and rewind() returns to the last ack so a failed delivery is retried.
+// Retention is still bounded by capacity; a consumer that falls more than a
+// ring behind has the overwritten events added to its lost count.
+class EventRing {
+public:
+    EventRing();
+    ~EventRing();
+    bool begin(size_t capacity = EVENT_RING_CAPACITY);
+
+    // Stores a copy of event, assigns and returns its sequence number
+    uint64_t push(const DeauthEvent& event);
+
+    // Copies up to max events with seq >= since, oldest first. 'dropped' gets
+    // the number of requested events that were already overwritten.
+    size_t readSince(uint64_t since, DeauthEvent* out, size_t max, uint64_t* dropped = nullptr) const;
+
+    // Copies the newest max events, newest first
+    size_t readLatest(DeauthEvent* out, size_t max) const;
+
+    // nullptr if seq was never written or has been overwritten
+    const DeauthEvent* find(uint64_t seq) const;
+
+    // Per-consumer cursors, consumer < EVENT_MAX_CONSUMERS. read() with
+    // out == nullptr consumes without copying.
+    size_t read(size_t consumer, DeauthEvent* out, size_t max);
+    void ack(size_t consumer);
+    void rewind(size_t consumer);
+    uint64_t pending(size_t consumer) const;    // read or not, but not acked
+    uint64_t lost(size_t consumer) const { return cursors[consumer].lost; }
+
+    uint64_t oldestSeq() const { return nextSequence - count; }
+    uint64_t latestSeq() const { return nextSequence - 1; }
+    uint64_t nextSeq() const { return nextSequence; }
+    uint64_t overwritten() const { return overwrittenTotal; }
+    size_t size() const { return count; }
+    size_t capacity() const { return slotCount; }
+    bool inPsram() const { return psram; }
+
+private:
+    DeauthEvent* slots;
+    size_t slotCount;
+    size_t count;
+    uint64_t nextSequence;
+    uint64_t overwrittenTotal;
+    bool psram;
+
+    struct Cursor {
+        uint64_t next;      // next seq to hand out
+        uint64_t acked;     // last seq acknowledged, 0 = none
+        uint64_t lost;      // overwritten before this consumer read them
+    };
+    Cursor cursors[EVENT_MAX_CONSUMERS];
+
+    const DeauthEvent& at(uint64_t seq) const { return slots[(seq - 1) % slotCount]; }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HOP_SCHEDULER_H
+#define HOP_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Round-robin channel hop schedule used by DeauthDetector::updateChannelHop().
+//
+// Kept free of Arduino and ESP-IDF dependencies so the host-side coverage
+// simulator (tools/hopsim) drives exactly the same decisions as the firmware.
+// The caller supplies the clock and owns the channel list; the scheduler only
+// tracks which entry is tuned and when it was tuned.
+struct HopStep {
+    bool          hop;       // true if the radio should retune now
+    size_t        from;      // index that was tuned until now
+    size_t        to;        // index to tune next
+    unsigned long dwellMs;   // how long 'from' was tuned
+};
+
+class HopScheduler {
+public:
+    HopScheduler() : index(0), lastHop(0) {}
+
+    void reset(unsigned long now) {
+        index = 0;
+        lastHop = now;
+    }
+
+    size_t current() const { return index; }
+
+    // Called once per main-loop pass. A hop happens on the first pass at or
+    // after the interval, so loop latency adds directly to dwell time.
+    HopStep poll(unsigned long now, size_t channelCount, unsigned long intervalMs) {
+        HopStep step = { false, index, index, now - lastHop };
+        if (channelCount == 0 || now - lastHop < intervalMs) {
+            return step;
+        }
+        index = (index + 1) % channelCount;
+        lastHop = now;
+        step.hop = true;
+        step.to = index;
+        return step;
+    }
+
+private:
+    size_t        index;
+    unsigned long lastHop;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef LIFETIME_STATS_H
+#define LIFETIME_STATS_H
+
+#include <Arduino.h>
+#include <vector>
+#include "EventRing.h"
+#include "APIReporter.h"
+#include "DeauthDetector.h"
+
+static const size_t   LIFETIME_SSIDS = 8;               // protected_ssids entries counted by name
+static const size_t   LIFETIME_SLOTS = 4;               // NVS records written in turn
+static const uint32_t LIFETIME_COMMIT_MS = 600000;      // commit at least this often
+static const uint32_t LIFETIME_MIN_COMMIT_MS = 60000;   // ...and never more often than this
+static const uint32_t LIFETIME_COMMIT_EVENTS = 256;     // events that make a commit due early
+static const uint32_t LIFETIME_INCIDENT_GAP = 300;      // seconds without events that end an incident
+
+struct LifetimeSsid {
+    char     name[33];          // protected_ssids entry, empty = free
+    uint32_t events;
+    uint32_t incidents;
+    uint64_t frames;
+};
+
+// Totals across every boot of this sensor
+struct LifetimeCounters {
+    uint32_t boots;
+    uint64_t uptimeSeconds;     // monitor and config mode
+    uint32_t events;
+    uint32_t incidents;         // runs of events against one protected entry
+    uint64_t frames;            // attack frames, including ones past the threshold
+    uint32_t denylistedEvents;
+    uint64_t allowlistedFrames;
+    uint32_t droppedEvents;     // overwritten before the session log got them
+    uint32_t reportsSent;       // API batches accepted
+    uint32_t reportsRejected;   // batches the server refused (dropped)
+    uint32_t reportsFailed;     // attempts that couldn't reach the server
+    uint32_t eventsReported;
+    LifetimeSsid ssids[LIFETIME_SSIDS];
+};
+
+struct LifetimeStatus {
+    bool     loaded;            // a record was found at boot
+    uint32_t commits;           // this boot
+    uint32_t commitErrors;
+    uint32_t record;            // sequence number of the last record written
+};
+
+// Lifetime counters, kept in RAM and committed to NVS (Preferences) in
+// batches.
+//
+// Everything is updated from the main loop, which also serves the web
+// portal, so there is no locking. A commit is due LIFETIME_COMMIT_MS after
+// the last one, or LIFETIME_MIN_COMMIT_MS after it once
+// LIFETIME_COMMIT_EVENTS events have come in; entering config mode commits
+// at once. That bounds flash writes to one per minute under attack and six
+// an hour otherwise.
+//
+// Each commit writes the whole record, with a sequence number and CRC-32,
+// to the next of LIFETIME_SLOTS keys in turn. begin() loads the newest
+// record that checks out, so a commit cut short by a power loss costs at
+// most what changed since the previous one. NVS spreads the writes over
+// its pages itself; the rotation keeps any one key from being rewritten
+// on every commit.
+class LifetimeStats {
+public:
+    LifetimeStats();
+
+    // Loads the newest record and counts this boot
+    void begin();
+    // Gives each protected_ssids entry its slot, by name, once the
+    // configuration is loaded
+    void setProtected(const std::vector<String>& entries);
+    // Uptime, frames (from the detector's since-boot counts) and the
+    // commit schedule; call once per loop pass
+    void tick(const DeauthDetector& detector);
+    // Writes the record now if anything changed since the last commit
+    bool commit();
+
+    void recordEvent(const DeauthEvent& event);
+    void recordDropped(uint64_t count);
+    void recordReport(ReportResult result, size_t events);
+
+    const LifetimeCounters& counters() const { return data; }
+    // Totals for a protected_ssids position, nullptr if it has no slot
+    const LifetimeSsid* ssid(size_t index) const;
+    LifetimeStatus status() const;
+
+private:
+    struct Record {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t seq;
+        LifetimeCounters counters;
+        uint32_t crc;           // of everything before it
+    };
+
+    LifetimeCounters data;
+    uint32_t seq;
+    bool loaded;
+    bool dirty;
+    uint32_t pendingEvents;     // since the last commit
+    uint32_t lastCommitMs;
+    uint32_t lastTickMs;
+    uint32_t uptimeRemainderMs;
+    uint32_t allowlistedSeen;
+    uint32_t framesSeen;
+    bool ssidFramesDue;
+    std::vector<uint32_t> ssidFramesSeen;   // by protected_ssids position
+    std::vector<int> slots;             // protected_ssids position -> data.ssids index, -1 if none
+    std::vector<uint32_t> lastEventAt;  // by protected_index + 1; 0 = no incident this boot
+    uint32_t commits;
+    uint32_t commitErrors;
+};
+
+extern LifetimeStats lifetimeStats;
+
+#endif
@@ -4,33 +4,68 @@
 #include <SD.h>
 #include "DeauthDetector.h"
 #include "Config.h"
+#include "SessionWriter.h"
+#include "DebugLogWriter.h"
+
+// Debug log levels. Messages below DEBUG_LOG_MIN_LEVEL are compiled out,
+// arguments included; set it with a build flag, e.g.
+// -DDEBUG_LOG_MIN_LEVEL=LOG_LEVEL_WARN
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef DEBUG_LOG_MIN_LEVEL
+#define DEBUG_LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_AT(level, ...) \
+    do { if ((level) >= DEBUG_LOG_MIN_LEVEL) logger.log((level), __VA_ARGS__); } while (0)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
 
 class Logger {
 public:
     Logger();
     bool begin();
     void setConfig(AppConfig* cfg);
+    // Queues the event for the session writer; false if its queue is full
     bool logEvent(const DeauthEvent& event);
-    String getCurrentSessionFile() { return sessionFile; }
+    // How many of 'wanted' events logEvent() can take right now
+    size_t admitEvents(size_t wanted) { return session.admit(wanted); }
+    // Writes out everything queued, e.g. before the log is served or the device restarts
+    bool syncSession() { return session.sync(); }
+    SessionWriterStats getSessionStats() const { return session.getStats(); }
+    // Current segment of the session log; see SessionWriter
+    String getCurrentSessionFile() { return session.currentPath(session.csvExtension()); }
+    String getCurrentBinaryFile() { return session.currentPath(".ddb"); }
+    SessionWriter& getSession() { return session; }
+    // Write-ahead journal of unreported events; see EventJournal
+    void journalAck(uint64_t seq) { session.journalAck(seq); }
+    size_t journalBacklog() const { return session.journalBacklog(); }
+    size_t copyJournalBacklog(DeauthEvent* out, size_t max) const { return session.copyJournalBacklog(out, max); }
+    void consumeJournalBacklog(size_t count) { session.consumeJournalBacklog(count); }
+    JournalStats getJournalStats() const { return session.getJournalStats(); }
     String getDebugLogFile() { return debugFile; }
     
-    // Debug logging methods - always writes to Serial, optionally to file
-    void debugPrint(const char* msg);
-    void debugPrint(const String& msg);
-    void debugPrintln(const char* msg);
-    void debugPrintln(const String& msg);
-    void debugPrintln();
+    // printf-style debug message, one line; use the LOG_* macros so that
+    // filtered levels cost nothing. Queued for Serial and, if debug is
+    // enabled, the debug file; see DebugLogWriter
+    void log(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+    DebugLogStats getDebugStats() const { return debug.getStats(); }
     
     // Clear the debug log file
     bool clearDebugLog();
 
 private:
-    String sessionFile;
     String debugFile;
     AppConfig* config;
+    SessionWriter session;
+    DebugLogWriter debug;
     bool createSessionFile();
     bool createDebugFile();
-    void writeToDebugFile(const char* msg, bool newline = false);
 };
 
 // Global logger instance - use extern in other files
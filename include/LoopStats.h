@@ -0,0 +1,25 @@
+#ifndef LOOP_STATS_H
+#define LOOP_STATS_H
+
+#include <stdint.h>
+
+// Timing of monitor-mode loop passes, kept by main.cpp and shown in /status.
+// Passes that stopped monitoring to report over WiFi are left out; they
+// take seconds by design and would hide the stalls this is meant to catch.
+struct LoopStats {
+    uint32_t passes;
+    uint32_t maxUs;         // slowest pass
+    uint64_t totalUs;
+    uint32_t logMaxUs;      // slowest hand-over of events to the logger
+
+    void record(uint32_t us) {
+        passes++;
+        totalUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+    uint32_t averageUs() const { return passes ? (uint32_t)(totalUs / passes) : 0; }
+};
+
+extern LoopStats loopStats;
+
+#endif
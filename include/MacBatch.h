@@ -0,0 +1,179 @@
+#ifndef MAC_BATCH_H
+#define MAC_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Batch kernels for DeauthDetector::processRawEvents().
+//
+// Drained captures are split into structure-of-arrays MAC columns so hashing
+// and duplicate detection run over a whole batch with no per-lane branches. On
+// the host these compile to SSE2, four lanes per instruction; on the ESP32
+// the scalar loops are branch-free and unrolled by the compiler. Kept free
+// of Arduino and ESP-IDF dependencies so tools/macbench measures exactly
+// this code.
+static constexpr size_t MAC_BATCH_MAX = 16;
+
+// Lane i holds one MAC: bytes 0-3 in hi[i], bytes 4-5 in the low half of lo[i]
+struct MacColumn {
+    uint32_t hi[MAC_BATCH_MAX];
+    uint32_t lo[MAC_BATCH_MAX];
+};
+
+inline void macSplit(const uint8_t* mac, uint32_t& hi, uint32_t& lo) {
+    hi = ((uint32_t)mac[0] << 24) | ((uint32_t)mac[1] << 16) | ((uint32_t)mac[2] << 8) | mac[3];
+    lo = ((uint32_t)mac[4] << 8) | mac[5];
+}
+
+// Thomas Wang's shift/add integer hash. No 32-bit multiply, which SSE2
+// lacks, and good enough avalanche for a 50%-load probe table.
+inline uint32_t macHash(uint32_t hi, uint32_t lo) {
+    uint32_t k = hi ^ (lo << 16) ^ lo;
+    k = ~k + (k << 15);
+    k = k ^ (k >> 12);
+    k = k + (k << 2);
+    k = k ^ (k >> 4);
+    k = k + (k << 3) + (k << 11);
+    return k ^ (k >> 16);
+}
+
+inline void macHashBatchScalar(const MacColumn& c, size_t n, uint32_t* out) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = macHash(c.hi[i], c.lo[i]);
+    }
+}
+
+// Bit i set if lane i repeats lane i-1. Deauth floods arrive as long runs
+// from one BSSID, so this finds the duplicates in one linear pass.
+inline uint32_t macRepeatMaskScalar(const MacColumn& c, size_t n) {
+    uint32_t mask = 0;
+    for (size_t i = 1; i < n; i++) {
+        mask |= (uint32_t)((c.hi[i] == c.hi[i - 1]) & (c.lo[i] == c.lo[i - 1])) << i;
+    }
+    return mask;
+}
+
+#if defined(__SSE2__)
+inline void macHashBatchSse2(const MacColumn& c, size_t n, uint32_t* out) {
+    const __m128i ones = _mm_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i hi = _mm_loadu_si128((const __m128i*)(c.hi + i));
+        __m128i lo = _mm_loadu_si128((const __m128i*)(c.lo + i));
+        __m128i k = _mm_xor_si128(hi, _mm_xor_si128(_mm_slli_epi32(lo, 16), lo));
+        k = _mm_add_epi32(_mm_xor_si128(k, ones), _mm_slli_epi32(k, 15));
+        k = _mm_xor_si128(k, _mm_srli_epi32(k, 12));
+        k = _mm_add_epi32(k, _mm_slli_epi32(k, 2));
+        k = _mm_xor_si128(k, _mm_srli_epi32(k, 4));
+        k = _mm_add_epi32(k, _mm_add_epi32(_mm_slli_epi32(k, 3), _mm_slli_epi32(k, 11)));
+        k = _mm_xor_si128(k, _mm_srli_epi32(k, 16));
+        _mm_storeu_si128((__m128i*)(out + i), k);
+    }
+    for (; i < n; i++) {
+        out[i] = macHash(c.hi[i], c.lo[i]);
+    }
+}
+
+inline uint32_t macRepeatMaskSse2(const MacColumn& c, size_t n) {
+    uint32_t mask = 0;
+    size_t i = 1;
+    for (; i + 4 <= n; i += 4) {
+        __m128i eh = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(c.hi + i)),
+                                     _mm_loadu_si128((const __m128i*)(c.hi + i - 1)));
+        __m128i el = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(c.lo + i)),
+                                     _mm_loadu_si128((const __m128i*)(c.lo + i - 1)));
+        mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(eh, el))) << i;
+    }
+    for (; i < n; i++) {
+        mask |= (uint32_t)((c.hi[i] == c.hi[i - 1]) & (c.lo[i] == c.lo[i - 1])) << i;
+    }
+    return mask;
+}
+#endif
+
+inline void macHashBatch(const MacColumn& c, size_t n, uint32_t* out) {
+#if defined(__SSE2__)
+    macHashBatchSse2(c, n, out);
+#else
+    macHashBatchScalar(c, n, out);
+#endif
+}
+
+inline uint32_t macRepeatMask(const MacColumn& c, size_t n) {
+#if defined(__SSE2__)
+    return macRepeatMaskSse2(c, n);
+#else
+    return macRepeatMaskScalar(c, n);
+#endif
+}
+
+// BSSID -> small integer, open addressing at <= 50% load. Keys are stored
+// as columns too, so a probe reads 8 bytes of key per slot.
+class BssidTable {
+public:
+    static constexpr size_t SLOTS = 1024;
+    static constexpr size_t CAPACITY = SLOTS / 2;
+    static constexpr int NOT_FOUND = -1;
+
+    BssidTable() { clear(); }
+
+    void clear() {
+        memset(keyLo, 0, sizeof(keyLo));
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+    int find(uint32_t hash, uint32_t hi, uint32_t lo) const {
+        for (size_t s = hash & (SLOTS - 1); keyLo[s] & USED; s = (s + 1) & (SLOTS - 1)) {
+            if (keyHi[s] == hi && keyLo[s] == (lo | USED)) {
+                return value[s];
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    // Returns the value now stored for the key (the existing one if it was
+    // already present), or NOT_FOUND when the table is full
+    int insert(uint32_t hash, uint32_t hi, uint32_t lo, uint16_t v) {
+        size_t s = hash & (SLOTS - 1);
+        for (; keyLo[s] & USED; s = (s + 1) & (SLOTS - 1)) {
+            if (keyHi[s] == hi && keyLo[s] == (lo | USED)) {
+                return value[s];
+            }
+        }
+        if (count >= CAPACITY) {
+            return NOT_FOUND;
+        }
+        keyHi[s] = hi;
+        keyLo[s] = lo | USED;
+        value[s] = v;
+        count++;
+        return v;
+    }
+
+    // Resolves every lane, probing once per run of identical MACs: a flood
+    // from one BSSID costs one probe per batch, not per frame. The kernel
+    // can be swapped so tools/macbench can compare implementations.
+    template <uint32_t (*RepeatMask)(const MacColumn&, size_t) = macRepeatMask>
+    void findBatch(const MacColumn& c, size_t n, const uint32_t* hashes, int* out) const {
+        uint32_t repeat = RepeatMask(c, n);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = (repeat >> i) & 1 ? out[i - 1] : find(hashes[i], c.hi[i], c.lo[i]);
+        }
+    }
+
+private:
+    static constexpr uint32_t USED = 1u << 16;
+
+    uint32_t keyHi[SLOTS];
+    uint32_t keyLo[SLOTS];
+    uint16_t value[SLOTS];
+    size_t count;
+};
+
+#endif
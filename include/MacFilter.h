@@ -0,0 +1,63 @@
+#ifndef MAC_FILTER_H
+#define MAC_FILTER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "PsramAllocator.h"
+
+// Set of MAC addresses loaded from a text file on the SD card, one address
+// per line (AA:BB:CC:DD:EE:FF or AA-BB-..., '#' starts a comment).
+//
+// contains() is meant for the promiscuous callback: a Bloom filter rejects
+// almost every address in four bit tests, and only likely members go on to
+// the exact open-addressed table. No allocation, no locks. The set must not
+// be reloaded while monitoring is running.
+class MacFilter {
+public:
+    MacFilter();
+    bool load(const char* path);    // false if missing or empty; the set is cleared either way
+    void clear();
+    size_t size() const { return count; }
+
+    inline bool contains(const uint8_t* mac) const {
+        if (count == 0) return false;
+        uint64_t k = key(mac);
+        uint64_t h = mix(k);
+        uint32_t h1 = (uint32_t)h;
+        uint32_t h2 = (uint32_t)(h >> 32) | 1;
+        for (int i = 0; i < BLOOM_HASHES; i++) {
+            uint32_t bit = (h1 + i * h2) & bloomMask;
+            if (!(bloom[bit >> 5] & (1UL << (bit & 31)))) return false;
+        }
+        for (size_t slot = h & tableMask; table[slot] != 0; slot = (slot + 1) & tableMask) {
+            if (table[slot] == (k | PRESENT)) return true;
+        }
+        return false;
+    }
+
+    static bool parseMac(const char* text, uint8_t* mac);
+
+private:
+    static constexpr int BLOOM_HASHES = 4;
+    static constexpr uint64_t PRESENT = 1ULL << 48;    // marks a used slot, so 00:00:.. can be stored
+
+    PsramVector<uint32_t, MEM_MACLISTS> bloom;
+    uint32_t bloomMask;
+    PsramVector<uint64_t, MEM_MACLISTS> table;
+    size_t tableMask;
+    size_t count;
+
+    static inline uint64_t key(const uint8_t* mac) {
+        return ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) |
+               ((uint64_t)mac[3] << 16) | ((uint64_t)mac[4] << 8) | mac[5];
+    }
+    // splitmix64 finalizer
+    static inline uint64_t mix(uint64_t x) {
+        x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+    void build(const std::vector<uint64_t>& keys);
+};
+
+#endif
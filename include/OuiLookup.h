@@ -0,0 +1,23 @@
+#ifndef OUI_LOOKUP_H
+#define OUI_LOOKUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Vendor of a MAC address from its OUI (first three bytes), by binary
+// search over a sorted table in flash. No heap, no locks; safe from any task.
+static constexpr uint8_t OUI_UNKNOWN = 0;
+
+// Vendor index for use with ouiVendorName(), OUI_UNKNOWN if the OUI isn't
+// in the table or the address is randomized
+uint8_t ouiLookup(const uint8_t* mac);
+const char* ouiVendorName(uint8_t vendor);     // "" for OUI_UNKNOWN
+
+// Locally administered bit: set by phones and laptops that randomize their
+// MAC, and by attack tools spoofing a made-up sender. Such addresses have
+// no vendor.
+inline bool macIsRandomized(const uint8_t* mac) {
+    return (mac[0] & 0x02) != 0;
+}
+
+#endif
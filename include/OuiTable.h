@@ -0,0 +1,90 @@
+#ifndef OUI_TABLE_H
+#define OUI_TABLE_H
+
+#include <stdint.h>
+
+// Generated by tools/ouigen from the IEEE MA-L registry for the vendors in
+// tools/ouigen/vendors.txt. Do not edit by hand. Included only by
+// OuiLookup.cpp; both arrays live in flash.
+//
+// Source: oui-subset.csv, 192 assignments
+
+static constexpr const char* const OUI_VENDORS[] = {
+    "",
+    "Espressif",
+    "Raspberry Pi",
+    "Hak5",
+    "Alfa",
+    "Realtek",
+    "Ralink",
+    "MediaTek",
+    "Atheros",
+    "Microchip",
+    "Cisco Meraki",
+    "Cisco",
+    "Ubiquiti",
+    "Aruba",
+    "TP-Link",
+    "Netgear",
+    "Apple",
+    "Samsung",
+    "Intel",
+    "Google",
+    "Amazon",
+    "Huawei",
+    "Xiaomi",
+};
+
+// (oui << 8) | index into OUI_VENDORS, ascending
+static constexpr uint32_t OUI_TABLE[] = {
+    0x00037Fu << 8 |  8, 0x000393u << 8 | 16, 0x0004A3u << 8 |  9, 0x00095Bu << 8 | 15,
+    0x000A95u << 8 | 16, 0x000B85u << 8 | 11, 0x000B86u << 8 | 13, 0x000C43u << 8 |  6,
+    0x000CE7u << 8 |  7, 0x0012FBu << 8 | 17, 0x001337u << 8 |  3, 0x00146Cu << 8 | 15,
+    0x001500u << 8 | 18, 0x00156Du << 8 | 12, 0x001632u << 8 | 17, 0x00180Au << 8 | 10,
+    0x001882u << 8 | 21, 0x001A11u << 8 | 19, 0x001A1Eu << 8 | 13, 0x001AA1u << 8 | 11,
+    0x001B21u << 8 | 18, 0x001B2Fu << 8 | 15, 0x001B63u << 8 | 16, 0x001D25u << 8 | 17,
+    0x001E2Au << 8 | 15, 0x001E64u << 8 | 18, 0x001EC2u << 8 | 16, 0x00216Au << 8 | 18,
+    0x00223Fu << 8 | 15, 0x00246Cu << 8 | 13, 0x0024B2u << 8 | 15, 0x002500u << 8 | 16,
+    0x00259Eu << 8 | 21, 0x002722u << 8 | 12, 0x004096u << 8 | 11, 0x00C0CAu << 8 |  4,
+    0x00E04Cu << 8 |  5, 0x00E0FCu << 8 | 21, 0x0418D6u << 8 | 12, 0x083AF2u << 8 |  1,
+    0x0C47C9u << 8 | 20, 0x0C8DDBu << 8 | 10, 0x0CDC7Eu << 8 |  1, 0x10061Cu << 8 |  1,
+    0x10521Cu << 8 |  1, 0x14CC20u << 8 | 14, 0x14EBB6u << 8 | 14, 0x186472u << 8 | 13,
+    0x18FE34u << 8 |  1, 0x1C9DC2u << 8 |  1, 0x204C03u << 8 | 13, 0x204E7Fu << 8 | 15,
+    0x240AC4u << 8 |  1, 0x2462ABu << 8 |  1, 0x246F28u << 8 |  1, 0x24A43Cu << 8 | 12,
+    0x24D7EBu << 8 |  1, 0x24DCC3u << 8 |  1, 0x24DEC6u << 8 | 13, 0x286C07u << 8 | 22,
+    0x286ED4u << 8 | 21, 0x28CDC1u << 8 |  2, 0x28CFE9u << 8 | 16, 0x2CB05Du << 8 | 15,
+    0x2CCF67u << 8 |  2, 0x2CF432u << 8 |  1, 0x3030F9u << 8 |  1, 0x30AEA4u << 8 |  1,
+    0x30C6F7u << 8 |  1, 0x348518u << 8 |  1, 0x34865Du << 8 |  1, 0x34CE00u << 8 | 22,
+    0x3C0754u << 8 | 16, 0x3C5AB4u << 8 | 19, 0x3C6105u << 8 |  1, 0x3C71BFu << 8 |  1,
+    0x3CA9F4u << 8 | 18, 0x4022D8u << 8 |  1, 0x409151u << 8 |  1, 0x40A6D9u << 8 | 16,
+    0x40F520u << 8 |  1, 0x441793u << 8 |  1, 0x44650Du << 8 | 20, 0x44D9E7u << 8 | 12,
+    0x4827E2u << 8 |  1, 0x483FDAu << 8 |  1, 0x4846FBu << 8 | 21, 0x48E729u << 8 |  1,
+    0x4C11AEu << 8 |  1, 0x50C7BFu << 8 | 14, 0x543204u << 8 |  1, 0x546009u << 8 | 19,
+    0x58BF25u << 8 |  1, 0x5C0A5Bu << 8 | 17, 0x5CCF7Fu << 8 |  1, 0x600194u << 8 |  1,
+    0x60E327u << 8 | 14, 0x640980u << 8 | 22, 0x647002u << 8 | 14, 0x64B473u << 8 | 22,
+    0x64E833u << 8 |  1, 0x6837E9u << 8 | 20, 0x687251u << 8 | 12, 0x68C63Au << 8 |  1,
+    0x6CF37Fu << 8 | 13, 0x70039Fu << 8 |  1, 0x7483C2u << 8 | 12, 0x74C246u << 8 | 20,
+    0x7811DCu << 8 | 22, 0x782184u << 8 |  1, 0x788A20u << 8 | 12, 0x7C5CF8u << 8 | 18,
+    0x7C87CEu << 8 |  1, 0x7C9EBDu << 8 |  1, 0x7CD1C3u << 8 | 16, 0x7CDFA1u << 8 |  1,
+    0x802AA8u << 8 | 12, 0x80646Fu << 8 |  1, 0x807D3Au << 8 |  1, 0x8086F2u << 8 | 18,
+    0x840D8Eu << 8 |  1, 0x84CCA8u << 8 |  1, 0x84F3EBu << 8 |  1, 0x881544u << 8 | 10,
+    0x8C7712u << 8 | 17, 0x8CAAB5u << 8 |  1, 0x90F652u << 8 | 14, 0x943CC6u << 8 |  1,
+    0x94B40Fu << 8 | 13, 0x94B97Eu << 8 |  1, 0x94E686u << 8 |  1, 0x98DED0u << 8 | 14,
+    0x98F4ABu << 8 |  1, 0x9C0298u << 8 | 17, 0x9C3DCFu << 8 | 15, 0xA020A6u << 8 |  1,
+    0xA021B7u << 8 | 15, 0xA0F3C1u << 8 | 14, 0xA434D9u << 8 | 18, 0xA4B197u << 8 | 16,
+    0xA4CF12u << 8 |  1, 0xA8032Au << 8 |  1, 0xAC17C8u << 8 | 10, 0xAC67B2u << 8 |  1,
+    0xACA31Eu << 8 | 13, 0xACBC32u << 8 | 16, 0xB0487Au << 8 | 14, 0xB4E62Du << 8 |  1,
+    0xB4FBE4u << 8 | 12, 0xB827EBu << 8 |  2, 0xB8D61Au << 8 |  1, 0xBCDDC2u << 8 |  1,
+    0xC03F0Eu << 8 | 15, 0xC04A00u << 8 | 14, 0xC44F33u << 8 |  1, 0xC46E1Fu << 8 | 14,
+    0xC82B96u << 8 |  1, 0xC8C9A3u << 8 |  1, 0xCC07ABu << 8 | 17, 0xCC50E3u << 8 |  1,
+    0xD0034Bu << 8 | 16, 0xD80D17u << 8 | 14, 0xD83ADDu << 8 |  2, 0xD88039u << 8 |  9,
+    0xD8A01Du << 8 |  1, 0xD8BFC0u << 8 |  1, 0xD8C7C8u << 8 | 13, 0xDC4F22u << 8 |  1,
+    0xDC5475u << 8 |  1, 0xDCA632u << 8 |  2, 0xE0553Du << 8 | 10, 0xE063DAu << 8 | 12,
+    0xE09806u << 8 |  1, 0xE45F01u << 8 |  2, 0xE868E7u << 8 |  1, 0xE894F6u << 8 | 14,
+    0xE89F6Du << 8 |  1, 0xE8DB84u << 8 |  1, 0xEC086Bu << 8 | 14, 0xECFABCu << 8 |  1,
+    0xF01898u << 8 | 16, 0xF0272Du << 8 | 20, 0xF09FC2u << 8 | 12, 0xF412FAu << 8 |  1,
+    0xF45C89u << 8 | 16, 0xF4CFA2u << 8 |  1, 0xF4F26Du << 8 | 14, 0xF4F5D8u << 8 | 19,
+    0xF4F5E8u << 8 | 19, 0xF8A45Fu << 8 | 22, 0xFC65DEu << 8 | 20, 0xFCECDAu << 8 | 12,
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef PCAP_FORMAT_H
+#define PCAP_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// pcapng blocks for captured 802.11 frames, little-endian.
+//
+// A file is a Section Header Block and one Interface Description Block
+// (link type 127, 802.11 with a radiotap header, microsecond timestamps),
+// then one Enhanced Packet Block per frame. Each frame gets a radiotap
+// header with the TSFT, flags (FCS at the end), channel and signal fields,
+// which is what Wireshark needs to show the channel and RSSI columns.
+//
+// No Arduino dependencies, so the format can be checked on the host.
+
+static const uint32_t PCAP_BLOCK_SHB = 0x0A0D0D0A;
+static const uint32_t PCAP_BLOCK_IDB = 0x00000001;
+static const uint32_t PCAP_BLOCK_EPB = 0x00000006;
+static const uint32_t PCAP_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+static const uint16_t PCAP_LINKTYPE_RADIOTAP = 127;
+
+// Radiotap: version, pad, length, present bitmap; TSFT (8, aligned), flags
+// (1), pad (1), channel frequency and flags (2 + 2), antenna signal (1), pad
+static const size_t   PCAP_RADIOTAP_LEN = 24;
+static const uint32_t PCAP_RADIOTAP_PRESENT = (1u << 0) | (1u << 1) | (1u << 3) | (1u << 5);
+static const uint8_t  PCAP_RADIOTAP_FLAG_FCS = 0x10;
+static const uint16_t PCAP_RADIOTAP_CHAN_2GHZ = 0x0080;
+
+// Block header, EPB fields and trailing length around the packet data
+static const size_t PCAP_EPB_OVERHEAD = 32;
+
+// SHB (28 with no options) + IDB (20 with no options)
+static const size_t PCAP_FILE_HEADER_LEN = 48;
+
+inline void pcapPut16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+inline void pcapPut32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+inline size_t pcapPad4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+// Bytes pcapPacket() writes for a frame of captured length len
+inline size_t pcapPacketLen(size_t len) {
+    return PCAP_EPB_OVERHEAD + pcapPad4(PCAP_RADIOTAP_LEN + len);
+}
+
+inline uint16_t pcapChannelMhz(uint8_t channel) {
+    return channel == 14 ? 2484 : 2407 + 5 * channel;
+}
+
+// Section and interface headers that start every file; returns
+// PCAP_FILE_HEADER_LEN
+inline size_t pcapFileHeader(uint8_t* out, uint32_t snapLen) {
+    uint8_t* p = out;
+    pcapPut32(p, PCAP_BLOCK_SHB);
+    pcapPut32(p + 4, 28);
+    pcapPut32(p + 8, PCAP_BYTE_ORDER_MAGIC);
+    pcapPut16(p + 12, 1);                   // version 1.0
+    pcapPut16(p + 14, 0);
+    pcapPut32(p + 16, 0xFFFFFFFF);          // section length unknown
+    pcapPut32(p + 20, 0xFFFFFFFF);
+    pcapPut32(p + 24, 28);
+    p += 28;
+
+    pcapPut32(p, PCAP_BLOCK_IDB);
+    pcapPut32(p + 4, 20);
+    pcapPut16(p + 8, PCAP_LINKTYPE_RADIOTAP);
+    pcapPut16(p + 10, 0);
+    pcapPut32(p + 12, PCAP_RADIOTAP_LEN + snapLen);
+    pcapPut32(p + 16, 20);
+    return PCAP_FILE_HEADER_LEN;
+}
+
+// One Enhanced Packet Block: timeUs is Unix time in microseconds, frame the
+// first len bytes of an origLen-byte frame as received, FCS included
+inline size_t pcapPacket(uint8_t* out, int64_t timeUs, uint8_t channel, int8_t rssi,
+                         const uint8_t* frame, uint16_t len, uint16_t origLen) {
+    size_t total = pcapPacketLen(len);
+    uint64_t ts = (uint64_t)timeUs;
+    uint8_t* p = out;
+    pcapPut32(p, PCAP_BLOCK_EPB);
+    pcapPut32(p + 4, (uint32_t)total);
+    pcapPut32(p + 8, 0);                    // interface 0
+    pcapPut32(p + 12, (uint32_t)(ts >> 32));
+    pcapPut32(p + 16, (uint32_t)ts);
+    pcapPut32(p + 20, (uint32_t)(PCAP_RADIOTAP_LEN + len));
+    pcapPut32(p + 24, (uint32_t)(PCAP_RADIOTAP_LEN + origLen));
+    p += 28;
+
+    uint8_t* rt = p;
+    memset(rt, 0, PCAP_RADIOTAP_LEN);
+    pcapPut16(rt + 2, PCAP_RADIOTAP_LEN);
+    pcapPut32(rt + 4, PCAP_RADIOTAP_PRESENT);
+    pcapPut32(rt + 8, (uint32_t)ts);        // TSFT: the receive time is the closest we have
+    pcapPut32(rt + 12, (uint32_t)(ts >> 32));
+    rt[16] = PCAP_RADIOTAP_FLAG_FCS;
+    pcapPut16(rt + 18, pcapChannelMhz(channel));
+    pcapPut16(rt + 20, PCAP_RADIOTAP_CHAN_2GHZ);
+    rt[22] = (uint8_t)rssi;
+    memcpy(p + PCAP_RADIOTAP_LEN, frame, len);
+
+    size_t data = PCAP_RADIOTAP_LEN + len;
+    memset(p + data, 0, pcapPad4(data) - data);
+    pcapPut32(out + total - 4, (uint32_t)total);
+    return total;
+}
+
+#endif
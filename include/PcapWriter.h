@@ -0,0 +1,100 @@
+#ifndef PCAP_WRITER_H
+#define PCAP_WRITER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <atomic>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "PcapFormat.h"
+#include "SlotRing.h"
+
+static const size_t   PCAP_SLOTS = 64;              // power of two
+static const size_t   PCAP_SNAP_LEN = 128;          // longer frames are cut; deauths are ~30 bytes
+static const size_t   PCAP_BATCH = 8192;
+static const uint32_t PCAP_DRAIN_MS = 200;
+
+// 0 turns a limit off
+struct PcapLimits {
+    uint32_t fileMaxBytes;      // size that starts a new file
+    uint32_t maxFiles;          // oldest files deleted beyond this many
+};
+
+struct PcapStats {
+    uint32_t captured;          // frames copied into the pool
+    uint32_t dropped;           // frames lost to a full pool
+    uint32_t written;           // frames written to the card
+    uint32_t writeErrors;       // batches the card could not take
+    uint32_t files;             // files started this boot
+    uint32_t filesDeleted;      // removed to stay within maxFiles
+    uint32_t bytes;
+};
+
+// Records the deauth and disassoc frames the detector captures to pcapng
+// files for Wireshark (format in PcapFormat.h).
+//
+// capture() runs in the promiscuous callback: it copies the frame bytes and
+// the receive metadata into a slot of a preallocated pool (a SlotRing) and
+// returns without locking, allocating or reading the clock. Frames carry
+// the radio's receive timestamp; the task turns it into wall time. A full pool drops the frame and
+// counts it. A low-priority task wakes every PCAP_DRAIN_MS, packs the
+// waiting frames into one batch and appends it to the current file, so
+// memory stays at the pool and the batch no matter how fast frames arrive.
+//
+// Files are named after the time they were started and rotated by size;
+// beyond PcapLimits::maxFiles the oldest are deleted.
+class PcapWriter {
+public:
+    PcapWriter();
+
+    // Allocates the pool, lists the capture files already in dir, opens a
+    // new one and starts the writer task
+    bool begin(const char* dir, const PcapLimits& limits);
+    bool isActive() const { return active; }
+
+    // WiFi task. frame is len bytes as received, FCS included; rxUs is
+    // rx_ctrl.timestamp
+    void capture(const uint8_t* frame, uint16_t len, uint8_t channel, int8_t rssi, uint32_t rxUs);
+
+    PcapStats getStats() const;
+
+private:
+    struct Frame {
+        uint32_t rxUs;          // low 32 bits of esp_timer time
+        uint16_t length;        // bytes in data
+        uint16_t origLength;    // as received
+        uint8_t channel;
+        int8_t rssi;
+        uint8_t data[PCAP_SNAP_LEN];
+    };
+
+    String dir;
+    PcapLimits limits;
+    SlotRing<Frame, PCAP_SLOTS> pool;
+    uint8_t* batch;
+    File file;
+    String path;
+    uint32_t fileBytes;
+    std::vector<String> names;          // capture files in dir, oldest first
+    TaskHandle_t task;
+    bool active;
+    std::atomic<uint32_t> captured;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> written;
+    std::atomic<uint32_t> writeErrors;
+    std::atomic<uint32_t> files;
+    std::atomic<uint32_t> filesDeleted;
+    std::atomic<uint32_t> bytes;
+
+    static void taskEntry(void* arg);
+    void run();
+    void drain();
+    bool openFile();
+    void cleanup(void* slots);
+    void listFiles();
+};
+
+extern PcapWriter pcapWriter;
+
+#endif
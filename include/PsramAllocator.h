@@ -0,0 +1,98 @@
+#ifndef PSRAM_ALLOCATOR_H
+#define PSRAM_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+// Tracked allocations for large and long-lived structures.
+//
+// Everything allocated through memAlloc(), PsramAllocator or
+// PsramJsonAllocator is charged to a subsystem, so /status can show who
+// holds what and where. PSRAM is preferred and internal RAM is the fallback,
+// which keeps the internal heap free for WiFi, lwIP and the many small
+// String allocations. Counters are atomic; allocation works from any task.
+enum MemSubsystem : uint8_t {
+    MEM_EVENTS = 0,     // event history ring
+    MEM_TRENDS,         // trend buckets
+    MEM_BSSIDS,         // BSSID names and keys
+    MEM_MACLISTS,       // allowlist/denylist filters
+    MEM_SIGNATURES,     // attack signatures and their JSON
+    MEM_REPORTER,       // API payload JSON
+    MEM_WEB,            // web portal JSON and buffers
+    MEM_LOGS,           // session and debug log buffers, compressor scratch
+    MEM_CAPTURE,        // pcapng frame pool and write batch
+    MEM_CONFIG,         // config.txt JSON while loading or saving
+    MEM_SUBSYSTEMS
+};
+
+enum MemPlacement : uint8_t {
+    MEM_PREFER_PSRAM = 0,
+    MEM_PSRAM_ONLY,     // nullptr without PSRAM, so the caller can shrink and retry
+    MEM_INTERNAL_ONLY
+};
+
+struct MemUsage {
+    size_t   psram;         // bytes currently held in PSRAM
+    size_t   internal;      // bytes currently held in internal RAM
+    size_t   peak;          // highest psram + internal seen
+    uint32_t failures;      // requests that could not be placed anywhere
+};
+
+struct HeapRegionStats {
+    size_t  total;
+    size_t  free;
+    size_t  largest;        // largest free block
+    size_t  minFree;        // low-water mark since boot
+    uint8_t fragmentation;  // percent of free memory not in the largest block
+};
+
+// Zeroed block, or nullptr. memFree() accepts nullptr.
+void* memAlloc(MemSubsystem sub, size_t bytes, MemPlacement placement = MEM_PREFER_PSRAM);
+void* memRealloc(void* ptr, size_t bytes);
+void memFree(void* ptr);
+bool memInPsram(const void* ptr);
+
+MemUsage memUsage(MemSubsystem sub);
+const char* memSubsystemName(MemSubsystem sub);
+HeapRegionStats memRegionStats(bool psram);
+
+// Allocator for standard containers. Running out of both heaps aborts,
+// which is what operator new does in this build.
+template <typename T, MemSubsystem S>
+struct PsramAllocator {
+    typedef T value_type;
+    template <typename U> struct rebind { typedef PsramAllocator<U, S> other; };
+
+    PsramAllocator() {}
+    template <typename U> PsramAllocator(const PsramAllocator<U, S>&) {}
+
+    T* allocate(size_t n) {
+        void* p = memAlloc(S, n * sizeof(T));
+        if (!p) {
+            abort();
+        }
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { memFree(p); }
+};
+
+template <typename T, typename U, MemSubsystem S>
+bool operator==(const PsramAllocator<T, S>&, const PsramAllocator<U, S>&) { return true; }
+template <typename T, typename U, MemSubsystem S>
+bool operator!=(const PsramAllocator<T, S>&, const PsramAllocator<U, S>&) { return false; }
+
+template <typename T, MemSubsystem S>
+using PsramVector = std::vector<T, PsramAllocator<T, S>>;
+
+// Allocator for ArduinoJson's BasicJsonDocument. The document's memory
+// pool is one block, so each document is a PSRAM arena of its own.
+template <MemSubsystem S>
+struct PsramJsonAllocator {
+    void* allocate(size_t bytes) { return memAlloc(S, bytes); }
+    void deallocate(void* ptr) { memFree(ptr); }
+    void* reallocate(void* ptr, size_t bytes) { return memRealloc(ptr, bytes); }
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef SSID_MATCHER_H
+#define SSID_MATCHER_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Compiled form of the protected SSID list.
+//
+// Entries are split by shape when the config is loaded:
+//   "Office"       exact name   -> open-addressed hash set
+//   "CORP-*"       prefix glob  -> byte trie (longest prefix wins)
+//   "Guest-?-5G"   other globs  -> short fallback list
+//
+// match() returns the index of the configured entry that matched, so callers
+// can key per-SSID state by list position rather than by String. Exact and
+// prefix lookups cost O(length of the SSID) no matter how many entries exist;
+// only the (rare) general globs are scanned linearly.
+class SSIDMatcher {
+public:
+    static constexpr int NO_MATCH = -1;
+
+    SSIDMatcher();
+    void compile(const std::vector<String>& patterns);
+    int match(const char* ssid, size_t len) const;
+    int match(const String& ssid) const { return match(ssid.c_str(), ssid.length()); }
+    bool matches(const String& ssid) const { return match(ssid) != NO_MATCH; }
+
+    size_t size() const { return patterns.size(); }
+    const String& pattern(int index) const { return patterns[index]; }
+    bool isWildcard(int index) const;
+
+    static bool globMatch(const char* pattern, const char* text, size_t textLen);
+
+private:
+    struct ExactSlot {
+        uint32_t hash;
+        int16_t  index;     // -1 = empty slot
+    };
+
+    // First-child / next-sibling trie keeps nodes at 8 bytes each
+    struct TrieNode {
+        int16_t firstChild;
+        int16_t nextSibling;
+        int16_t terminal;   // pattern index ending here, -1 if none
+        char    ch;
+    };
+
+    std::vector<String>    patterns;
+    std::vector<ExactSlot> exactTable;
+    uint32_t               exactMask;
+    std::vector<TrieNode>  trie;
+    std::vector<int16_t>   globs;
+
+    static uint32_t hash(const char* s, size_t len);
+    void insertExact(const String& ssid, int index);
+    void insertPrefix(const char* prefix, size_t len, int index);
+    int findChild(int node, char ch) const;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SEGMENT_MANIFEST_H
+#define SEGMENT_MANIFEST_H
+
+#include <Arduino.h>
+#include "PsramAllocator.h"
+
+// One session log segment: a CSV (.csv, or .csv.ddz when compressed) and
+// its binary .ddb, same base name
+struct SegmentInfo {
+    char     name[40];      // base name without extension
+    uint32_t opened;        // Unix seconds
+    uint32_t closed;        // 0 while the segment is being written
+    uint32_t firstEvent;    // Unix seconds, 0 if the segment has no events
+    uint32_t lastEvent;
+    uint32_t events;
+    uint32_t bytes;         // CSV + binary, as stored
+};
+
+// List of session log segments, oldest first, kept in RAM and mirrored to
+// manifest.csv in the logs directory:
+//
+//   name,opened,closed,first_event,last_event,events,bytes
+//
+// Readers pick the segments covering a time range from the manifest
+// instead of listing the directory. The file is rewritten (temp file +
+// rename) only when a segment opens or closes and on sync, so an entry
+// still open after a power cut is repaired at the next boot from the
+// files themselves. Not thread-safe; SessionWriter guards it.
+class SegmentManifest {
+public:
+    // Reads manifest.csv in dir, or rebuilds it from the directory if it
+    // is missing; drops entries whose files are gone and closes open ones
+    void load(const char* dir);
+    bool save();
+
+    SegmentInfo& open(const char* name, uint32_t opened);
+    SegmentInfo* current();
+    void closeCurrent(uint32_t closed);
+
+    // Deletes the oldest closed segments until the total fits in budget
+    // (0 = no budget); returns how many were deleted
+    size_t enforceBudget(uint64_t budgetBytes);
+
+    uint64_t totalBytes() const;
+    size_t size() const { return entries.size(); }
+    const SegmentInfo& at(size_t i) const { return entries[i]; }
+
+    String path(const char* name, const char* ext) const;
+
+private:
+    String dir;
+    PsramVector<SegmentInfo, MEM_LOGS> entries;
+
+    void rebuild();
+    void repair(SegmentInfo& info);
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef SESSION_WRITER_H
+#define SESSION_WRITER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "BinaryLogWriter.h"
+#include "CompressedLogWriter.h"
+#include "EventJournal.h"
+#include "EventRing.h"
+#include "SegmentManifest.h"
+
+// Session log writer with group commit.
+//
+// The main loop hands events over through a bounded queue and never touches
+// the card. A low-priority task keeps the current segment's files open (the
+// CSV and the binary .ddb log), formats lines into a RAM buffer and writes +
+// flushes both in one go when the buffer passes SESSION_FLUSH_BYTES or its
+// oldest line is SESSION_FLUSH_MS old. At most that much logging is lost if
+// power goes mid-session.
+//
+// The session is split into segments, rotated by CSV size and by age
+// (SessionLogOptions). Each segment is listed in the logs directory's
+// manifest (see SegmentManifest); when all segments together exceed the
+// space budget the oldest are deleted. All card work, rotation included,
+// happens on the writer task.
+//
+// With SessionLogOptions::compress the CSV is written block-compressed as
+// <segment>.csv.ddz (CompressedLog.h) instead of <segment>.csv; the lines
+// and the flush schedule are the same.
+//
+// Every event also goes into the write-ahead journal (EventJournal), in the
+// same group commit, and so do the reporter's acknowledgements.
+//
+// enqueue() never blocks. When the queue is full it refuses the event and
+// counts it; callers that can hold events elsewhere (main.cpp leaves them in
+// the event ring) should ask space() first and only hand over what fits.
+static const size_t   SESSION_QUEUE_DEPTH = 32;
+static const size_t   SESSION_BUFFER_SIZE = 4096;
+static const size_t   SESSION_FLUSH_BYTES = 3072;
+static const uint32_t SESSION_FLUSH_MS = 1000;
+
+// 0 turns a limit off
+struct SessionLogOptions {
+    uint32_t segmentMaxBytes;   // CSV size that starts a new segment, before compression
+    uint32_t segmentMaxSeconds; // segment age that starts a new segment
+    uint64_t budgetBytes;       // all segments, CSV and binary, as stored
+    bool compress;              // CSV as .csv.ddz
+};
+
+struct SessionWriterStats {
+    uint32_t queued;            // events accepted by enqueue()
+    uint32_t written;           // events written and flushed to the card
+    uint32_t rejected;          // enqueue() calls refused with the queue full
+    uint32_t throttled;         // admit() calls that granted less than asked
+    uint32_t flushes;
+    uint32_t writeErrors;
+    uint32_t queueHighWater;    // most events waiting at once
+    uint32_t maxFlushUs;        // slowest write + flush
+    uint32_t peakEventsPerSec;  // best one-second window of written events
+    uint32_t bytes;             // CSV text
+    uint32_t storedBytes;       // the same CSV as stored on the card
+    uint32_t segments;          // segments opened this boot
+    uint32_t segmentsDeleted;   // removed to stay within the budget
+};
+
+class SessionWriter {
+public:
+    SessionWriter();
+
+    // Loads the manifest in dir, opens the first segment and the journal at
+    // journalPath (none if null) and starts the writer task; header is the
+    // first line of every CSV segment
+    bool begin(const char* dir, const char* header, const SessionLogOptions& options, const char* journalPath);
+    bool isRunning() const { return task != nullptr; }
+
+    bool enqueue(const DeauthEvent& event);
+    size_t space() const;
+    // min(wanted, space()); counts a throttle when the queue is the limit
+    size_t admit(size_t wanted);
+
+    // Blocks until everything queued so far is on the card
+    bool sync(uint32_t timeoutMs = 2000);
+
+    SessionWriterStats getStats() const;
+
+    // Events up to seq were delivered to the API. Never blocks; a dropped
+    // ack is covered by the next one
+    void journalAck(uint64_t seq);
+    // Events earlier boots left undelivered, for the main loop only
+    size_t journalBacklog() const { return journal.backlogSize(); }
+    size_t copyJournalBacklog(DeauthEvent* out, size_t max) const { return journal.copyBacklog(out, max); }
+    void consumeJournalBacklog(size_t count);
+    JournalStats getJournalStats() const { return journal.getStats(); }
+
+    // Path of the current segment's file with the given extension
+    String currentPath(const char* ext);
+    // Extension of the CSV: ".csv", or ".csv.ddz" when compressed
+    const char* csvExtension() const { return options.compress ? ".csv.ddz" : ".csv"; }
+    // Copies up to max manifest entries, oldest first; returns the count
+    size_t copySegments(SegmentInfo* out, size_t max);
+    size_t segmentCount();
+
+private:
+    // Queue item: an event, or a request for the task
+    struct Message {
+        enum Kind : uint8_t { EVENT, SYNC, ACK, CLEAR } kind;
+        DeauthEvent event;              // EVENT; ACK uses only event.seq
+    };
+
+    struct Counters {
+        std::atomic<uint32_t> queued;
+        std::atomic<uint32_t> written;
+        std::atomic<uint32_t> rejected;
+        std::atomic<uint32_t> throttled;
+        std::atomic<uint32_t> flushes;
+        std::atomic<uint32_t> writeErrors;
+        std::atomic<uint32_t> queueHighWater;
+        std::atomic<uint32_t> maxFlushUs;
+        std::atomic<uint32_t> peakEventsPerSec;
+        std::atomic<uint32_t> bytes;
+        std::atomic<uint32_t> storedBytes;
+        std::atomic<uint32_t> segments;
+        std::atomic<uint32_t> segmentsDeleted;
+    };
+
+    String header;
+    SessionLogOptions options;
+    SegmentManifest manifest;
+    SemaphoreHandle_t manifestLock;     // manifest and current segment, vs. the web portal
+    String path;                        // current CSV
+    File file;
+    QueueHandle_t queue;
+    SemaphoreHandle_t synced;
+    TaskHandle_t task;
+    char* buffer;
+    size_t used;
+    size_t bufferedEvents;
+    unsigned long oldestMs;             // when the first unflushed line was added
+    uint32_t bufferFirst;               // Unix seconds of the first and last unflushed line
+    uint32_t bufferLast;
+    unsigned long windowStart;
+    uint32_t windowEvents;
+    uint32_t segmentBytes;              // CSV bytes in the current segment
+    uint32_t storedClosed;              // stored CSV bytes of the segments closed this boot
+    uint32_t segmentOpened;             // Unix seconds
+    bool segmentOpen;                   // false after a rotation failed to open the next one
+    uint32_t segmentEvents;             // events written, not yet in the manifest
+    uint32_t segmentFirst;
+    uint32_t segmentLast;
+    Counters counters;
+    BinaryLogWriter binary;
+    CompressedLogWriter packed;         // the CSV, when compressed
+    EventJournal journal;
+
+    static void taskEntry(void* arg);
+    void run();
+    void append(const DeauthEvent& event);
+    void flush();
+    bool openSegment();
+    void closeSegment();
+    void rotate();
+    bool rotationDue() const;
+    size_t csvStoredBytes() const;
+    void updateManifest();
+};
+
+#endif
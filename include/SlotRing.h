@@ -0,0 +1,84 @@
+#ifndef SLOT_RING_H
+#define SLOT_RING_H
+
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded multi-producer, single-consumer ring of fixed-size items.
+//
+// A producer claims a slot with a compare-and-swap on the head, fills it in
+// place and publishes it through the slot's sequence number; nothing is
+// locked and a full ring refuses the claim instead of waiting. The consumer
+// reads published slots in order and hands each back to the producers one
+// lap ahead. N must be a power of two. Storage comes from the caller (see
+// bytes()) so it can be placed with memAlloc().
+template <typename T, size_t N>
+class SlotRing {
+    static_assert((N & (N - 1)) == 0, "SlotRing size must be a power of two");
+
+public:
+    static constexpr size_t bytes() { return sizeof(Slot) * N; }
+
+    SlotRing() : slots(nullptr), head(0), tail(0) {}
+
+    void begin(void* storage) {
+        Slot* s = static_cast<Slot*>(storage);
+        for (size_t i = 0; i < N; i++) {
+            new (&s[i].seq) std::atomic<uint32_t>((uint32_t)i);
+        }
+        slots = s;
+    }
+    bool isReady() const { return slots != nullptr; }
+
+    // Producer: a slot to fill and pass to publish() with pos, or nullptr
+    // if the ring is full (or not started)
+    T* claim(uint32_t& pos) {
+        if (!slots) {
+            return nullptr;
+        }
+        pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (N - 1)];
+            int32_t diff = (int32_t)(slot.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot.item;
+                }
+            } else if (diff < 0) {
+                return nullptr;     // not drained yet from the last lap
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    void publish(uint32_t pos) {
+        slots[pos & (N - 1)].seq.store(pos + 1, std::memory_order_release);
+    }
+
+    // Consumer: the oldest published item, or nullptr; release() frees it
+    const T* peek() const {
+        if (!slots) {
+            return nullptr;
+        }
+        const Slot& slot = slots[tail & (N - 1)];
+        return slot.seq.load(std::memory_order_acquire) == tail + 1 ? &slot.item : nullptr;
+    }
+    void release() {
+        slots[tail & (N - 1)].seq.store(tail + N, std::memory_order_release);
+        tail++;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;  // == position: free; == position + 1: ready
+        T item;
+    };
+
+    Slot* slots;
+    std::atomic<uint32_t> head;     // next position to claim
+    uint32_t tail;                  // next position to read, consumer only
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "SlotRing.h"
+#include "TraceFormat.h"
+
+// Deferred-formatting trace for the capture path.
+//
+//   TRACE(TRACE_CAPTURE, channel, rssi, subtype, reason, TRACE_MAC(addr2));
+//
+// stores the format ID, a timestamp and the raw arguments in a lock-free
+// ring; the argument count is checked against the format string at compile
+// time. There is no formatting on the device: the debug log task writes the
+// records as binary frames (TraceFormat.h) to Serial or
+// /deauthdetector/logs/trace.bin, and tools/ddtrace expands them on the
+// host. Tracing is off unless debug.trace enables it; -DTRACE_ENABLED=0
+// removes the calls altogether.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+static constexpr size_t TRACE_SLOTS = 128;     // internal RAM, power of two
+
+typedef SlotRing<TraceRecord, TRACE_SLOTS> TraceRing;
+
+extern TraceRing traceRing;
+extern bool traceActive;                        // set once at boot
+extern std::atomic<uint32_t> traceDropped;
+
+// Allocates the ring and starts recording with a TRACE_START record
+bool traceBegin();
+
+#define TRACE_MAC(mac) \
+    ((uint32_t)(mac)[0] << 24 | (uint32_t)(mac)[1] << 16 | (uint32_t)(mac)[2] << 8 | (mac)[3]), \
+    ((uint32_t)(mac)[4] << 8 | (mac)[5])
+
+template <TraceId ID, typename... Args>
+inline void traceWrite(Args... args) {
+    static_assert(sizeof...(Args) == traceArgCount(TRACE_FORMAT_STRINGS[ID]),
+                  "TRACE arguments don't match the format string");
+    uint32_t pos;
+    TraceRecord* r = traceRing.claim(pos);
+    if (!r) {
+        traceDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    r->timeUs = (uint32_t)micros();
+    r->id = ID;
+    r->argCount = sizeof...(Args);
+    uint32_t i = 0;
+    ((r->args[i++] = (uint32_t)args), ...);
+    traceRing.publish(pos);
+}
+
+#if TRACE_ENABLED
+#define TRACE(id, ...) \
+    do { if (traceActive) traceWrite<id>(__VA_ARGS__); } while (0)
+#else
+// Unevaluated, so no code; the arguments still count as used
+#define TRACE(id, ...) \
+    do { (void)sizeof((traceWrite<id>(__VA_ARGS__), 0)); } while (0)
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Binary trace format, shared by the firmware (Trace.h) and the host
+// decoder (tools/ddtrace).
+//
+// A trace record is a format ID and up to TRACE_MAX_ARGS raw 32-bit
+// arguments; the firmware never formats text. The format strings live only
+// in this table and are expanded on the host. Conversions are printf's %d,
+// %i, %u, %x, %X, %c (with flags and width) and %m, a MAC address passed as
+// two arguments with TRACE_MAC(). New formats go at the end so that older
+// traces still decode; the table hash in TRACE_START tells the decoder
+// whether it matches the firmware.
+#define TRACE_FORMATS(X) \
+    X(TRACE_START,          "trace started, format table %08x") \
+    X(TRACE_DROPPED,        "%u trace records dropped") \
+    X(TRACE_CAPTURE,        "capture ch=%u rssi=%d subtype=0x%02x reason=%u sender=%m") \
+    X(TRACE_CAPTURE_FULL,   "capture ring full, frame from %m dropped") \
+    X(TRACE_SSID_FRAME,     "ssid frame ch=%u subtype=0x%02x bssid=%m") \
+    X(TRACE_DRAIN,          "drained %u captures in %u us") \
+    X(TRACE_EVENT,          "event seq=%u ch=%u packets=%u sender=%m") \
+    X(TRACE_HOP,            "hop to ch=%u")
+
+enum TraceId : uint16_t {
+#define TRACE_ENUM(id, fmt) id,
+    TRACE_FORMATS(TRACE_ENUM)
+#undef TRACE_ENUM
+    TRACE_FORMAT_COUNT
+};
+
+static constexpr const char* TRACE_FORMAT_STRINGS[] = {
+#define TRACE_STRING(id, fmt) fmt,
+    TRACE_FORMATS(TRACE_STRING)
+#undef TRACE_STRING
+};
+
+static constexpr size_t TRACE_MAX_ARGS = 6;
+
+struct TraceRecord {
+    uint32_t timeUs;        // micros(), wraps every 71 minutes
+    uint16_t id;
+    uint8_t  argCount;
+    uint8_t  reserved;
+    uint32_t args[TRACE_MAX_ARGS];
+};
+
+// Arguments a format consumes; %m takes two
+constexpr size_t traceArgCount(const char* fmt) {
+    size_t n = 0;
+    for (const char* p = fmt; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        while (*p && (*p < 'a' || *p > 'z') && (*p < 'A' || *p > 'Z')) {
+            p++;
+        }
+        n += *p == 'm' ? 2 : 1;
+        if (!*p) {
+            break;
+        }
+    }
+    return n;
+}
+
+// FNV-1a over every format string, in order
+constexpr uint32_t traceFormatHash() {
+    uint32_t h = 2166136261u;
+    for (const char* fmt : TRACE_FORMAT_STRINGS) {
+        for (const char* p = fmt; ; p++) {
+            h = (h ^ (uint8_t)*p) * 16777619u;
+            if (!*p) {
+                break;
+            }
+        }
+    }
+    return h;
+}
+
+// On the wire (Serial or trace.bin) each record is
+//   timeUs(4) id(2) argCount(1) args(4 * argCount) checksum(1)
+// little-endian, COBS-encoded and followed by a 0x00 delimiter. Text on the
+// same serial line never contains 0x00, so the decoder can pull frames out
+// of a mixed capture: a chunk that doesn't decode to a valid record is text.
+static constexpr size_t TRACE_FRAME_MAX = 7 + 4 * TRACE_MAX_ARGS + 1;
+static constexpr size_t TRACE_WIRE_MAX = TRACE_FRAME_MAX + TRACE_FRAME_MAX / 254 + 2;
+
+inline uint8_t traceChecksum(const uint8_t* data, size_t len) {
+    uint8_t sum = 0x5A;
+    for (size_t i = 0; i < len; i++) {
+        sum = (uint8_t)((sum << 1 | sum >> 7) ^ data[i]);
+    }
+    return sum;
+}
+
+// Serializes a record into out (TRACE_FRAME_MAX bytes); returns the length
+inline size_t tracePack(const TraceRecord& r, uint8_t* out) {
+    size_t n = 0;
+    for (int i = 0; i < 4; i++) out[n++] = (uint8_t)(r.timeUs >> (8 * i));
+    out[n++] = (uint8_t)r.id;
+    out[n++] = (uint8_t)(r.id >> 8);
+    out[n++] = r.argCount;
+    for (size_t a = 0; a < r.argCount && a < TRACE_MAX_ARGS; a++) {
+        for (int i = 0; i < 4; i++) out[n++] = (uint8_t)(r.args[a] >> (8 * i));
+    }
+    out[n] = traceChecksum(out, n);
+    return n + 1;
+}
+
+inline bool traceUnpack(const uint8_t* in, size_t len, TraceRecord& r) {
+    if (len < 8 || traceChecksum(in, len - 1) != in[len - 1]) {
+        return false;
+    }
+    r.timeUs = in[0] | in[1] << 8 | in[2] << 16 | (uint32_t)in[3] << 24;
+    r.id = (uint16_t)(in[4] | in[5] << 8);
+    r.argCount = in[6];
+    r.reserved = 0;
+    if (r.argCount > TRACE_MAX_ARGS || len != 8 + 4 * (size_t)r.argCount) {
+        return false;
+    }
+    for (size_t a = 0; a < r.argCount; a++) {
+        const uint8_t* p = in + 7 + 4 * a;
+        r.args[a] = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+    return true;
+}
+
+// COBS: out gets len + len / 254 + 1 bytes, none of them 0x00, plus the
+// 0x00 delimiter; returns the total
+inline size_t traceCobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t code = 0, n = 1;
+    uint8_t run = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code] = run;
+            code = n++;
+            run = 1;
+        } else {
+            out[n++] = in[i];
+            if (++run == 0xFF) {
+                out[code] = run;
+                code = n++;
+                run = 1;
+            }
+        }
+    }
+    out[code] = run;
+    out[n++] = 0;
+    return n;
+}
+
+// Decodes one frame without its delimiter; returns the length or 0
+inline size_t traceCobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t max) {
+    size_t n = 0;
+    for (size_t i = 0; i < len;) {
+        uint8_t run = in[i++];
+        if (run == 0) {
+            return 0;
+        }
+        for (uint8_t j = 1; j < run; j++) {
+            if (i >= len || n >= max) {
+                return 0;
+            }
+            out[n++] = in[i++];
+        }
+        if (run < 0xFF && i < len) {
+            if (n >= max) {
+                return 0;
+            }
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
+#endif
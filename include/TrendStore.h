@@ -0,0 +1,77 @@
+#ifndef TREND_STORE_H
+#define TREND_STORE_H
+
+#include <Arduino.h>
+
+enum TrendLevel {
+    TREND_SECONDS = 0,      // 1 s buckets, last 5 minutes
+    TREND_MINUTES,          // 1 min buckets, last 24 hours
+    TREND_HOURS,            // 1 h buckets, last 7 days
+    TREND_LEVELS
+};
+
+static constexpr int TREND_MAX_SSIDS = 8;       // first entries of protected_ssids
+static constexpr int TREND_CHANNELS = 14;
+static constexpr int TREND_SERIES = TREND_MAX_SSIDS + TREND_CHANNELS;
+
+// Wall-clock times before this mean NTP never synced; such buckets are kept
+// in memory but never loaded over or saved
+static constexpr time_t TREND_MIN_VALID_TIME = 1609459200;     // 2021-01-01
+
+// Deauth frame counts per protected SSID and per channel at three
+// resolutions, each a fixed ring of buckets indexed by time / bucket length.
+//
+// Memory is allocated once in begin() (PSRAM when available) and never
+// grows. Moving to a newer bucket zeroes the slots skipped over, so gaps
+// while the device was off or reporting read back as zero. Main-loop only:
+// record() runs inside the detector's processing path, queries from the
+// display and web portal, and both happen on the loop task.
+class TrendStore {
+public:
+    TrendStore();
+    ~TrendStore();
+    bool begin();
+    bool isReady() const { return counts != nullptr; }
+
+    // ssidIndex < 0 (or past TREND_MAX_SSIDS) counts toward the channel only
+    void record(time_t now, int ssidIndex, int channel);
+
+    // Up to max buckets of one series, oldest first, the last one being the
+    // bucket that contains 'now'
+    size_t query(TrendLevel level, int series, time_t now, uint32_t* out, size_t max);
+
+    // Frames on all channels over the newest 'buckets' buckets
+    uint32_t total(TrendLevel level, time_t now, size_t buckets);
+
+    // save() writes the whole file when it isn't known to hold this store
+    // (first save, or the load failed), else only the minute and hour
+    // buckets changed since the last save, in place. saveChanges() never
+    // writes the whole file and fails instead; it is the one to use while
+    // monitoring. Second buckets are not kept: five minutes of them are
+    // stale by the next boot.
+    bool save(const char* path);
+    bool saveChanges(const char* path);
+    bool load(const char* path, time_t now);
+
+    static int ssidSeries(int index) { return index; }
+    static int channelSeries(int channel) { return TREND_MAX_SSIDS + channel - 1; }
+    static uint32_t bucketSeconds(TrendLevel level);
+    static size_t bucketCount(TrendLevel level);
+
+private:
+    uint32_t* counts;               // [level][bucket][series] in one block
+    int64_t head[TREND_LEVELS];     // bucket number held by the newest slot, -1 = none
+    int64_t unsaved[TREND_LEVELS];  // oldest bucket changed since the last save, INT64_MAX = none
+    bool fileMatches;               // the file holds this layout, so buckets can be patched in place
+
+    uint32_t* slot(TrendLevel level, int64_t number);
+    void advance(TrendLevel level, int64_t number);
+    void touch(TrendLevel level, int64_t number);
+    bool writeAll(const char* path);
+    bool writeChanges(const char* path);
+    void saved(bool ok);
+    static size_t levelOffset(TrendLevel level);
+    static size_t totalSlots();
+};
+
+#endif
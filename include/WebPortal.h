@@ -6,10 +6,13 @@
 #include <SD.h>
 #include "Config.h"
 #include "ConfigManager.h"
+#include "DeauthDetector.h"
+#include "PsramAllocator.h"
+#include "SegmentManifest.h"
 
 class WebPortal {
 public:
-    WebPortal(ConfigManager* configMgr);
+    WebPortal(ConfigManager* configMgr, DeauthDetector* det = nullptr);
     void begin(bool apMode = true);
     void handle();
     void stop();
@@ -19,6 +22,7 @@ public:
 
 private:
     ConfigManager* configManager;
+    DeauthDetector* detector;
     WebServer server;
     bool active;
     unsigned long lastActivity;
@@ -30,6 +34,12 @@ private:
     void handleNotFound();
     void handleDebugLog();
     void handleDebugClear();
+    void handleSurvey();
+    void handleTrends();
+    void handleEvents();
+    void handleLog();
+    void handleSegments();
+    bool selectSegments(PsramVector<SegmentInfo, MEM_WEB>& segments, int64_t fromUs, int64_t toUs);
     bool authenticate();
     String generateHTML();
 };
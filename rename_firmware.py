@@ -18,7 +18,10 @@ def copy_firmware(source, target, env):
     output_dir_name = output_dir
     os.makedirs(output_dir, exist_ok=True)
 
-    dest = f"{output_dir_name}\deauthdetector-{version}.bin"
+    # Preset envs get their own file name so they don't overwrite each other
+    preset = env["PIOENV"].replace("m5stack-stamps3", "").lstrip("-")
+    suffix = f"-{preset}" if preset else ""
+    dest = f"{output_dir_name}\deauthdetector-{version}{suffix}.bin"
     print (f"*** Post Build Action: Version={version}\n")
     print (f"*** Post Build Action: Copy firmware.bin to '{dest}'\n")
     print(f"*** Output directory: {output_dir_name}\n") 
@@ -1,17 +1,19 @@
 #include "APIReporter.h"
 #include "Logger.h"
+#include "PsramAllocator.h"
+#include "OuiLookup.h"
 
 APIReporter::APIReporter(APIConfig& config) : apiConfig(config) {}
 
-bool APIReporter::sendBatch(const std::vector<DeauthEvent>& events) {
-    if (events.empty()) {
-        logger.debugPrintln("No events to report");
-        return true;
+ReportResult APIReporter::sendBatch(const DeauthEvent* events, size_t count) {
+    if (count == 0) {
+        LOG_DEBUG("No events to report");
+        return REPORT_OK;
     }
     
     if (apiConfig.endpoint_url.isEmpty()) {
-        logger.debugPrintln("API endpoint not configured");
-        return false;
+        LOG_WARN("API endpoint not configured");
+        return REPORT_RETRY;
     }
     
     HTTPClient http;
@@ -23,37 +25,35 @@ bool APIReporter::sendBatch(const std::vector<DeauthEvent>& events) {
         http.addHeader(apiConfig.custom_header_name, apiConfig.custom_header_value);
     }
     
-    String payload = buildPayload(events);
+    String payload = buildPayload(events, count);
     
-    logger.debugPrint("Sending ");
-    logger.debugPrint(String(events.size()));
-    logger.debugPrintln(" events to API...");
-    logger.debugPrintln(payload);
+    LOG_INFO("Sending %u events to API...", (unsigned)count);
+    LOG_DEBUG("%s", payload.c_str());
     
     int httpResponseCode = http.POST(payload);
     
     if (httpResponseCode > 0) {
-        logger.debugPrint("API response code: ");
-        logger.debugPrintln(String(httpResponseCode));
-        
-        String response = http.getString();
-        logger.debugPrintln("Response: " + response);
+        LOG_INFO("API response code: %d", httpResponseCode);
+        LOG_DEBUG("Response: %s", http.getString().c_str());
         
         http.end();
-        return (httpResponseCode >= 200 && httpResponseCode < 300);
+        if (httpResponseCode >= 200 && httpResponseCode < 300) {
+            return REPORT_OK;
+        }
+        return (httpResponseCode >= 400 && httpResponseCode < 500) ? REPORT_REJECTED : REPORT_RETRY;
     } else {
-        logger.debugPrint("Error sending to API: ");
-        logger.debugPrintln(http.errorToString(httpResponseCode));
+        LOG_WARN("Error sending to API: %s", http.errorToString(httpResponseCode).c_str());
         http.end();
-        return false;
+        return REPORT_RETRY;
     }
 }
 
-String APIReporter::buildPayload(const std::vector<DeauthEvent>& events) {
-    DynamicJsonDocument doc(4096);
+String APIReporter::buildPayload(const DeauthEvent* events, size_t count) {
+    BasicJsonDocument<PsramJsonAllocator<MEM_REPORTER>> doc(4096);
     JsonArray array = doc.to<JsonArray>();
     
-    for (const DeauthEvent& event : events) {
+    for (size_t i = 0; i < count; i++) {
+        const DeauthEvent& event = events[i];
         JsonObject obj = array.createNestedObject();
         
         // Format timestamp as ISO 8601
@@ -69,6 +69,19 @@ String APIReporter::buildPayload(const std::vector<DeauthEvent>& events) {
         obj["channel"] = event.channel;
         obj["rssi"] = event.rssi;
         obj["packet_count"] = event.packet_count;
+        if (event.denylisted) {
+            obj["denylisted"] = true;
+        }
+        if (event.vendor != OUI_UNKNOWN) {
+            obj["vendor"] = ouiVendorName(event.vendor);
+        }
+        if (event.randomized) {
+            obj["randomized"] = true;
+        }
+        if (event.tool[0] != '\0') {
+            obj["tool"] = event.tool;
+            obj["tool_confidence"] = event.tool_confidence;
+        }
     }
     
     String output;
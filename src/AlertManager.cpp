@@ -13,7 +13,7 @@
 CRGB leds[NUM_LEDS];
 
 AlertManager::AlertManager(HardwareConfig &config)
-    : hwConfig(config), alertActive(false), alertStartTime(0),
+    : hwConfig(config), alertActive(false), escalatedActive(false), alertStartTime(0),
       lastPacketTime(0), ledTimer(0), ledCountdownActive(false) {}
 
 void AlertManager::begin()
@@ -29,29 +29,32 @@ void AlertManager::begin()
     M5Cardputer.Display.setBrightness(hwConfig.screen_brightness);
 }
 
-void AlertManager::triggerAlert()
+void AlertManager::triggerAlert(bool escalated)
 {
     alertActive = true;
     alertStartTime = millis();
     lastPacketTime = millis();
+    // Stays escalated until the alert clears, even if later frames are ordinary
+    escalatedActive = escalated || escalatedActive;
 
     // Sound buzzer
     setBuzzer(true);
 
-    // Set LED to red
-    setLED(0xFF0000);
+    // Red LED, magenta for a known-hostile sender
+    setLED(escalatedActive ? 0xFF00FF : 0xFF0000);
 
     // Start LED countdown
     ledCountdownActive = true;
     ledTimer = millis();
 
-    logger.debugPrintln("Alert triggered!");
+    LOG_INFO("Alert triggered!");
 }
 
 void AlertManager::update()
 {
-    // Handle buzzer duration
-    if (alertActive && (millis() - alertStartTime) > hwConfig.buzzer_duration_ms)
+    // Handle buzzer duration, three times as long when escalated
+    unsigned long buzzerMs = escalatedActive ? hwConfig.buzzer_duration_ms * 3UL : hwConfig.buzzer_duration_ms;
+    if (alertActive && (millis() - alertStartTime) > buzzerMs)
     {
         setBuzzer(false);
     }
@@ -72,7 +75,8 @@ void AlertManager::update()
                 setLED(0x000000);
                 ledCountdownActive = false;
                 alertActive = false;
-                logger.debugPrintln("Alert cleared after silence period");
+                escalatedActive = false;
+                LOG_INFO("Alert cleared after silence period");
             }
         }
         else
@@ -106,32 +110,30 @@ void AlertManager::setLED(uint32_t color)
     leds[0] = CRGB(r, g, b);
     FastLED.show(LED_BRIGHTNESS);
 
-    char buf[64];
-    snprintf(buf, sizeof(buf), "LED color set to: 0x%06X (R:%d G:%d B:%d)", color, r, g, b);
-    logger.debugPrintln(buf);
+    LOG_DEBUG("LED color set to: 0x%06X (R:%d G:%d B:%d)", (unsigned)color, r, g, b);
 }
 
 // LED status indicators for system states
 void AlertManager::setStatusConnecting()
 {
     setLED(0xFFFF00); // Yellow
-    logger.debugPrintln("LED Status: Connecting to WiFi");
+    LOG_DEBUG("LED Status: Connecting to WiFi");
 }
 
 void AlertManager::setStatusSyncing()
 {
     setLED(0x0000FF); // Blue
-    logger.debugPrintln("LED Status: Syncing time");
+    LOG_DEBUG("LED Status: Syncing time");
 }
 
 void AlertManager::setStatusScanning()
 {
     setLED(0xFFFF00); // Yellow
-    logger.debugPrintln("LED Status: Scanning WiFi channels");
+    LOG_DEBUG("LED Status: Scanning WiFi channels");
 }
 
 void AlertManager::setStatusReady()
 {
     setLED(0x000000); // Off
-    logger.debugPrintln("LED Status: System ready");
+    LOG_DEBUG("LED Status: System ready");
 }
@@ -0,0 +1,228 @@
+#include "AttackFingerprinter.h"
+#include "Logger.h"
+#include "PsramAllocator.h"
+#include <SD.h>
+#include <ArduinoJson.h>
+
+// Used when no signatures file is present on the SD card. Same format as
+// signatures.json.example; tune there rather than here.
+static const char DEFAULT_SIGNATURES[] = R"({"signatures":[
+ {"name":"aireplay-ng","reason_codes":[7],"gap_us":[500,8000],"burst_frames":[64,128],"broadcast":"any","sequence":"increment","min_frames":16},
+ {"name":"mdk4","gap_us":[0,1500],"broadcast":"any","sequence":"random","min_frames":32},
+ {"name":"esp8266-deauther","reason_codes":[1],"gap_us":[0,20000],"broadcast":"any","sequence":"constant","min_frames":8}
+]})";
+
+static constexpr uint32_t BURST_GAP_US = 500000;   // silence that ends a burst
+static constexpr uint8_t  MIN_CONFIDENCE = 60;
+
+static int popcount32(uint32_t v) {
+    int n = 0;
+    while (v) {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+AttackFingerprinter::AttackFingerprinter() {
+    reset();
+}
+
+void AttackFingerprinter::reset() {
+    memset(attackers, 0, sizeof(attackers));
+    for (AttackerState& a : attackers) {
+        a.match = -1;
+    }
+}
+
+bool AttackFingerprinter::loadSignatures(const char* path) {
+    if (SD.exists(path)) {
+        File file = SD.open(path, FILE_READ);
+        if (file) {
+            String json = file.readString();
+            file.close();
+            if (parseSignatures(json.c_str(), json.length())) {
+                LOG_INFO("Loaded %u attack signatures from %s", (unsigned)signatures.size(), path);
+                return true;
+            }
+            LOG_WARN("Invalid signatures file, using built-in signatures");
+        }
+    }
+    return parseSignatures(DEFAULT_SIGNATURES, sizeof(DEFAULT_SIGNATURES) - 1);
+}
+
+bool AttackFingerprinter::parseSignatures(const char* json, size_t len) {
+    BasicJsonDocument<PsramJsonAllocator<MEM_SIGNATURES>> doc(8192);
+    DeserializationError error = deserializeJson(doc, json, len);
+    if (error) {
+        LOG_WARN("Failed to parse signatures: %s", error.c_str());
+        return false;
+    }
+
+    std::vector<AttackSignature> parsed;
+    JsonArray list = doc["signatures"];
+    for (JsonVariant v : list) {
+        AttackSignature sig;
+        sig.name = v["name"] | "unnamed";
+        sig.reasonMask = 0;
+        JsonArray reasons = v["reason_codes"];
+        for (JsonVariant r : reasons) {
+            int code = r.as<int>();
+            sig.reasonMask |= 1UL << (code < 31 ? code : 31);
+        }
+        JsonArray gap = v["gap_us"];
+        sig.minGapUs = gap[0] | 0;
+        sig.maxGapUs = gap[1] | 0;
+        JsonArray burst = v["burst_frames"];
+        sig.minBurst = burst[0] | 0;
+        sig.maxBurst = burst[1] | 0;
+
+        String broadcast = v["broadcast"] | "any";
+        sig.broadcast = broadcast == "yes" ? 1 : (broadcast == "no" ? 0 : -1);
+
+        String sequence = v["sequence"] | "any";
+        sig.sequence = sequence == "increment" ? SEQ_INCREMENT
+                     : sequence == "constant"  ? SEQ_CONSTANT
+                     : sequence == "random"    ? SEQ_RANDOM
+                     : SEQ_ANY;
+        sig.minFrames = v["min_frames"] | 8;
+        parsed.push_back(sig);
+    }
+
+    signatures.swap(parsed);
+    reset();
+    return true;
+}
+
+AttackerState& AttackFingerprinter::slotFor(const uint8_t* mac) {
+    AttackerState* oldest = &attackers[0];
+    for (AttackerState& a : attackers) {
+        if (a.used && memcmp(a.mac, mac, 6) == 0) {
+            return a;
+        }
+        if (!a.used) {
+            oldest = &a;
+        } else if (oldest->used && a.lastSeenMs < oldest->lastSeenMs) {
+            oldest = &a;
+        }
+    }
+
+    // Evict the least recently seen sender
+    memset(oldest, 0, sizeof(AttackerState));
+    memcpy(oldest->mac, mac, 6);
+    oldest->used = true;
+    oldest->match = -1;
+    return *oldest;
+}
+
+int AttackFingerprinter::update(const uint8_t* sender, const uint8_t* receiver, uint16_t reason,
+                                uint16_t seq, uint32_t rxUs, uint8_t& confidence) {
+    confidence = 0;
+    if (signatures.empty()) {
+        return -1;
+    }
+
+    AttackerState& a = slotFor(sender);
+    a.lastSeenMs = millis();
+
+    if (a.frames > 0) {
+        uint32_t gap = rxUs - a.lastRxUs;
+        if (gap > BURST_GAP_US) {
+            a.lastBurstFrames = a.burstFrames;
+            a.burstFrames = 0;
+        } else {
+            // EWMA with 1/8 weight
+            a.meanGapUs = a.meanGapUs == 0 ? gap
+                        : (uint32_t)((int32_t)a.meanGapUs + ((int32_t)gap - (int32_t)a.meanGapUs) / 8);
+        }
+
+        if (seq == (uint16_t)((a.lastSeq + 1) & 0x0FFF)) {
+            a.seqStep++;
+        } else if (seq == a.lastSeq) {
+            a.seqSame++;
+        } else {
+            a.seqOther++;
+        }
+    }
+
+    a.frames++;
+    a.burstFrames++;
+    a.lastRxUs = rxUs;
+    a.lastSeq = seq;
+    a.reasonMask |= 1UL << (reason < 31 ? reason : 31);
+    if ((receiver[0] & receiver[1] & receiver[2] & receiver[3] & receiver[4] & receiver[5]) == 0xFF) {
+        a.broadcastFrames++;
+    }
+
+    // Re-score at 1, 2, 4 ... 64 frames, then every 32
+    uint32_t f = a.frames;
+    if ((f <= 64 && (f & (f - 1)) == 0) || (f % 32) == 0) {
+        score(a);
+    }
+
+    confidence = a.confidence;
+    return a.match;
+}
+
+void AttackFingerprinter::score(AttackerState& a) {
+    int best = -1;
+    uint32_t bestScore = 0;
+    uint32_t seqTotal = a.seqStep + a.seqSame + a.seqOther;
+
+    for (size_t i = 0; i < signatures.size(); i++) {
+        const AttackSignature& sig = signatures[i];
+        if (a.frames < sig.minFrames) {
+            continue;
+        }
+
+        // Weighted features, each scored 0-100
+        uint32_t total = 0;
+        uint32_t weight = 0;
+
+        if (sig.reasonMask) {
+            int seen = popcount32(a.reasonMask);
+            int inside = popcount32(a.reasonMask & sig.reasonMask);
+            total += 3 * (seen ? 100 * inside / seen : 0);
+            weight += 3;
+        }
+        if (sig.maxGapUs) {
+            uint32_t g = a.meanGapUs;
+            uint32_t s = (g >= sig.minGapUs && g <= sig.maxGapUs) ? 100
+                       : (g >= sig.minGapUs / 2 && g <= sig.maxGapUs * 2) ? 50 : 0;
+            total += 2 * s;
+            weight += 2;
+        }
+        if (sig.maxBurst) {
+            // Judge the current burst once it's as long as the last one
+            uint32_t b = a.burstFrames > a.lastBurstFrames ? a.burstFrames : a.lastBurstFrames;
+            total += (b >= sig.minBurst && b <= sig.maxBurst) ? 100 : 0;
+            weight += 1;
+        }
+        if (sig.broadcast >= 0) {
+            uint32_t pct = 100 * a.broadcastFrames / a.frames;
+            total += sig.broadcast ? pct : 100 - pct;
+            weight += 1;
+        }
+        if (sig.sequence != SEQ_ANY && seqTotal > 0) {
+            uint32_t hits = sig.sequence == SEQ_INCREMENT ? a.seqStep
+                          : sig.sequence == SEQ_CONSTANT  ? a.seqSame
+                          : a.seqOther;
+            total += 2 * (100 * hits / seqTotal);
+            weight += 2;
+        }
+
+        uint32_t s = weight ? total / weight : 0;
+        if (s > bestScore) {
+            bestScore = s;
+            best = i;
+        }
+    }
+
+    if (bestScore >= MIN_CONFIDENCE) {
+        a.match = best;
+        a.confidence = bestScore;
+    } else {
+        a.match = -1;
+        a.confidence = 0;
+    }
+}
@@ -0,0 +1,178 @@
+#include "BinaryLogWriter.h"
+#include "PsramAllocator.h"
+
+// FNV-1a
+static uint32_t nameHash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+BinaryLogWriter::BinaryLogWriter()
+    : block(nullptr), dict(nullptr), dictHash(nullptr), slots(0), flushedSlots(0),
+      blockNo(0), dictUsed(0), dictFlushed(0), opened(false) {}
+
+bool BinaryLogWriter::begin(const char* filePath, int64_t createdUs) {
+    close();
+    if (!block) {
+        block = (uint8_t*)memAlloc(MEM_LOGS, BLOG_BLOCK_BYTES);
+        dict = (BlogDictEntry*)memAlloc(MEM_LOGS, BLOG_DICT_ENTRIES * sizeof(BlogDictEntry));
+        dictHash = (uint32_t*)memAlloc(MEM_LOGS, BLOG_DICT_ENTRIES * sizeof(uint32_t));
+        if (!block || !dict || !dictHash) {
+            memFree(block);
+            memFree(dict);
+            memFree(dictHash);
+            block = nullptr;
+            dict = nullptr;
+            dictHash = nullptr;
+            return false;
+        }
+    }
+    memset(block, 0, BLOG_BLOCK_BYTES);
+    memset(dict, 0, BLOG_DICT_ENTRIES * sizeof(BlogDictEntry));
+    slots = 0;
+    flushedSlots = 0;
+    blockNo = 0;
+    dictUsed = 0;
+    dictFlushed = 0;
+
+    path = filePath;
+    file = SD.open(path.c_str(), "w+");
+    if (!file) {
+        return false;
+    }
+
+    // Header, then zeros up to the first block so the dictionary can be
+    // filled in place
+    BlogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BLOG_MAGIC, sizeof(header.magic));
+    header.version = BLOG_VERSION;
+    header.recordSize = BLOG_RECORD_SIZE;
+    header.blockRecords = BLOG_BLOCK_RECORDS;
+    header.dictEntries = BLOG_DICT_ENTRIES;
+    header.dictEntrySize = BLOG_DICT_ENTRY_SIZE;
+    header.createdUs = createdUs;
+    file.write((const uint8_t*)&header, sizeof(header));
+    for (size_t pos = sizeof(header); pos < BLOG_DATA_START; pos += BLOG_BLOCK_BYTES) {
+        size_t n = BLOG_DATA_START - pos < BLOG_BLOCK_BYTES ? BLOG_DATA_START - pos : BLOG_BLOCK_BYTES;
+        file.write(block, n);       // still zeroed
+    }
+    file.flush();
+    opened = true;
+    return true;
+}
+
+void BinaryLogWriter::close() {
+    if (opened) {
+        flush();
+        file.close();
+        opened = false;
+    }
+}
+
+uint8_t BinaryLogWriter::nameId(const char* name) {
+    size_t len = strnlen(name, sizeof(dict[0].name));
+    if (len == 0) {
+        return BLOG_NAME_NONE;
+    }
+    uint32_t h = nameHash(name, len);
+    for (size_t i = 0; i < dictUsed; i++) {
+        if (dictHash[i] == h && dict[i].len == len && memcmp(dict[i].name, name, len) == 0) {
+            return (uint8_t)(i + 1);
+        }
+    }
+    if (dictUsed == BLOG_DICT_ENTRIES) {
+        return BLOG_NAME_LOST;
+    }
+    dict[dictUsed].len = (uint8_t)len;
+    memcpy(dict[dictUsed].name, name, len);
+    dictHash[dictUsed] = h;
+    return (uint8_t)(++dictUsed);
+}
+
+void BinaryLogWriter::append(const DeauthEvent& event) {
+    if (!opened) {
+        return;
+    }
+    if (slots == BLOG_BLOCK_RECORDS) {
+        flush();
+        memset(block, 0, BLOG_BLOCK_BYTES);
+        blockNo++;
+        slots = 0;
+        flushedSlots = 0;
+    }
+
+    BlogIndex* index = (BlogIndex*)block;
+    if (slots == 0) {
+        index->type = BLOG_INDEX;
+        index->block = blockNo;
+        index->firstUs = event.timestamp_us;
+        index->firstSeq = (uint32_t)event.seq;
+        slots = 1;
+    }
+
+    BlogEvent* rec = (BlogEvent*)(block + slots * BLOG_RECORD_SIZE);
+    rec->type = BLOG_EVENT;
+    rec->channel = (uint8_t)event.channel;
+    rec->rssi = (int8_t)event.rssi;
+    rec->flags = (event.denylisted ? BLOG_DENYLISTED : 0) | (event.randomized ? BLOG_RANDOMIZED : 0);
+    rec->packetCount = (uint32_t)event.packet_count;
+    rec->timeUs = event.timestamp_us;
+    if (!blogParseMac(event.target_bssid, rec->bssid)) memset(rec->bssid, 0, 6);
+    if (!blogParseMac(event.attacker_mac, rec->attacker)) memset(rec->attacker, 0, 6);
+    rec->ssid = nameId(event.target_ssid);
+    rec->tool = nameId(event.tool);
+    rec->toolConfidence = (uint8_t)event.tool_confidence;
+    rec->vendor = event.vendor;
+
+    index->count++;
+    index->lastUs = event.timestamp_us;
+    slots++;
+}
+
+bool BinaryLogWriter::flush() {
+    if (!opened || (slots == flushedSlots && dictUsed == dictFlushed)) {
+        return true;
+    }
+    if (!file) {
+        file = SD.open(path.c_str(), "r+");
+        if (!file) {
+            return false;
+        }
+    }
+
+    bool ok = true;
+    // New names first, so no event on the card refers to a missing entry
+    if (dictUsed > dictFlushed) {
+        size_t bytes = (dictUsed - dictFlushed) * sizeof(BlogDictEntry);
+        ok = file.seek(BLOG_DICT_START + dictFlushed * sizeof(BlogDictEntry)) &&
+             file.write((const uint8_t*)&dict[dictFlushed], bytes) == bytes;
+    }
+    // The index record, then the events added since the last flush; one
+    // write while they are still contiguous
+    if (ok && slots > flushedSlots) {
+        size_t base = blogBlockOffset(blockNo);
+        if (flushedSlots <= 1) {
+            size_t bytes = slots * BLOG_RECORD_SIZE;
+            ok = file.seek(base) && file.write(block, bytes) == bytes;
+        } else {
+            size_t bytes = (slots - flushedSlots) * BLOG_RECORD_SIZE;
+            ok = file.seek(base) && file.write(block, BLOG_RECORD_SIZE) == BLOG_RECORD_SIZE &&
+                 file.seek(base + flushedSlots * BLOG_RECORD_SIZE) &&
+                 file.write(block + flushedSlots * BLOG_RECORD_SIZE, bytes) == bytes;
+        }
+    }
+    file.flush();
+
+    if (!ok) {
+        // Retried from RAM at the next flush, through a fresh handle
+        file.close();
+        return false;
+    }
+    dictFlushed = dictUsed;
+    flushedSlots = slots;
+    return true;
+}
@@ -0,0 +1,58 @@
+#include "ChannelSurvey.h"
+
+ChannelSurvey::ChannelSurvey()
+    : liveBucket(0), completed(0), bucketLengthMs(10000), bucketStart(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void ChannelSurvey::begin(uint32_t bucketMs) {
+    bucketLengthMs = bucketMs > 0 ? bucketMs : 10000;
+    reset();
+}
+
+void ChannelSurvey::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    liveBucket = 0;
+    completed = 0;
+    bucketStart = millis();
+}
+
+void ChannelSurvey::addDwell(int channel, uint32_t ms) {
+    if (channel < 1 || channel > SURVEY_CHANNELS) return;
+    buckets[liveBucket][channel - 1].dwellMs += ms;
+}
+
+void ChannelSurvey::update(unsigned long now) {
+    if (now - bucketStart < bucketLengthMs) return;
+
+    int next = (liveBucket + 1) % (SURVEY_HISTORY + 1);
+    memset(buckets[next], 0, sizeof(buckets[next]));
+    liveBucket = next;
+    bucketStart = now;
+
+    if (completed < SURVEY_HISTORY) {
+        completed++;
+    }
+}
+
+bool ChannelSurvey::getBucket(int age, int channel, SurveyCounters& out) const {
+    if (age < 0 || age >= completed || channel < 1 || channel > SURVEY_CHANNELS) {
+        return false;
+    }
+    int index = (liveBucket - 1 - age + 2 * (SURVEY_HISTORY + 1)) % (SURVEY_HISTORY + 1);
+    out = buckets[index][channel - 1];
+    return true;
+}
+
+int ChannelSurvey::approxRssi(const SurveyCounters& c) {
+    // Weighted mean of bin midpoints
+    static const int midpoints[SURVEY_RSSI_BINS] = { -95, -85, -75, -65, -55, -45 };
+    uint32_t total = 0;
+    int64_t sum = 0;
+    for (int i = 0; i < SURVEY_RSSI_BINS; i++) {
+        total += c.rssiBins[i];
+        sum += (int64_t)c.rssiBins[i] * midpoints[i];
+    }
+    return total > 0 ? (int)(sum / total) : 0;
+}
@@ -0,0 +1,154 @@
+#include "CompressedLogWriter.h"
+#include "PsramAllocator.h"
+
+CompressedLogWriter::CompressedLogWriter()
+    : raw(nullptr), packed(nullptr), table(nullptr), block(), rawUsed(0), flushedRaw(0), sealedBytes(0),
+      openBytes(0), opened(false) {}
+
+bool CompressedLogWriter::begin(const char* filePath) {
+    close();
+    if (!raw) {
+        raw = (uint8_t*)memAlloc(MEM_LOGS, DDZ_BLOCK_RAW);
+        packed = (uint8_t*)memAlloc(MEM_LOGS, sizeof(DdzBlock) + DDZ_STORED_MAX);
+        table = (uint16_t*)memAlloc(MEM_LOGS, LZ_HASH_SIZE * sizeof(uint16_t));
+        if (!raw || !packed || !table) {
+            memFree(raw);
+            memFree(packed);
+            memFree(table);
+            raw = nullptr;
+            packed = nullptr;
+            table = nullptr;
+            return false;
+        }
+    }
+    memset(&block, 0, sizeof(block));
+    rawUsed = 0;
+    flushedRaw = 0;
+    openBytes = 0;
+
+    path = filePath;
+    file = SD.open(path.c_str(), "w+");
+    if (!file) {
+        return false;
+    }
+    DdzHeader header;
+    ddzInitHeader(header);
+    sealedBytes = file.write((const uint8_t*)&header, sizeof(header));
+    file.flush();
+    opened = sealedBytes == sizeof(header);
+    return opened;
+}
+
+void CompressedLogWriter::close() {
+    if (opened) {
+        flush();
+        file.close();
+        opened = false;
+    }
+}
+
+void CompressedLogWriter::append(const char* text, size_t len, uint32_t firstTime, uint32_t lastTime) {
+    if (!opened) {
+        return;
+    }
+    while (len > 0) {
+        // As many whole lines as the block has room for; a single line
+        // longer than a block is cut
+        size_t take = len;
+        if (take > DDZ_BLOCK_RAW - rawUsed) {
+            take = DDZ_BLOCK_RAW - rawUsed;
+            while (take > 0 && text[take - 1] != '\n') {
+                take--;
+            }
+            if (take == 0) {
+                if (rawUsed > 0) {
+                    seal();
+                    continue;
+                }
+                take = DDZ_BLOCK_RAW;
+            }
+        }
+
+        if (rawUsed == 0) {
+            block.firstTime = firstTime;
+        }
+        block.lastTime = lastTime;
+        for (size_t i = 0; i < take; i++) {
+            block.lines += text[i] == '\n';
+        }
+        memcpy(raw + rawUsed, text, take);
+        rawUsed += take;
+        text += take;
+        len -= take;
+        if (rawUsed == DDZ_BLOCK_RAW) {
+            seal();
+        }
+    }
+}
+
+bool CompressedLogWriter::flush() {
+    if (!opened || rawUsed == flushedRaw) {
+        return true;
+    }
+    if (!writeOpen()) {
+        return false;
+    }
+    if (rawUsed >= COMPRESSED_SEAL_RAW) {
+        sealedBytes += openBytes;
+        startBlock();
+    }
+    return true;
+}
+
+// Compresses the open block and writes it at sealedBytes
+bool CompressedLogWriter::writeOpen() {
+    if (!file) {
+        file = SD.open(path.c_str(), "r+");
+        if (!file) {
+            return false;
+        }
+    }
+
+    uint8_t* payload = packed + sizeof(DdzBlock);
+    size_t stored = lzCompress(raw, rawUsed, payload, DDZ_STORED_MAX, table);
+    block.flags = 0;
+    if (stored == 0 || stored >= rawUsed) {
+        memcpy(payload, raw, rawUsed);
+        stored = rawUsed;
+        block.flags = DDZ_STORED;
+    }
+    block.magic = DDZ_BLOCK_MAGIC;
+    block.rawLen = rawUsed;
+    block.storedLen = stored;
+    block.crc = ddzBlockCrc(block, payload);
+    memcpy(packed, &block, sizeof(block));
+
+    size_t bytes = sizeof(DdzBlock) + stored;
+    bool ok = file.seek(sealedBytes) && file.write(packed, bytes) == bytes;
+    file.flush();
+    if (!ok) {
+        // Retried from RAM at the next flush, through a fresh handle
+        file.close();
+        return false;
+    }
+    openBytes = bytes;
+    flushedRaw = rawUsed;
+    return true;
+}
+
+// Writes the open block out for the last time and starts the next one
+// behind it. If that write fails the block's text is dropped and the next
+// block takes its place, rather than holding up the writer.
+void CompressedLogWriter::seal() {
+    if (rawUsed == flushedRaw || writeOpen()) {
+        sealedBytes += openBytes;
+    }
+    startBlock();
+}
+
+void CompressedLogWriter::startBlock() {
+    memset(&block, 0, sizeof(block));
+    rawUsed = 0;
+    flushedRaw = 0;
+    openBytes = 0;
+}
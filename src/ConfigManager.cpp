@@ -1,5 +1,10 @@
 #include "ConfigManager.h"
 #include "Logger.h"
+#include "PsramAllocator.h"
+
+// Room for the whole schema with a few dozen protected SSIDs and long
+// strings; the example config alone takes about 1.3 KB
+static const size_t CONFIG_JSON_CAPACITY = 8192;
 
 ConfigManager::ConfigManager() : configValid(false) {
     setDefaults();
@@ -21,6 +26,9 @@ void ConfigManager::setDefaults() {
     config.detection.channel_scan_time_ms = DEFAULT_CHANNEL_SCAN_TIME_MS;
     config.detection.channel_hop_interval_ms = DEFAULT_CHANNEL_HOP_INTERVAL_MS;
     
+    config.survey.enabled = false;
+    config.survey.bucket_seconds = DEFAULT_SURVEY_BUCKET_SECONDS;
+    
     config.api.endpoint_url = "";
     config.api.custom_header_name = "X-API-KEY";
     config.api.custom_header_value = "";
@@ -31,27 +39,36 @@ void ConfigManager::setDefaults() {
     config.hardware.fancy_intro = true;
     
     config.debug.enabled = false;
+    config.debug.trace = "off";
+    
+    config.logging.segment_max_kb = DEFAULT_SEGMENT_MAX_KB;
+    config.logging.segment_max_minutes = DEFAULT_SEGMENT_MAX_MINUTES;
+    config.logging.budget_mb = DEFAULT_LOG_BUDGET_MB;
+    config.logging.compress = DEFAULT_LOG_COMPRESS;
+    
+    config.capture.enabled = false;
+    config.capture.file_max_kb = DEFAULT_CAPTURE_FILE_MAX_KB;
+    config.capture.max_files = DEFAULT_CAPTURE_MAX_FILES;
 }
 
 bool ConfigManager::loadConfig(const char* filename) {
     if (!SD.exists(filename)) {
-        logger.debugPrintln("Config file not found");
+        LOG_WARN("Config file not found");
         return false;
     }
     
     File file = SD.open(filename, FILE_READ);
     if (!file) {
-        logger.debugPrintln("Failed to open config file");
+        LOG_ERROR("Failed to open config file");
         return false;
     }
     
-    StaticJsonDocument<2048> doc;
+    BasicJsonDocument<PsramJsonAllocator<MEM_CONFIG>> doc(CONFIG_JSON_CAPACITY);
     DeserializationError error = deserializeJson(doc, file);
     file.close();
     
     if (error) {
-        logger.debugPrint("Failed to parse config: ");
-        logger.debugPrintln(error.c_str());
+        LOG_ERROR("Failed to parse config: %s", error.c_str());
         return false;
     }
     
@@ -91,6 +108,13 @@ bool ConfigManager::loadConfig(const char* filename) {
         config.detection.channel_hop_interval_ms = detection["channel_hop_interval_ms"] | DEFAULT_CHANNEL_HOP_INTERVAL_MS;
     }
     
+    // Parse Survey config
+    if (doc.containsKey("survey")) {
+        JsonObject survey = doc["survey"];
+        config.survey.enabled = survey["enabled"] | false;
+        config.survey.bucket_seconds = survey["bucket_seconds"] | DEFAULT_SURVEY_BUCKET_SECONDS;
+    }
+    
     // Parse API config
     if (doc.containsKey("api")) {
         JsonObject api = doc["api"];
@@ -112,17 +136,35 @@ bool ConfigManager::loadConfig(const char* filename) {
     if (doc.containsKey("debug")) {
         JsonObject debug = doc["debug"];
         config.debug.enabled = debug["enabled"] | false;
+        config.debug.trace = debug["trace"] | "off";
+    }
+    
+    // Parse Logging config
+    if (doc.containsKey("logging")) {
+        JsonObject logging = doc["logging"];
+        config.logging.segment_max_kb = logging["segment_max_kb"] | DEFAULT_SEGMENT_MAX_KB;
+        config.logging.segment_max_minutes = logging["segment_max_minutes"] | DEFAULT_SEGMENT_MAX_MINUTES;
+        config.logging.budget_mb = logging["budget_mb"] | DEFAULT_LOG_BUDGET_MB;
+        config.logging.compress = logging["compress"] | DEFAULT_LOG_COMPRESS;
+    }
+    
+    // Parse Capture config
+    if (doc.containsKey("capture")) {
+        JsonObject capture = doc["capture"];
+        config.capture.enabled = capture["enabled"] | false;
+        config.capture.file_max_kb = capture["file_max_kb"] | DEFAULT_CAPTURE_FILE_MAX_KB;
+        config.capture.max_files = capture["max_files"] | DEFAULT_CAPTURE_MAX_FILES;
     }
     
     configValid = !config.wifi.sta_ssid.isEmpty() && 
                   !config.detection.protected_ssids.empty();
     
-    logger.debugPrintln("Config loaded successfully");
+    LOG_INFO("Config loaded successfully");
     return configValid;
 }
 
 bool ConfigManager::saveConfig(const char* filename) {
-    StaticJsonDocument<2048> doc;
+    BasicJsonDocument<PsramJsonAllocator<MEM_CONFIG>> doc(CONFIG_JSON_CAPACITY);
     
     // WiFi config
     JsonObject wifi = doc.createNestedObject("wifi");
@@ -149,6 +191,11 @@ bool ConfigManager::saveConfig(const char* filename) {
     detection["channel_scan_time_ms"] = config.detection.channel_scan_time_ms;
     detection["channel_hop_interval_ms"] = config.detection.channel_hop_interval_ms;
     
+    // Survey config
+    JsonObject survey = doc.createNestedObject("survey");
+    survey["enabled"] = config.survey.enabled;
+    survey["bucket_seconds"] = config.survey.bucket_seconds;
+    
     // API config
     JsonObject api = doc.createNestedObject("api");
     api["endpoint_url"] = config.api.endpoint_url;
@@ -165,20 +212,40 @@ bool ConfigManager::saveConfig(const char* filename) {
     // Debug config
     JsonObject debug = doc.createNestedObject("debug");
     debug["enabled"] = config.debug.enabled;
+    debug["trace"] = config.debug.trace;
+    
+    // Logging config
+    JsonObject logging = doc.createNestedObject("logging");
+    logging["segment_max_kb"] = config.logging.segment_max_kb;
+    logging["segment_max_minutes"] = config.logging.segment_max_minutes;
+    logging["budget_mb"] = config.logging.budget_mb;
+    logging["compress"] = config.logging.compress;
+    
+    // Capture config
+    JsonObject capture = doc.createNestedObject("capture");
+    capture["enabled"] = config.capture.enabled;
+    capture["file_max_kb"] = config.capture.file_max_kb;
+    capture["max_files"] = config.capture.max_files;
+    
+    // A truncated document would silently drop settings; keep the old file
+    if (doc.overflowed()) {
+        LOG_ERROR("Config too large to save");
+        return false;
+    }
     
     File file = SD.open(filename, FILE_WRITE);
     if (!file) {
-        logger.debugPrintln("Failed to create config file");
+        LOG_ERROR("Failed to create config file");
         return false;
     }
     
     if (serializeJsonPretty(doc, file) == 0) {
-        logger.debugPrintln("Failed to write config");
+        LOG_ERROR("Failed to write config");
         file.close();
         return false;
     }
     
     file.close();
-    logger.debugPrintln("Config saved successfully");
+    LOG_INFO("Config saved successfully");
     return true;
 }
@@ -1,13 +1,16 @@
 #include "DeauthDetector.h"
 #include "Logger.h"
+#include "OuiLookup.h"
+#include "PcapWriter.h"
+#include "Trace.h"
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
 #include <WiFi.h>
-#include <map>
+#include <limits>
+#include <sys/time.h>
 
-// Static instance for callback
-static DeauthDetector* detectorInstance = nullptr;
-static std::map<String, int> ssidPacketCounts;
+template <typename Policy>
+DeauthDetectorCore<Policy>* DeauthDetectorCore<Policy>::instance = nullptr;
 
 // Management frame structure
 typedef struct {
@@ -25,27 +28,78 @@ typedef struct {
     uint8_t payload[0];
 } wifi_ieee80211_packet_t;
 
-DeauthDetector::DeauthDetector()
-    : monitoring(false), currentChannelIndex(0), lastChannelHopTime(0),
-      rawHead(0), rawTail(0)
+// Management frames have no addr4, so the body starts after 24 bytes
+static constexpr int MGMT_HDR_LEN = 24;
+static constexpr int FCS_LEN = 4;
+
+// gettimeofday(); costs the same as time(), which reads the same clock
+static inline int64_t wallClockUs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+template <typename Policy>
+DeauthDetectorCore<Policy>::DeauthDetectorCore()
+    : snapshotDirty(false), overflowPackets(0), monitoring(false), surveyEnabled(false),
+      allowlistedFrames(0), attackFrames(0), rawHead(0), rawTail(0), ssidHead(0), ssidTail(0)
 {
+    memset(ssidSeen, 0, sizeof(ssidSeen));
+    memset(deniedSenders, 0, sizeof(deniedSenders));
+    for (DetectorSnapshot& snap : snapshots) {
+        snap.latestSeq = 0;
+        snap.recentCount = 0;
+        snap.readers.store(0);
+    }
+    published.store(&snapshots[0]);
     mutex = xSemaphoreCreateMutex();
 }
 
-void DeauthDetector::begin(const std::vector<String>& protected_ssids, const DetectionConfig& config) {
-    protectedSSIDs = protected_ssids;
+template <typename Policy>
+void DeauthDetectorCore<Policy>::begin(const std::vector<String>& protected_ssids, const DetectionConfig& config) {
+    ssidMatcher.compile(protected_ssids);
     detectionConfig = config;
-    detectorInstance = this;
+    // Narrow counters saturate, so a larger threshold would never trip
+    if (detectionConfig.packet_threshold > (int)std::numeric_limits<Counter>::max()) {
+        detectionConfig.packet_threshold = std::numeric_limits<Counter>::max();
+        LOG_WARN("packet_threshold capped at %d for the %s preset", detectionConfig.packet_threshold, Policy::NAME);
+    }
+    SsidStats empty = {};
+    ssidStats.assign(ssidMatcher.size(), empty);
+    // Reserve up front so publishing never reallocates
+    for (DetectorSnapshot& snap : snapshots) {
+        snap.ssids.reserve(ssidStats.size());
+    }
+    instance = this;
+    LOG_INFO("Detector preset: %s", Policy::NAME);
+
+    if (!events.begin()) {
+        LOG_ERROR("Failed to allocate event ring");
+    } else {
+        LOG_INFO("Event ring: %u events in %s", (unsigned)events.capacity(),
+                 events.inPsram() ? "PSRAM" : "internal RAM");
+    }
+    if (!trends.begin()) {
+        LOG_WARN("Failed to allocate trend buffers, trends disabled");
+    } else if (protected_ssids.size() > (size_t)TREND_MAX_SSIDS) {
+        LOG_WARN("Trends keep the first %d protected SSIDs; %u more count toward their channels only",
+                 TREND_MAX_SSIDS, (unsigned)(protected_ssids.size() - TREND_MAX_SSIDS));
+    }
     
     // Discover which channels the protected SSIDs are on
     discoverChannels();
+    publishSnapshot();
 }
 
-void DeauthDetector::discoverChannels() {
-    logger.debugPrintln("Discovering channels for protected SSIDs...");
+template <typename Policy>
+void DeauthDetectorCore<Policy>::discoverChannels() {
+    LOG_INFO("Discovering channels for protected SSIDs...");
     activeChannels.clear();
-    ssidChannelMap.clear();
-    bssidToSsidMap.clear();
+    bssidIndex.clear();
+    bssidInfo.clear();
+    bssidInfo.reserve(BssidTable::CAPACITY);
+    bssidKeys.clear();
+    bssidKeys.reserve(BssidTable::CAPACITY);
     
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
@@ -60,43 +114,45 @@ void DeauthDetector::discoverChannels() {
             String ssid = WiFi.SSID(i);
             String bssid = WiFi.BSSIDstr(i);
 
-            // Always store BSSID→SSID for later lookup
-            if (!ssid.isEmpty()) {
-                bssidToSsidMap[bssid] = ssid;
+            // Hidden networks have no name to match against yet; their SSID is
+            // learned later from probe responses and association requests
+            if (ssid.isEmpty()) {
+                LOG_DEBUG("Hidden network %s on channel %d", bssid.c_str(), channel);
+                continue;
             }
 
-            for (const String& protected_ssid : protectedSSIDs) {
-                if (ssid == protected_ssid) {
-                    // Store the SSID to channel mapping
-                    ssidChannelMap[ssid] = channel;
-                    
-                    bool found = false;
-                    for (int ch : activeChannels) {
-                        if (ch == channel) {
-                            found = true;
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        activeChannels.push_back(channel);
+            // Always store BSSID→SSID for later lookup
+            setBssidName(WiFi.BSSID(i), ssid);
+
+            int index = ssidMatcher.match(ssid);
+            if (index != SSIDMatcher::NO_MATCH) {
+                // Store the channel against the configured entry (which may be a pattern)
+                noteChannel(index, channel);
+                
+                bool found = false;
+                for (int ch : activeChannels) {
+                    if (ch == channel) {
+                        found = true;
+                        break;
                     }
-                    char buf[64];
-                    snprintf(buf, sizeof(buf), "Found '%s' on channel %d", ssid.c_str(), channel);
-                    logger.debugPrintln(buf);
                 }
+                if (!found) {
+                    activeChannels.push_back(channel);
+                }
+                LOG_INFO("Found '%s' on channel %d", ssid.c_str(), channel);
             }
         }
     }
     
     if (activeChannels.empty()) {
-        logger.debugPrintln("Warning: No protected SSIDs found.");
+        LOG_WARN("No protected SSIDs found.");
         if (detectionConfig.detect_all_deauth) {
-            logger.debugPrintln("detect_all_deauth enabled: Monitoring all channels.");
+            LOG_INFO("detect_all_deauth enabled: Monitoring all channels.");
             for (int i = 1; i <= 14; i++) {
                 activeChannels.push_back(i);
             }
         } else {
-            logger.debugPrintln("detect_all_deauth disabled: No channels to monitor.");
+            LOG_WARN("detect_all_deauth disabled: No channels to monitor.");
         }
     }
     
@@ -104,25 +160,26 @@ void DeauthDetector::discoverChannels() {
     for (int ch : activeChannels) {
         channelList += String(ch) + " ";
     }
-    logger.debugPrintln(channelList);
+    LOG_INFO("%s", channelList.c_str());
 }
 
-void DeauthDetector::startMonitoring() {
+template <typename Policy>
+void DeauthDetectorCore<Policy>::startMonitoring() {
     if (monitoring) return;
     
-    logger.debugPrintln("Starting packet monitoring...");
+    LOG_INFO("Starting packet monitoring...");
     
     WiFi.disconnect();
     delay(100);
     
     esp_wifi_set_mode(WIFI_MODE_NULL);
     esp_wifi_start();
+    applyPromiscuousFilter();
     esp_wifi_set_promiscuous(true);
-    esp_wifi_set_promiscuous_rx_cb(&DeauthDetector::packetHandler);
+    esp_wifi_set_promiscuous_rx_cb(&DeauthDetectorCore::packetHandler);
     
     // Initialize channel hopping
-    currentChannelIndex = 0;
-    lastChannelHopTime = millis();
+    hopScheduler.reset(millis());
     if (!activeChannels.empty()) {
         esp_wifi_set_channel(activeChannels[0], WIFI_SECOND_CHAN_NONE);
     }
@@ -130,180 +187,556 @@ void DeauthDetector::startMonitoring() {
     monitoring = true;
 }
 
-void DeauthDetector::stopMonitoring() {
+template <typename Policy>
+void DeauthDetectorCore<Policy>::stopMonitoring() {
     if (!monitoring) return;
     
-    logger.debugPrintln("Stopping packet monitoring...");
+    LOG_INFO("Stopping packet monitoring...");
     
     esp_wifi_set_promiscuous(false);
     monitoring = false;
 }
 
-void DeauthDetector::updateChannelHop() {
+template <typename Policy>
+void DeauthDetectorCore<Policy>::enableSurvey(const SurveyConfig& config) {
+    if (!Policy::SURVEY && config.enabled) {
+        LOG_WARN("Survey is not built into the %s preset", Policy::NAME);
+    }
+    surveyEnabled = Policy::SURVEY && config.enabled;
+    survey.begin(config.bucket_seconds * 1000UL);
+    if (monitoring) {
+        applyPromiscuousFilter();
+    }
+}
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::applyPromiscuousFilter() {
+    // Detection only needs management frames; the survey counts everything
+    wifi_promiscuous_filter_t filter;
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+    if (isSurveyEnabled()) {
+        filter.filter_mask |= WIFI_PROMIS_FILTER_MASK_DATA | WIFI_PROMIS_FILTER_MASK_CTRL;
+    }
+    esp_wifi_set_promiscuous_filter(&filter);
+}
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::updateChannelHop() {
     if (!monitoring || activeChannels.empty()) return;
 
     // Drain ISR ring buffer into events (main-loop context)
     processRawEvents();
     
     unsigned long currentTime = millis();
-    if (currentTime - lastChannelHopTime >= detectionConfig.channel_hop_interval_ms) {
-        currentChannelIndex = (currentChannelIndex + 1) % activeChannels.size();
-        esp_wifi_set_channel(activeChannels[currentChannelIndex], WIFI_SECOND_CHAN_NONE);
-        lastChannelHopTime = currentTime;
+    if constexpr (Policy::SURVEY) {
+        if (surveyEnabled) {
+            survey.update(currentTime);
+        }
+    }
+
+    HopStep step = hopScheduler.poll(currentTime, activeChannels.size(),
+                                     detectionConfig.channel_hop_interval_ms);
+    if (step.hop) {
+        if constexpr (Policy::SURVEY) {
+            if (surveyEnabled) {
+                survey.addDwell(activeChannels[step.from], step.dwellMs);
+            }
+        }
+        esp_wifi_set_channel(activeChannels[step.to], WIFI_SECOND_CHAN_NONE);
+        TRACE(TRACE_HOP, activeChannels[step.to]);
     }
 }
 
-void DeauthDetector::packetHandler(void* buf, wifi_promiscuous_pkt_type_t type) {
-    if (!detectorInstance || type != WIFI_PKT_MGMT) return;
+template <typename Policy>
+void DeauthDetectorCore<Policy>::packetHandler(void* buf, wifi_promiscuous_pkt_type_t type) {
+    if (!instance) return;
     
     const wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
     const wifi_ieee80211_packet_t* ipkt = (wifi_ieee80211_packet_t*)pkt->payload;
     const wifi_ieee80211_mac_hdr_t* hdr = &ipkt->hdr;
     
+    if constexpr (Policy::SURVEY) {
+        if (instance->surveyEnabled) {
+            // Retry flag is bit 11 of frame control
+            instance->survey.record(pkt->rx_ctrl.channel, type == WIFI_PKT_MGMT,
+                                    (hdr->frame_ctrl & 0x0800) != 0, pkt->rx_ctrl.rssi);
+        }
+    }
+    
+    if (type != WIFI_PKT_MGMT) return;
+    
     // Extract frame type (bits 3:2) and subtype (bits 7:4)
     uint8_t frameType    = (hdr->frame_ctrl >> 2) & 0x03;
     uint8_t frameSubtype = (hdr->frame_ctrl >> 4) & 0x0F;
     
-    // Deauth = Management (type 0x00), subtype 0x0C
-    if (frameType == 0x00 && frameSubtype == 0x0C) {
+    if (frameType != 0x00) return;
+
+    // Frames that carry the SSID of a (possibly hidden) AP in their body:
+    // assoc request (0x0), reassoc request (0x2), probe response (0x5)
+    if constexpr (Policy::LEARN_SSIDS) {
+        if (frameSubtype == 0x00 || frameSubtype == 0x02 || frameSubtype == 0x05) {
+            TRACE(TRACE_SSID_FRAME, pkt->rx_ctrl.channel, frameSubtype, TRACE_MAC(hdr->addr3));
+            // Fixed fields before the tagged parameters
+            int fixedLen = frameSubtype == 0x05 ? 12 : (frameSubtype == 0x02 ? 10 : 4);
+            int bodyLen = (int)pkt->rx_ctrl.sig_len - MGMT_HDR_LEN - FCS_LEN - fixedLen;
+            if (bodyLen > 2) {
+                instance->captureSsid(hdr->addr3, pkt->payload + MGMT_HDR_LEN + fixedLen,
+                                      bodyLen, pkt->rx_ctrl.channel);
+            }
+            return;
+        }
+    }
+    
+    // Deauth (0x0C) and, if the preset asks for it, disassoc (0x0A); both
+    // start their body with a reason code
+    if ((Policy::DETECT_SUBTYPES >> frameSubtype) & 1) {
+        // The frame itself, for Wireshark; independent of the ring below
+        if (pcapWriter.isActive()) {
+            pcapWriter.capture(pkt->payload, pkt->rx_ctrl.sig_len, pkt->rx_ctrl.channel,
+                               pkt->rx_ctrl.rssi, pkt->rx_ctrl.timestamp);
+        }
+
         // Store raw capture into lock-free ring buffer (single-producer from WiFi task)
-        size_t nextHead = (detectorInstance->rawHead + 1) % RAW_RING_SIZE;
-        if (nextHead == detectorInstance->rawTail) {
+        size_t nextHead = (instance->rawHead + 1) % Policy::RAW_RING_SIZE;
+        if (nextHead == instance->rawTail) {
+            TRACE(TRACE_CAPTURE_FULL, TRACE_MAC(hdr->addr2));
             return; // Ring full — drop oldest-overwrite not safe without lock; just drop
         }
 
-        RawDeauthCapture& cap = detectorInstance->rawRing[detectorInstance->rawHead];
+        RawDeauthCapture& cap = instance->rawRing[instance->rawHead];
+        memcpy(cap.addr1, hdr->addr1, 6);
         memcpy(cap.addr2, hdr->addr2, 6);
         memcpy(cap.addr3, hdr->addr3, 6);
+        cap.subtype   = frameSubtype;
+        const uint8_t* body = pkt->payload + MGMT_HDR_LEN;
+        cap.reason    = pkt->rx_ctrl.sig_len >= MGMT_HDR_LEN + 2 + FCS_LEN ? (body[0] | (body[1] << 8)) : 0;
+        cap.seq       = hdr->sequence_ctrl >> 4;
+        cap.rxUs      = pkt->rx_ctrl.timestamp;
+        cap.listed    = instance->allowlist.contains(hdr->addr2) ? MAC_ALLOWLISTED
+                      : instance->denylist.contains(hdr->addr2) ? MAC_DENYLISTED
+                      : MAC_UNLISTED;
         cap.channel   = pkt->rx_ctrl.channel;
         cap.rssi      = pkt->rx_ctrl.rssi;
-        cap.timestamp  = time(nullptr);
+        if constexpr (Policy::TIMESTAMPS == STAMP_PER_FRAME) {
+            cap.timeUs = wallClockUs();
+        }
+        TRACE(TRACE_CAPTURE, cap.channel, cap.rssi, cap.subtype, cap.reason, TRACE_MAC(cap.addr2));
 
-        detectorInstance->rawHead = nextHead;
+        instance->rawHead = nextHead;
     }
 }
 
-void DeauthDetector::processRawEvents() {
-    if (rawHead == rawTail) return;  // nothing to drain
+template <typename Policy>
+void DeauthDetectorCore<Policy>::captureSsid(const uint8_t* bssid, const uint8_t* ies, int len, int channel) {
+    // SSID is element ID 0 and comes first in all three frame types
+    if (ies[0] != 0x00) return;
+    uint8_t ssidLen = ies[1];
+    if (ssidLen == 0 || ssidLen > 32 || ssidLen + 2 > len) return;
+
+    // Hidden-network beacons zero-fill the SSID; those tell us nothing
+    const char* ssid = (const char*)(ies + 2);
+    bool blank = true;
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < ssidLen; i++) {
+        if (ssid[i] != 0) blank = false;
+        h = (h ^ (uint8_t)ssid[i]) * 16777619u;
+    }
+    if (blank) return;
 
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) != pdTRUE) return;
+    // Skip APs whose SSID we've already queued
+    SeenSsid& seen = ssidSeen[(bssid[3] ^ bssid[4] ^ bssid[5]) % SSID_SEEN_SLOTS];
+    if (seen.ssidHash == h && memcmp(seen.bssid, bssid, 6) == 0) return;
 
-    while (rawTail != rawHead) {
-        const RawDeauthCapture& cap = rawRing[rawTail];
-        rawTail = (rawTail + 1) % RAW_RING_SIZE;
+    size_t nextHead = (ssidHead + 1) % Policy::SSID_RING_SIZE;
+    if (nextHead == ssidTail) return;  // ring full; the AP will be heard again
+
+    RawSsidCapture& cap = ssidRing[ssidHead];
+    memcpy(cap.bssid, bssid, 6);
+    memcpy(cap.ssid, ssid, ssidLen);
+    cap.len = ssidLen;
+    cap.channel = channel;
+    ssidHead = nextHead;
+
+    memcpy(seen.bssid, bssid, 6);
+    seen.ssidHash = h;
+}
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::processRawSsids() {
+    while (ssidTail != ssidHead) {
+        const RawSsidCapture& cap = ssidRing[ssidTail];
 
-        // Format MAC strings
         char bssid[18];
         snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
-                cap.addr3[0], cap.addr3[1], cap.addr3[2],
-                cap.addr3[3], cap.addr3[4], cap.addr3[5]);
+                cap.bssid[0], cap.bssid[1], cap.bssid[2],
+                cap.bssid[3], cap.bssid[4], cap.bssid[5]);
+
+        char name[33];
+        memcpy(name, cap.ssid, cap.len);
+        name[cap.len] = '\0';
+        int channel = cap.channel;
+        ssidTail = (ssidTail + 1) % Policy::SSID_RING_SIZE;
+
+        String ssid = String(name);
+        if (!setBssidName(cap.bssid, ssid)) {
+            continue;
+        }
 
-        char sender[18];
-        snprintf(sender, sizeof(sender), "%02X:%02X:%02X:%02X:%02X:%02X",
-                cap.addr2[0], cap.addr2[1], cap.addr2[2],
-                cap.addr2[3], cap.addr2[4], cap.addr2[5]);
+        LOG_DEBUG("Resolved SSID '%s' for BSSID %s on channel %d", name, bssid, channel);
 
-        String bssidStr = String(bssid);
-        String senderStr = String(sender);
+        // A hidden network that turns out to be protected gets its channel recorded
+        noteChannel(ssidMatcher.match(ssid), channel);
+    }
+}
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::processRawEvents() {
+    if (rawHead == rawTail && ssidHead == ssidTail && !snapshotDirty) return;  // nothing to drain
+
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) != pdTRUE) return;
+
+    // Learn SSIDs first so deauths in this batch already resolve
+    processRawSsids();
+
+    uint32_t drainStart = micros();
+    uint32_t drained = 0;
+    int64_t drainTime = 0;
+    if constexpr (Policy::TIMESTAMPS == STAMP_PER_DRAIN) {
+        drainTime = wallClockUs();
+    }
 
-        // Per-BSSID packet threshold
-        if (ssidPacketCounts[bssidStr] >= detectionConfig.packet_threshold) {
-            continue;  // threshold reached for this BSSID
+    while (rawTail != rawHead) {
+        // Gather a batch into MAC columns, then hash and resolve BSSIDs for
+        // the whole batch at once
+        RawDeauthCapture batch[MAC_BATCH_MAX];
+        MacColumn bssids;
+        size_t n = 0;
+        while (n < MAC_BATCH_MAX && rawTail != rawHead) {
+            batch[n] = rawRing[rawTail];
+            rawTail = (rawTail + 1) % Policy::RAW_RING_SIZE;
+            if constexpr (Policy::TIMESTAMPS == STAMP_PER_DRAIN) {
+                batch[n].timeUs = drainTime;
+            }
+            macSplit(batch[n].addr3, bssids.hi[n], bssids.lo[n]);
+            n++;
         }
-        ssidPacketCounts[bssidStr]++;
 
-        // BSSID → SSID lookup
-        String ssidName = "Unknown";
-        auto it = bssidToSsidMap.find(bssidStr);
-        if (it != bssidToSsidMap.end()) {
-            ssidName = it->second;
+        uint32_t hashes[MAC_BATCH_MAX];
+        int entries[MAC_BATCH_MAX];
+        macHashBatch(bssids, n, hashes);
+        bssidIndex.findBatch(bssids, n, hashes, entries);
+
+        for (size_t i = 0; i < n; i++) {
+            int entry = entries[i];
+            if (entry == BssidTable::NOT_FOUND) {
+                entry = bssidEntry(batch[i].addr3);
+            }
+            processCapture(batch[i], entry);
         }
+        drained += n;
+    }
+    if (drained > 0) {
+        TRACE(TRACE_DRAIN, drained, micros() - drainStart);
+    }
+
+    publishSnapshot();
+    xSemaphoreGive(mutex);
+}
 
-        DeauthEvent event;
-        event.timestamp    = cap.timestamp;
-        event.target_ssid  = ssidName;
-        event.target_bssid = bssidStr;
-        event.attacker_mac = senderStr;
-        event.channel      = cap.channel;
-        event.rssi         = cap.rssi;
-        event.packet_count = ssidPacketCounts[bssidStr];
+template <typename Policy>
+bool DeauthDetectorCore<Policy>::deniedSenderDue(const uint8_t* mac, uint32_t second) {
+    uint32_t hi, lo;
+    macSplit(mac, hi, lo);
+    uint64_t key = ((uint64_t)hi << 16) | lo;
+    DeniedSender& slot = deniedSenders[macHash(hi, lo) % DENIED_SENDER_SLOTS];
+    if (slot.mac == key && slot.second == second) {
+        return false;
+    }
+    slot.mac = key;
+    slot.second = second;
+    return true;
+}
 
-        events.push_back(event);
+// One capture, after its BSSID was resolved; entry is -1 if the BSSID
+// table is full. Strings are only built for frames that become events.
+template <typename Policy>
+void DeauthDetectorCore<Policy>::processCapture(const RawDeauthCapture& cap, int entry) {
+    BssidInfo* info = entry >= 0 ? &bssidInfo[entry] : nullptr;
+    int protectedIndex = info ? info->protectedIndex : ssidMatcher.match("Unknown");
+
+    // Trends count every frame, including allowlisted ones
+    time_t seconds = (time_t)(cap.timeUs / 1000000);
+    trends.record(seconds, protectedIndex, cap.channel);
+
+    // Our own infrastructure deauthing clients is not an attack
+    if (cap.listed == MAC_ALLOWLISTED) {
+        allowlistedFrames++;
+        return;
+    }
+    // Counted before the threshold, which only limits events
+    attackFrames++;
+    if (protectedIndex >= 0) {
+        ssidStats[protectedIndex].frames++;
+    }
 
-        char logBuf[128];
-        snprintf(logBuf, sizeof(logBuf), "Deauth detected: BSSID=%s, Sender=%s, Ch=%d, RSSI=%d",
-                 bssid, sender, cap.channel, cap.rssi);
-        logger.debugPrintln(logBuf);
+    // Fingerprint every frame, including ones past the threshold: more
+    // evidence only sharpens the match
+    uint8_t confidence = 0;
+    int tool = fingerprinter.update(cap.addr2, cap.addr1, cap.reason, cap.seq, cap.rxUs, confidence);
+
+    // Per-BSSID packet threshold; known-hostile senders bypass it, so
+    // their first frame alerts, but are held to one event a second
+    bool denied = cap.listed == MAC_DENYLISTED;
+    Counter& packets = info ? info->packets : overflowPackets;
+    if (denied ? !deniedSenderDue(cap.addr2, (uint32_t)seconds)
+               : packets >= (uint32_t)detectionConfig.packet_threshold) {
+        return;  // threshold reached for this BSSID, or this sender's second used
+    }
+    if (packets < std::numeric_limits<Counter>::max()) {
+        packets++;
     }
 
-    xSemaphoreGive(mutex);
+    DeauthEvent event;
+    event.timestamp    = seconds;
+    event.timestamp_us = cap.timeUs;
+    strlcpy(event.target_ssid, info ? info->ssid.c_str() : "Unknown", sizeof(event.target_ssid));
+    snprintf(event.target_bssid, sizeof(event.target_bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+             cap.addr3[0], cap.addr3[1], cap.addr3[2], cap.addr3[3], cap.addr3[4], cap.addr3[5]);
+    snprintf(event.attacker_mac, sizeof(event.attacker_mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             cap.addr2[0], cap.addr2[1], cap.addr2[2], cap.addr2[3], cap.addr2[4], cap.addr2[5]);
+    event.channel      = cap.channel;
+    event.rssi         = cap.rssi;
+    event.packet_count = packets;
+    event.protected_index = protectedIndex;
+    strlcpy(event.tool, tool >= 0 ? fingerprinter.signatureName(tool).c_str() : "", sizeof(event.tool));
+    event.tool_confidence = confidence;
+    event.denylisted   = denied;
+    event.vendor       = ouiLookup(cap.addr2);
+    event.randomized   = macIsRandomized(cap.addr2);
+
+    event.seq = events.push(event);
+    TRACE(TRACE_EVENT, (uint32_t)event.seq, cap.channel, event.packet_count, TRACE_MAC(cap.addr2));
+
+    if (event.protected_index >= 0) {
+        SsidStats& stats = ssidStats[event.protected_index];
+        stats.events++;
+        stats.last = event;
+        noteChannel(event.protected_index, event.channel);
+    }
+
+    LOG_DEBUG("%s detected: BSSID=%s, Sender=%s, Ch=%d, RSSI=%d",
+              cap.subtype == 0x0A ? "Disassoc" : "Deauth",
+              event.target_bssid, event.attacker_mac, cap.channel, cap.rssi);
 }
 
-bool DeauthDetector::hasEvents() {
-    bool result = false;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        result = !events.empty();
-        xSemaphoreGive(mutex);
+// Entry for a BSSID, adding it as "Unknown" on first sight. -1 when full.
+template <typename Policy>
+int DeauthDetectorCore<Policy>::bssidEntry(const uint8_t* mac) {
+    uint32_t hi, lo;
+    macSplit(mac, hi, lo);
+    uint32_t hash = macHash(hi, lo);
+    int entry = bssidIndex.find(hash, hi, lo);
+    if (entry != BssidTable::NOT_FOUND) {
+        return entry;
     }
-    return result;
+
+    entry = bssidIndex.insert(hash, hi, lo, bssidInfo.size());
+    if (entry == BssidTable::NOT_FOUND) {
+        return entry;
+    }
+    BssidInfo info;
+    info.ssid = "Unknown";
+    info.protectedIndex = ssidMatcher.match(info.ssid);
+    info.packets = 0;
+    bssidInfo.push_back(info);
+    bssidKeys.push_back(((uint64_t)hi << 16) | lo);
+    return entry;
 }
 
-std::vector<DeauthEvent> DeauthDetector::getEvents() {
-    std::vector<DeauthEvent> copy;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        copy = events;
-        xSemaphoreGive(mutex);
+// Records the SSID for a BSSID; false if it was already known by that name
+template <typename Policy>
+bool DeauthDetectorCore<Policy>::setBssidName(const uint8_t* mac, const String& ssid) {
+    if (!mac) return false;
+    int entry = bssidEntry(mac);
+    if (entry < 0 || bssidInfo[entry].ssid == ssid) {
+        return false;
     }
-    return copy;
+    bssidInfo[entry].ssid = ssid;
+    bssidInfo[entry].protectedIndex = ssidMatcher.match(ssid);
+    return true;
 }
-int DeauthDetector::getChannelForSSID(const String& ssid) {
-    // Check stored mapping from startup discovery
-    auto it = ssidChannelMap.find(ssid);
-    if (it != ssidChannelMap.end()) {
-        return it->second;
+
+// Called with the mutex held (or before monitoring starts)
+template <typename Policy>
+void DeauthDetectorCore<Policy>::publishSnapshot() {
+    DetectorSnapshot* current = published.load();
+    DetectorSnapshot* next = nullptr;
+    for (DetectorSnapshot& snap : snapshots) {
+        if (&snap != current && snap.readers.load() == 0) {
+            next = &snap;
+            break;
+        }
     }
-    
-    // If not found in map, check if we have it from recent events
-    for (const DeauthEvent& event : events) {
-        if (event.target_ssid == ssid && event.channel > 0) {
-            return event.channel;
+    if (!next) {
+        // Readers hold both spare buffers; try again on the next drain
+        snapshotDirty = true;
+        return;
+    }
+
+    next->latestSeq = events.latestSeq();
+    next->ssids = ssidStats;
+    next->recentCount = events.readLatest(next->recent, SNAPSHOT_RECENT);
+    published.store(next);
+    snapshotDirty = false;
+}
+
+template <typename Policy>
+const DetectorSnapshot* DeauthDetectorCore<Policy>::acquireSnapshot() const {
+    for (;;) {
+        DetectorSnapshot* snap = published.load();
+        snap->readers.fetch_add(1);
+        // If a publish swapped the pointer meanwhile, the writer may already
+        // be refilling this buffer; let go and take the new one
+        if (published.load() == snap) {
+            return snap;
         }
+        snap->readers.fetch_sub(1);
     }
-    
-    return 0; // Not found
 }
-void DeauthDetector::clearEvents() {
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        events.clear();
-        ssidPacketCounts.clear();
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::releaseSnapshot(const DetectorSnapshot* snapshot) const {
+    snapshot->readers.fetch_sub(1);
+}
+
+// Cursor operations wait for the mutex rather than returning an empty
+// batch; it is only ever held for a short copy or drain.
+template <typename Policy>
+size_t DeauthDetectorCore<Policy>::readEvents(EventConsumer consumer, DeauthEvent* out, size_t max, uint64_t* lost) {
+    size_t n = 0;
+    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+        uint64_t before = events.lost(consumer);
+        n = events.read(consumer, out, max);
+        if (lost) {
+            *lost = events.lost(consumer) - before;
+        }
         xSemaphoreGive(mutex);
     }
+    return n;
 }
 
-int DeauthDetector::getEventCountForSSID(const String& ssid) {
-    int count = 0;
-    for (const DeauthEvent& event : events) {
-        if (event.target_ssid == ssid) {
-            count++;
-        }
+template <typename Policy>
+void DeauthDetectorCore<Policy>::ackEvents(EventConsumer consumer) {
+    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+        events.ack(consumer);
+        xSemaphoreGive(mutex);
     }
-    return count;
 }
 
-DeauthEvent DeauthDetector::getLastEventForSSID(const String& ssid) {
-    for (int i = events.size() - 1; i >= 0; i--) {
-        if (events[i].target_ssid == ssid) {
-            return events[i];
-        }
+template <typename Policy>
+void DeauthDetectorCore<Policy>::rewindEvents(EventConsumer consumer) {
+    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+        events.rewind(consumer);
+        xSemaphoreGive(mutex);
+    }
+}
+
+template <typename Policy>
+uint64_t DeauthDetectorCore<Policy>::pendingEvents(EventConsumer consumer) {
+    uint64_t n = 0;
+    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+        n = events.pending(consumer);
+        xSemaphoreGive(mutex);
+    }
+    return n;
+}
+
+template <typename Policy>
+size_t DeauthDetectorCore<Policy>::getRecentEvents(DeauthEvent* out, size_t max) {
+    SnapshotRef snap(*this);
+    size_t n = 0;
+    for (; n < max && n < snap->recentCount; n++) {
+        out[n] = snap->recent[n];
     }
-    return DeauthEvent(); // Return empty event if not found
+    return n;
 }
 
-bool DeauthDetector::isProtectedSSID(const String& ssid) {
-    for (const String& protected_ssid : protectedSSIDs) {
-        if (ssid == protected_ssid) {
-            return true;
+template <typename Policy>
+uint64_t DeauthDetectorCore<Policy>::getLatestSeq() {
+    SnapshotRef snap(*this);
+    return snap->latestSeq;
+}
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::clearEvents() {
+    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+        // History stays in the ring for consumers that haven't caught up
+        overflowPackets = 0;
+        if (bssidIndex.size() > BssidTable::CAPACITY / 2) {
+            // Random-BSSID floods fill the table with throwaway entries;
+            // keep only networks whose SSID we know
+            PsramVector<BssidInfo, MEM_BSSIDS> named;
+            PsramVector<uint64_t, MEM_BSSIDS> keys;
+            for (size_t i = 0; i < bssidKeys.size(); i++) {
+                if (bssidInfo[i].ssid != "Unknown") {
+                    named.push_back(bssidInfo[i]);
+                    keys.push_back(bssidKeys[i]);
+                }
+            }
+            bssidIndex.clear();
+            bssidInfo.clear();
+            bssidKeys.clear();
+            for (size_t i = 0; i < named.size(); i++) {
+                uint32_t hi = keys[i] >> 16;
+                uint32_t lo = keys[i] & 0xFFFF;
+                bssidIndex.insert(macHash(hi, lo), hi, lo, bssidInfo.size());
+                bssidInfo.push_back(named[i]);
+                bssidKeys.push_back(keys[i]);
+            }
+        }
+        for (BssidInfo& info : bssidInfo) {
+            info.packets = 0;
+        }
+        for (SsidStats& stats : ssidStats) {
+            stats.events = 0;
         }
+        publishSnapshot();
+        xSemaphoreGive(mutex);
+    }
+}
+
+template <typename Policy>
+bool DeauthDetectorCore<Policy>::getSsidStats(size_t index, SsidStats& out) const {
+    SnapshotRef snap(*this);
+    if (index >= snap->ssids.size()) {
+        return false;
+    }
+    out = snap->ssids[index];
+    return true;
+}
+
+// First channel an entry is seen on wins
+template <typename Policy>
+void DeauthDetectorCore<Policy>::noteChannel(int index, int channel) {
+    if (index >= 0 && (size_t)index < ssidStats.size() && ssidStats[index].channel == 0) {
+        ssidStats[index].channel = channel;
     }
-    return false;
 }
+
+template <typename Policy>
+void DeauthDetectorCore<Policy>::loadMacLists(const char* allowPath, const char* denyPath) {
+    if (allowlist.load(allowPath)) {
+        LOG_INFO("Allowlist: %u MACs", (unsigned)allowlist.size());
+    }
+    if (denylist.load(denyPath)) {
+        LOG_INFO("Denylist: %u MACs", (unsigned)denylist.size());
+    }
+}
+
+template <typename Policy>
+bool DeauthDetectorCore<Policy>::isProtectedSSID(const String& ssid) {
+    return ssidMatcher.matches(ssid);
+}
+
+// The only specialization this firmware uses
+template class DeauthDetectorCore<ActiveDetectorPolicy>;
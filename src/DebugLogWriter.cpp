@@ -0,0 +1,214 @@
+#include "DebugLogWriter.h"
+#include "PsramAllocator.h"
+#include "Trace.h"
+#include <SD.h>
+#include <time.h>
+
+static const char LEVEL_TAGS[] = "DIWE";
+
+DebugLogWriter::DebugLogWriter()
+    : compress(false), batch(nullptr), fileLock(nullptr), task(nullptr), fileEnabled(false), traceOutput(TRACE_OUTPUT_OFF),
+      queued(0), dropped(0), written(0), writeErrors(0), traceRecords(0), traceLost(0) {}
+
+bool DebugLogWriter::begin(const char* filePath, bool compressFile) {
+    if (task) {
+        return false;
+    }
+    path = filePath;
+    compress = compressFile;
+    void* slots = memAlloc(MEM_LOGS, ring.bytes());
+    batch = (char*)memAlloc(MEM_LOGS, DEBUG_LOG_BATCH);
+    fileLock = xSemaphoreCreateMutex();
+    if (!slots || !batch || !fileLock) {
+        return false;
+    }
+    ring.begin(slots);
+    // Same place as the session writer: core 0, below WiFi
+    return xTaskCreatePinnedToCore(taskEntry, "debuglog", 4096, this, 1, &task, 0) == pdPASS;
+}
+
+bool DebugLogWriter::setTraceOutput(TraceOutput output, const char* filePath) {
+    tracePath = filePath;
+    if (output == TRACE_OUTPUT_SD) {
+        File file = SD.open(tracePath.c_str(), FILE_WRITE);
+        if (!file) {
+            return false;
+        }
+        file.close();
+    }
+    traceOutput.store(output);
+    return output == TRACE_OUTPUT_OFF || traceBegin();
+}
+
+bool DebugLogWriter::write(uint8_t level, const char* fmt, va_list args) {
+    if (!task) {
+        char text[DEBUG_LOG_LINE];
+        vsnprintf(text, sizeof(text), fmt, args);
+        Serial.println(text);
+        return true;
+    }
+
+    uint32_t pos;
+    Line* line = ring.claim(pos);
+    if (!line) {
+        dropped.fetch_add(1);
+        return false;
+    }
+    line->level = level;
+    line->ms = millis();
+    vsnprintf(line->text, sizeof(line->text), fmt, args);
+    ring.publish(pos);
+    queued.fetch_add(1);
+    return true;
+}
+
+bool DebugLogWriter::resetFile(const char* banner) {
+    if (fileLock) {
+        xSemaphoreTake(fileLock, portMAX_DELAY);
+    }
+    bool ok;
+    if (compress) {
+        ok = packed.begin(path.c_str());
+        String line = String(banner) + "\r\n";
+        uint32_t now = (uint32_t)time(nullptr);
+        packed.append(line.c_str(), line.length(), now, now);
+        ok = ok && packed.flush();
+    } else {
+        File file = SD.open(path.c_str(), FILE_WRITE);
+        ok = (bool)file;
+        if (file) {
+            file.println(banner);
+            file.close();
+        }
+    }
+    if (fileLock) {
+        xSemaphoreGive(fileLock);
+    }
+    return ok;
+}
+
+DebugLogStats DebugLogWriter::getStats() const {
+    DebugLogStats stats;
+    stats.queued = queued.load();
+    stats.dropped = dropped.load();
+    stats.written = written.load();
+    stats.writeErrors = writeErrors.load();
+    stats.traceRecords = traceRecords.load();
+    stats.traceDropped = traceLost.load();
+    return stats;
+}
+
+void DebugLogWriter::taskEntry(void* arg) {
+    static_cast<DebugLogWriter*>(arg)->run();
+}
+
+void DebugLogWriter::run() {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(DEBUG_LOG_DRAIN_MS));
+        drain();
+        drainTrace();
+    }
+}
+
+void DebugLogWriter::drain() {
+    size_t len = 0;
+    uint32_t lines = 0;
+    for (const Line* line = ring.peek(); line; line = ring.peek()) {
+        if (DEBUG_LOG_BATCH - len < DEBUG_LOG_LINE + 24) {
+            output(len);
+            written.fetch_add(lines);
+            len = 0;
+            lines = 0;
+        }
+        int n = snprintf(batch + len, DEBUG_LOG_BATCH - len, "[%lu.%03lu] %c %s\r\n",
+                         (unsigned long)(line->ms / 1000), (unsigned long)(line->ms % 1000),
+                         LEVEL_TAGS[line->level & 3], line->text);
+        len += n > 0 ? (size_t)n : 0;
+        lines++;
+        ring.release();
+    }
+    if (len > 0) {
+        output(len);
+        written.fetch_add(lines);
+    }
+}
+
+// Trace records become COBS frames (TraceFormat.h) in the same batch
+// buffer, after the text lines have gone out. Each batch starts with a
+// delimiter so that on Serial the text before it is a chunk of its own.
+void DebugLogWriter::drainTrace() {
+    TraceOutput out = traceOutput.load();
+    if (out == TRACE_OUTPUT_OFF) {
+        return;
+    }
+    uint8_t frame[TRACE_FRAME_MAX];
+    size_t len = 0;
+    uint32_t records = 0;
+    uint32_t lost = traceDropped.exchange(0);
+    if (lost > 0) {
+        // Reported in the stream itself, so a decoded trace shows its gaps
+        TraceRecord note = {};
+        note.timeUs = (uint32_t)micros();
+        note.id = TRACE_DROPPED;
+        note.argCount = 1;
+        note.args[0] = lost;
+        batch[len++] = 0;
+        len += traceCobsEncode(frame, tracePack(note, frame), (uint8_t*)batch + len);
+        traceLost.fetch_add(lost);
+    }
+    for (const TraceRecord* r = traceRing.peek(); r; r = traceRing.peek()) {
+        if (DEBUG_LOG_BATCH - len < TRACE_WIRE_MAX + 1) {
+            outputTrace(len);
+            len = 0;
+        }
+        if (len == 0) {
+            batch[len++] = 0;
+        }
+        len += traceCobsEncode(frame, tracePack(*r, frame), (uint8_t*)batch + len);
+        records++;
+        traceRing.release();
+    }
+    if (len > 0) {
+        outputTrace(len);
+    }
+    traceRecords.fetch_add(records);
+}
+
+void DebugLogWriter::output(size_t len) {
+    Serial.write((const uint8_t*)batch, len);
+    if (!fileEnabled.load()) {
+        return;
+    }
+    xSemaphoreTake(fileLock, portMAX_DELAY);
+    if (compress) {
+        // The batch ends with a newline, so it is whole lines
+        uint32_t now = (uint32_t)time(nullptr);
+        packed.append(batch, len, now, now);
+        if (!packed.flush()) {
+            writeErrors.fetch_add(1);
+        }
+    } else {
+        File file = SD.open(path.c_str(), FILE_APPEND);
+        if (!file || file.write((const uint8_t*)batch, len) != len) {
+            writeErrors.fetch_add(1);
+        }
+        if (file) {
+            file.close();
+        }
+    }
+    xSemaphoreGive(fileLock);
+}
+
+void DebugLogWriter::outputTrace(size_t len) {
+    if (traceOutput.load() == TRACE_OUTPUT_SERIAL) {
+        Serial.write((const uint8_t*)batch, len);
+        return;
+    }
+    File file = SD.open(tracePath.c_str(), FILE_APPEND);
+    if (!file || file.write((const uint8_t*)batch, len) != len) {
+        writeErrors.fetch_add(1);
+    }
+    if (file) {
+        file.close();
+    }
+}
@@ -1,4 +1,6 @@
 #include "Display.h"
+#include "OuiLookup.h"
+#include "LifetimeStats.h"
 
 Display::Display() : currentView(VIEW_DASHBOARD), detailedPageIndex(0) {}
 
@@ -311,33 +313,51 @@ void Display::showDashboard(const std::vector<String> &ssids, DeauthDetector &de
     clearScreen();
     drawHeader("Dashboard");
 
+    const LifetimeCounters &life = lifetimeStats.counters();
+
+    // Window count, then the lifetime count for the same entry
     int y = 30;
-    for (const String &ssid : ssids)
+    for (size_t i = 0; i < ssids.size(); i++)
     {
-        int count = detector.getEventCountForSSID(ssid);
+        SsidStats stats = {};
+        detector.getSsidStats(i, stats);
+        const LifetimeSsid *lifetime = lifetimeStats.ssid(i);
+        uint32_t total = lifetime ? lifetime->events : 0;
         M5Cardputer.Display.setCursor(5, y);
-        M5Cardputer.Display.print(ssid);
-        M5Cardputer.Display.setCursor(180, y);
-        M5Cardputer.Display.print(count);
+        M5Cardputer.Display.print(ssids[i].substring(0, 22));
+        M5Cardputer.Display.setCursor(150, y);
+        M5Cardputer.Display.print(stats.events);
+        M5Cardputer.Display.setCursor(190, y);
+        M5Cardputer.Display.print(total);
         y += 15;
 
-        if (y > 120)
-            break; // Screen limit
+        if (y > 100)
+            break; // Leave the line above the footer for the totals
     }
 
+    // Lifetime totals; no label, so the line fits with large counts
+    M5Cardputer.Display.setCursor(5, 113);
+    M5Cardputer.Display.print(life.events);
+    M5Cardputer.Display.print(" ev ");
+    M5Cardputer.Display.print(life.incidents);
+    M5Cardputer.Display.print(" inc ");
+    M5Cardputer.Display.print((uint32_t)(life.uptimeSeconds / 3600));
+    M5Cardputer.Display.print("h ");
+    M5Cardputer.Display.print(life.boots);
+    M5Cardputer.Display.print(" boots");
+
     drawFooter();
 }
 
-void Display::showLiveLog(const std::vector<DeauthEvent> &events)
+void Display::showLiveLog(const DeauthEvent *events, size_t count)
 {
     clearScreen();
     drawHeader("Live Log");
 
     int y = 30;
-    int count = 0;
 
     // Show last 5 events
-    for (int i = events.size() - 1; i >= 0 && count < 5; i--)
+    for (size_t i = 0; i < count && i < 5; i++)
     {
         const DeauthEvent &event = events[i];
 
@@ -346,7 +366,7 @@ void Display::showLiveLog(const std::vector<DeauthEvent> &events)
 
         M5Cardputer.Display.setCursor(5, y + 10);
         M5Cardputer.Display.print("SSID: ");
-        M5Cardputer.Display.print(event.target_ssid.substring(0, 12));
+        M5Cardputer.Display.print(String(event.target_ssid).substring(0, 12));
 
         M5Cardputer.Display.setCursor(5, y + 20);
         M5Cardputer.Display.print("Ch:");
@@ -355,13 +375,12 @@ void Display::showLiveLog(const std::vector<DeauthEvent> &events)
         M5Cardputer.Display.print(event.rssi);
 
         y += 35;
-        count++;
 
         if (y > 120)
             break;
     }
 
-    if (events.empty())
+    if (count == 0)
     {
         M5Cardputer.Display.setCursor(5, 60);
         M5Cardputer.Display.println("No events detected");
@@ -403,27 +422,171 @@ void Display::showDetailed(const std::vector<String> &ssids, DeauthDetector &det
     M5Cardputer.Display.print(pageIndicator);
     M5Cardputer.Display.setTextColor(WHITE, BLACK);
 
-    int count = detector.getEventCountForSSID(ssid);
-    DeauthEvent lastEvent = detector.getLastEventForSSID(ssid);
-    int channel = detector.getChannelForSSID(ssid);
+    SsidStats stats = {};
+    detector.getSsidStats(detailedPageIndex, stats);
+    int count = stats.events;
+    const DeauthEvent &lastEvent = stats.last;
+    int channel = stats.channel;
 
     M5Cardputer.Display.setCursor(5, 30);
-    M5Cardputer.Display.println("Total Packets:");
-    M5Cardputer.Display.setCursor(5, 45);
-    M5Cardputer.Display.print("  ");
+    M5Cardputer.Display.print("Total Packets: ");
     M5Cardputer.Display.println(count);
 
+    M5Cardputer.Display.setCursor(5, 45);
+    M5Cardputer.Display.print("Channel: ");
+    M5Cardputer.Display.println(channel > 0 ? String(channel) : "N/A");
+
     M5Cardputer.Display.setCursor(5, 60);
-    M5Cardputer.Display.println("Channel:");
+    M5Cardputer.Display.println("Last Attacker MAC:");
     M5Cardputer.Display.setCursor(5, 75);
     M5Cardputer.Display.print("  ");
-    M5Cardputer.Display.println(channel > 0 ? String(channel) : "N/A");
+    M5Cardputer.Display.print(lastEvent.attacker_mac);
+    if (lastEvent.seq != 0)
+    {
+        // Vendor from the OUI, or a marker for a randomized (spoofed) MAC
+        M5Cardputer.Display.print(" ");
+        if (lastEvent.randomized)
+        {
+            M5Cardputer.Display.setTextColor(YELLOW, BLACK);
+            M5Cardputer.Display.print("random");
+            M5Cardputer.Display.setTextColor(WHITE, BLACK);
+        }
+        else if (lastEvent.vendor != OUI_UNKNOWN)
+        {
+            M5Cardputer.Display.print(String(ouiVendorName(lastEvent.vendor)).substring(0, 14));
+        }
+    }
+    M5Cardputer.Display.println();
 
     M5Cardputer.Display.setCursor(5, 90);
-    M5Cardputer.Display.println("Last Attacker MAC:");
-    M5Cardputer.Display.setCursor(5, 105);
-    M5Cardputer.Display.print("  ");
-    M5Cardputer.Display.println(lastEvent.attacker_mac);
+    M5Cardputer.Display.print("Tool: ");
+    if (lastEvent.tool[0] == '\0')
+    {
+        M5Cardputer.Display.println("Unknown");
+    }
+    else
+    {
+        M5Cardputer.Display.print(String(lastEvent.tool).substring(0, 18));
+        M5Cardputer.Display.print(" (");
+        M5Cardputer.Display.print(lastEvent.tool_confidence);
+        M5Cardputer.Display.println("%)");
+    }
+
+    drawFooter();
+}
+
+void Display::showSurvey(const DeauthDetector &detector)
+{
+    clearScreen();
+    drawHeader("Channel Survey");
+
+    if (!detector.isSurveyEnabled())
+    {
+        M5Cardputer.Display.setCursor(5, 60);
+        M5Cardputer.Display.println("Survey disabled in config");
+        drawFooter();
+        return;
+    }
+
+    const ChannelSurvey &survey = detector.getSurvey();
+    if (survey.completedBuckets() == 0)
+    {
+        M5Cardputer.Display.setCursor(5, 60);
+        M5Cardputer.Display.print("Collecting (");
+        M5Cardputer.Display.print(survey.bucketMs() / 1000);
+        M5Cardputer.Display.println("s bucket)...");
+        drawFooter();
+        return;
+    }
+
+    // Column header
+    M5Cardputer.Display.setTextColor(CYAN, BLACK);
+    M5Cardputer.Display.setCursor(5, 23);
+    M5Cardputer.Display.print("Ch  Frm/s  Mgmt%  Retry%  RSSI");
+    M5Cardputer.Display.setTextColor(WHITE, BLACK);
+
+    // Most recent completed bucket, only channels the radio visited
+    int y = 33;
+    for (int ch = 1; ch <= SURVEY_CHANNELS && y <= 115; ch++)
+    {
+        SurveyCounters c;
+        if (!survey.getBucket(0, ch, c) || c.dwellMs == 0)
+            continue;
+
+        char row[48];
+        snprintf(row, sizeof(row), "%2d %6lu  %4lu   %4lu   %4d",
+                 ch,
+                 (unsigned long)((uint64_t)c.frames * 1000 / c.dwellMs),
+                 (unsigned long)(c.frames ? c.mgmt * 100 / c.frames : 0),
+                 (unsigned long)(c.frames ? c.retries * 100 / c.frames : 0),
+                 ChannelSurvey::approxRssi(c));
+        M5Cardputer.Display.setCursor(5, y);
+        M5Cardputer.Display.print(row);
+        y += 9;
+    }
+
+    drawFooter();
+}
+
+void Display::showTrends(DeauthDetector &detector)
+{
+    clearScreen();
+    drawHeader("Trends (24h)");
+
+    TrendStore &trends = detector.getTrends();
+    if (!trends.isReady())
+    {
+        M5Cardputer.Display.setCursor(5, 60);
+        M5Cardputer.Display.println("Trends unavailable");
+        drawFooter();
+        return;
+    }
+
+    // Hourly totals across all channels, oldest on the left
+    time_t now = time(nullptr);
+    uint32_t hours[24] = {};
+    for (int ch = 1; ch <= TREND_CHANNELS; ch++)
+    {
+        uint32_t counts[24];
+        trends.query(TREND_HOURS, TrendStore::channelSeries(ch), now, counts, 24);
+        for (int i = 0; i < 24; i++)
+            hours[i] += counts[i];
+    }
+    uint32_t peak = 0;
+    for (int i = 0; i < 24; i++)
+    {
+        if (hours[i] > peak)
+            peak = hours[i];
+    }
+
+    const int chartTop = 32;
+    const int chartHeight = 58;
+    for (int i = 0; i < 24; i++)
+    {
+        int h = peak ? (int)((uint64_t)hours[i] * chartHeight / peak) : 0;
+        if (hours[i] > 0 && h == 0)
+            h = 1;
+        M5Cardputer.Display.fillRect(12 + i * 9, chartTop + chartHeight - h, 7, h, i == 23 ? RED : ORANGE);
+    }
+    M5Cardputer.Display.drawFastHLine(10, chartTop + chartHeight, 218, DARKGREY);
+
+    M5Cardputer.Display.setCursor(5, 23);
+    M5Cardputer.Display.print("Peak/h: ");
+    M5Cardputer.Display.print(peak);
+
+    char row[48];
+    snprintf(row, sizeof(row), "1h:%lu  24h:%lu  7d:%lu",
+             (unsigned long)trends.total(TREND_MINUTES, now, 60),
+             (unsigned long)trends.total(TREND_HOURS, now, 24),
+             (unsigned long)trends.total(TREND_HOURS, now, 168));
+    M5Cardputer.Display.setCursor(5, 97);
+    M5Cardputer.Display.print(row);
+
+    snprintf(row, sizeof(row), "Last min:%lu  Last 5 min:%lu",
+             (unsigned long)trends.total(TREND_SECONDS, now, 60),
+             (unsigned long)trends.total(TREND_SECONDS, now, 300));
+    M5Cardputer.Display.setCursor(5, 110);
+    M5Cardputer.Display.print(row);
 
     drawFooter();
 }
@@ -440,6 +603,12 @@ void Display::nextView()
         detailedPageIndex = 0;
         break;
     case VIEW_DETAILED:
+        currentView = VIEW_SURVEY;
+        break;
+    case VIEW_SURVEY:
+        currentView = VIEW_TRENDS;
+        break;
+    case VIEW_TRENDS:
         currentView = VIEW_DASHBOARD;
         break;
     }
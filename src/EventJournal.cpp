@@ -0,0 +1,270 @@
+#include "EventJournal.h"
+#include "Crc32.h"
+#include "Logger.h"
+#include <vector>
+
+// Largest payload a record may claim; anything bigger is corruption
+static const size_t JOURNAL_PAYLOAD_MAX = sizeof(DeauthEvent);
+
+// Backlog events are rewritten under boot 1 and this boot is 2, so the
+// numbers never grow
+static const uint16_t JOURNAL_CARRIED_BOOT = 1;
+static const uint16_t JOURNAL_CURRENT_BOOT = 2;
+
+static uint32_t recordCrc(const JournalRecordHeader& header, const void* payload) {
+    const uint8_t* rest = (const uint8_t*)&header + sizeof(header.crc);
+    uint32_t crc = crc32Update(0, rest, sizeof(header) - sizeof(header.crc));
+    return crc32Update(crc, payload, header.length);
+}
+
+EventJournal::EventJournal()
+    : buffer(nullptr), used(0), fileBytes(0), boot(JOURNAL_CURRENT_BOOT), journaledThrough(0), ackedThrough(0),
+      backlogCleared(true), opened(false), replayPos(0), replayed(0), records(0), writeErrors(0),
+      compactions(0), overflow(0) {}
+
+bool EventJournal::begin(const char* filePath) {
+    path = filePath;
+    buffer = (uint8_t*)memAlloc(MEM_LOGS, JOURNAL_BUFFER_SIZE);
+    if (!buffer) {
+        return false;
+    }
+    load();
+    backlogCleared = backlog.empty();
+    if (!rewrite()) {
+        return false;
+    }
+    file = SD.open(path.c_str(), FILE_APPEND);
+    opened = (bool)file;
+    fileBytes = opened ? file.size() : 0;
+    return opened;
+}
+
+// Two passes over the old journal: the first finds what was acknowledged
+// and where the last intact record ends, the second keeps the events that
+// weren't acknowledged
+bool EventJournal::load() {
+    File f = SD.open(path.c_str(), FILE_READ);
+    if (!f) {
+        return false;
+    }
+    JournalHeader header;
+    if (f.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION || header.eventSize != sizeof(DeauthEvent)) {
+        LOG_WARN("Event journal unreadable or from another firmware, discarded");
+        f.close();
+        return false;
+    }
+
+    struct BootAck {
+        uint16_t boot;
+        uint64_t through;
+    };
+    std::vector<BootAck> acks;
+    uint16_t clearedBelow = 0;
+    size_t end = sizeof(header);
+    uint8_t payload[JOURNAL_PAYLOAD_MAX];
+    for (;;) {
+        JournalRecordHeader rec;
+        if (f.read((uint8_t*)&rec, sizeof(rec)) != sizeof(rec) || rec.length > JOURNAL_PAYLOAD_MAX ||
+            f.read(payload, rec.length) != rec.length || recordCrc(rec, payload) != rec.crc) {
+            break;  // end of file, or a record torn by power loss
+        }
+        end += sizeof(rec) + rec.length;
+        if (rec.type == JOURNAL_ACK && rec.length == sizeof(uint64_t)) {
+            uint64_t seq;
+            memcpy(&seq, payload, sizeof(seq));
+            bool found = false;
+            for (BootAck& a : acks) {
+                if (a.boot == rec.boot) {
+                    a.through = seq > a.through ? seq : a.through;
+                    found = true;
+                }
+            }
+            if (!found) {
+                acks.push_back({rec.boot, seq});
+            }
+        } else if (rec.type == JOURNAL_CLEAR) {
+            clearedBelow = rec.boot > clearedBelow ? rec.boot : clearedBelow;
+        }
+    }
+
+    f.seek(sizeof(header));
+    size_t skipped = 0;
+    for (size_t pos = sizeof(header); pos < end;) {
+        JournalRecordHeader rec;
+        f.read((uint8_t*)&rec, sizeof(rec));
+        f.read(payload, rec.length);
+        pos += sizeof(rec) + rec.length;
+        if (rec.type != JOURNAL_EVENT || rec.length != sizeof(DeauthEvent) || rec.boot < clearedBelow) {
+            continue;
+        }
+        DeauthEvent event;
+        memcpy(&event, payload, sizeof(event));
+        bool acked = false;
+        for (const BootAck& a : acks) {
+            acked |= a.boot == rec.boot && event.seq <= a.through;
+        }
+        if (acked) {
+            continue;
+        }
+        if (backlog.size() < JOURNAL_BACKLOG_MAX) {
+            backlog.push_back(event);
+        } else {
+            skipped++;
+        }
+    }
+    f.close();
+
+    if (!backlog.empty()) {
+        LOG_INFO("Event journal: %u unreported events from an earlier boot", (unsigned)backlog.size());
+    }
+    if (skipped > 0) {
+        LOG_WARN("Event journal: %u more unreported events dropped, backlog full", (unsigned)skipped);
+    }
+    return true;
+}
+
+// New journal holding only the backlog, written beside the old one and
+// renamed over it
+bool EventJournal::rewrite() {
+    String tmp = path + ".tmp";
+    File f = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!f) {
+        return false;
+    }
+    JournalHeader header = {};
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.eventSize = sizeof(DeauthEvent);
+    bool ok = f.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    for (size_t i = replayPos; i < backlog.size() && ok; i++) {
+        JournalRecordHeader rec = {};
+        rec.type = JOURNAL_EVENT;
+        rec.boot = JOURNAL_CARRIED_BOOT;
+        rec.length = sizeof(DeauthEvent);
+        rec.crc = recordCrc(rec, &backlog[i]);
+        ok = f.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec) &&
+             f.write((const uint8_t*)&backlog[i], sizeof(DeauthEvent)) == sizeof(DeauthEvent);
+    }
+    f.close();
+    if (!ok) {
+        SD.remove(tmp.c_str());
+        return false;
+    }
+    SD.remove(path.c_str());
+    return SD.rename(tmp.c_str(), path.c_str());
+}
+
+void EventJournal::record(JournalRecordType type, const void* payload, size_t length) {
+    if (!opened) {
+        return;
+    }
+    if (JOURNAL_BUFFER_SIZE - used < sizeof(JournalRecordHeader) + length) {
+        flush();
+    }
+    JournalRecordHeader rec = {};
+    rec.type = type;
+    rec.boot = boot;
+    rec.length = length;
+    rec.crc = recordCrc(rec, payload);
+    memcpy(buffer + used, &rec, sizeof(rec));
+    memcpy(buffer + used + sizeof(rec), payload, length);
+    used += sizeof(rec) + length;
+    records.fetch_add(1);
+}
+
+void EventJournal::append(const DeauthEvent& event) {
+    if (fileBytes + used >= JOURNAL_MAX_BYTES) {
+        overflow.fetch_add(1);
+        return;
+    }
+    journaledThrough = event.seq;
+    record(JOURNAL_EVENT, &event, sizeof(event));
+}
+
+void EventJournal::ack(uint64_t seq) {
+    if (seq <= ackedThrough) {
+        return;
+    }
+    ackedThrough = seq;
+    record(JOURNAL_ACK, &seq, sizeof(seq));
+}
+
+void EventJournal::clearBacklog() {
+    backlogCleared = true;
+    record(JOURNAL_CLEAR, nullptr, 0);
+}
+
+bool EventJournal::flush() {
+    if (used == 0) {
+        return true;
+    }
+    if (!file) {
+        file = SD.open(path.c_str(), FILE_APPEND);
+    }
+    bool ok = file && file.write(buffer, used) == used;
+    if (file) {
+        file.flush();
+    }
+    if (ok) {
+        fileBytes += used;
+    } else {
+        // Dropped like the session log's lines; those events are only
+        // missing from a replay after a crash
+        writeErrors.fetch_add(1);
+        file.close();
+    }
+    used = 0;
+    compactIfDone();
+    return ok;
+}
+
+// Once everything journaled has been delivered the journal holds nothing
+// worth keeping; start it over rather than let it grow
+void EventJournal::compactIfDone() {
+    if (!backlogCleared || ackedThrough < journaledThrough || fileBytes < JOURNAL_COMPACT_BYTES) {
+        return;
+    }
+    file.close();
+    if (rewrite()) {
+        compactions.fetch_add(1);
+    }
+    file = SD.open(path.c_str(), FILE_APPEND);
+    fileBytes = file ? file.size() : fileBytes;
+}
+
+size_t EventJournal::copyBacklog(DeauthEvent* out, size_t max) const {
+    size_t n = 0;
+    for (size_t i = replayPos; i < backlog.size() && n < max; i++) {
+        out[n++] = backlog[i];
+    }
+    return n;
+}
+
+bool EventJournal::consumeBacklog(size_t count) {
+    count = count < backlogSize() ? count : backlogSize();
+    replayPos += count;
+    replayed.fetch_add(count);
+    if (backlogSize() > 0) {
+        return false;
+    }
+    // The caller then has clearBacklog() queued, which orders this before
+    // any compaction on the session task
+    backlog.clear();
+    backlog.shrink_to_fit();
+    replayPos = 0;
+    return true;
+}
+
+JournalStats EventJournal::getStats() const {
+    JournalStats stats;
+    stats.open = opened;
+    stats.backlog = backlogSize();
+    stats.replayed = replayed.load();
+    stats.records = records.load();
+    stats.writeErrors = writeErrors.load();
+    stats.compactions = compactions.load();
+    stats.overflow = overflow.load();
+    return stats;
+}
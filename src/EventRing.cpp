@@ -0,0 +1,128 @@
+#include "EventRing.h"
+#include "PsramAllocator.h"
+
+EventRing::EventRing()
+    : slots(nullptr), slotCount(0), count(0), nextSequence(1), overwrittenTotal(0), psram(false)
+{
+    for (Cursor& c : cursors) {
+        c.next = 1;
+        c.acked = 0;
+        c.lost = 0;
+    }
+}
+
+EventRing::~EventRing() {
+    memFree(slots);
+}
+
+bool EventRing::begin(size_t capacity) {
+    if (slots) {
+        return true;
+    }
+
+    // Prefer PSRAM; a board without it still gets a small history
+    slots = (DeauthEvent*)memAlloc(MEM_EVENTS, capacity * sizeof(DeauthEvent), MEM_PSRAM_ONLY);
+    psram = slots != nullptr;
+    if (!slots) {
+        capacity = EVENT_RING_FALLBACK_CAPACITY;
+        slots = (DeauthEvent*)memAlloc(MEM_EVENTS, capacity * sizeof(DeauthEvent), MEM_INTERNAL_ONLY);
+    }
+    if (!slots) {
+        return false;
+    }
+
+    slotCount = capacity;
+    return true;
+}
+
+uint64_t EventRing::push(const DeauthEvent& event) {
+    if (slotCount == 0) {
+        return 0;
+    }
+
+    uint64_t seq = nextSequence++;
+    DeauthEvent& slot = slots[(seq - 1) % slotCount];
+    slot = event;
+    slot.seq = seq;
+
+    if (count < slotCount) {
+        count++;
+    } else {
+        overwrittenTotal++;
+    }
+    return seq;
+}
+
+size_t EventRing::readSince(uint64_t since, DeauthEvent* out, size_t max, uint64_t* dropped) const {
+    uint64_t oldest = oldestSeq();
+    if (since == 0) {
+        since = 1;
+    }
+    if (dropped) {
+        *dropped = since < oldest ? oldest - since : 0;
+    }
+    if (since < oldest) {
+        since = oldest;
+    }
+
+    size_t n = 0;
+    for (uint64_t seq = since; seq < nextSequence && n < max; seq++) {
+        out[n++] = at(seq);
+    }
+    return n;
+}
+
+size_t EventRing::readLatest(DeauthEvent* out, size_t max) const {
+    size_t n = 0;
+    for (uint64_t seq = latestSeq(); seq >= oldestSeq() && seq > 0 && n < max; seq--) {
+        out[n++] = at(seq);
+    }
+    return n;
+}
+
+const DeauthEvent* EventRing::find(uint64_t seq) const {
+    if (seq == 0 || seq < oldestSeq() || seq >= nextSequence) {
+        return nullptr;
+    }
+    return &at(seq);
+}
+
+size_t EventRing::read(size_t consumer, DeauthEvent* out, size_t max) {
+    Cursor& c = cursors[consumer];
+    uint64_t oldest = oldestSeq();
+    if (c.next < oldest) {
+        c.lost += oldest - c.next;
+        c.next = oldest;
+        // Overwritten events can't be retried, so a rewind must not count
+        // them lost again
+        if (c.acked < oldest - 1) {
+            c.acked = oldest - 1;
+        }
+    }
+
+    size_t n = 0;
+    while (c.next < nextSequence && n < max) {
+        if (out) {
+            out[n] = at(c.next);
+        }
+        c.next++;
+        n++;
+    }
+    return n;
+}
+
+void EventRing::ack(size_t consumer) {
+    Cursor& c = cursors[consumer];
+    c.acked = c.next - 1;
+}
+
+void EventRing::rewind(size_t consumer) {
+    Cursor& c = cursors[consumer];
+    c.next = c.acked + 1;
+}
+
+uint64_t EventRing::pending(size_t consumer) const {
+    const Cursor& c = cursors[consumer];
+    uint64_t from = c.acked + 1 > oldestSeq() ? c.acked + 1 : oldestSeq();
+    return nextSequence - from;
+}
@@ -0,0 +1,234 @@
+#include "LifetimeStats.h"
+#include "Crc32.h"
+#include "Logger.h"
+#include <Preferences.h>
+#include <algorithm>
+
+#define LIFETIME_NAMESPACE "lifetime"
+
+static const uint32_t LIFETIME_MAGIC = 0x4546494C;     // "LIFE"
+static const uint32_t LIFETIME_VERSION = 1;
+
+LifetimeStats lifetimeStats;
+
+static void slotKey(uint32_t seq, char* key, size_t size) {
+    snprintf(key, size, "slot%u", (unsigned)(seq % LIFETIME_SLOTS));
+}
+
+LifetimeStats::LifetimeStats()
+    : data(), seq(0), loaded(false), dirty(false), pendingEvents(0), lastCommitMs(0), lastTickMs(0),
+      uptimeRemainderMs(0), allowlistedSeen(0), framesSeen(0), ssidFramesDue(false), commits(0), commitErrors(0) {}
+
+void LifetimeStats::begin() {
+    Preferences prefs;
+    if (prefs.begin(LIFETIME_NAMESPACE, true)) {
+        Record record;
+        for (size_t i = 0; i < LIFETIME_SLOTS; i++) {
+            char key[8];
+            slotKey(i, key, sizeof(key));
+            if (prefs.getBytesLength(key) != sizeof(record) ||
+                prefs.getBytes(key, &record, sizeof(record)) != sizeof(record) ||
+                record.magic != LIFETIME_MAGIC || record.version != LIFETIME_VERSION ||
+                record.crc != crc32Update(0, &record, offsetof(Record, crc))) {
+                continue;
+            }
+            if (!loaded || record.seq > seq) {
+                seq = record.seq;
+                data = record.counters;
+                loaded = true;
+            }
+        }
+        prefs.end();
+    }
+    if (!loaded) {
+        LOG_INFO("No lifetime statistics found, starting from zero");
+    }
+
+    data.boots++;
+    lastTickMs = millis();
+    dirty = true;
+    commit();
+}
+
+void LifetimeStats::setProtected(const std::vector<String>& entries) {
+    slots.assign(entries.size(), -1);
+    ssidFramesSeen.assign(entries.size(), 0);
+    lastEventAt.assign(entries.size() + 1, 0);
+
+    // Entries that have a slot keep it, wherever they now sit in the list
+    for (size_t i = 0; i < entries.size(); i++) {
+        for (size_t j = 0; j < LIFETIME_SSIDS && data.ssids[j].name[0]; j++) {
+            if (strncmp(data.ssids[j].name, entries[i].c_str(), sizeof(data.ssids[j].name) - 1) == 0) {
+                slots[i] = (int)j;
+                break;
+            }
+        }
+    }
+    // New ones take a free slot, else the slot of an entry no longer
+    // configured; once all slots are in use they're only in the totals
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (slots[i] >= 0 || entries[i].isEmpty()) {
+            continue;
+        }
+        int free = -1;
+        for (size_t j = 0; j < LIFETIME_SSIDS; j++) {
+            if (!data.ssids[j].name[0]) {
+                free = (int)j;
+                break;
+            }
+            if (free < 0 && std::find(slots.begin(), slots.end(), (int)j) == slots.end()) {
+                free = (int)j;
+            }
+        }
+        if (free < 0) {
+            break;
+        }
+        LifetimeSsid& slot = data.ssids[free];
+        memset(&slot, 0, sizeof(slot));
+        strlcpy(slot.name, entries[i].c_str(), sizeof(slot.name));
+        slots[i] = free;
+        dirty = true;
+    }
+}
+
+const LifetimeSsid* LifetimeStats::ssid(size_t index) const {
+    return index < slots.size() && slots[index] >= 0 ? &data.ssids[slots[index]] : nullptr;
+}
+
+void LifetimeStats::tick(const DeauthDetector& detector) {
+    uint32_t now = millis();
+    uint32_t elapsed = now - lastTickMs + uptimeRemainderMs;
+    lastTickMs = now;
+    if (elapsed >= 1000) {
+        data.uptimeSeconds += elapsed / 1000;
+        dirty = true;
+    }
+    uptimeRemainderMs = elapsed % 1000;
+
+    uint32_t allowlistedSinceBoot = detector.getAllowlistedFrames();
+    if (allowlistedSinceBoot != allowlistedSeen) {
+        data.allowlistedFrames += allowlistedSinceBoot - allowlistedSeen;
+        allowlistedSeen = allowlistedSinceBoot;
+        dirty = true;
+    }
+
+    // Per entry only while the total moves, and one pass after: the
+    // entries come from the snapshot, which can trail the total by a drain
+    uint32_t framesSinceBoot = detector.getAttackFrames();
+    bool framesMoved = framesSinceBoot != framesSeen;
+    if (framesMoved) {
+        data.frames += framesSinceBoot - framesSeen;
+        framesSeen = framesSinceBoot;
+        dirty = true;
+    }
+    if (framesMoved || ssidFramesDue) {
+        for (size_t i = 0; i < slots.size(); i++) {
+            SsidStats stats = {};
+            if (slots[i] >= 0 && detector.getSsidStats(i, stats) && stats.frames != ssidFramesSeen[i]) {
+                data.ssids[slots[i]].frames += stats.frames - ssidFramesSeen[i];
+                ssidFramesSeen[i] = stats.frames;
+            }
+        }
+    }
+    ssidFramesDue = framesMoved;
+
+    uint32_t sinceCommit = now - lastCommitMs;
+    if (sinceCommit >= LIFETIME_COMMIT_MS ||
+        (pendingEvents >= LIFETIME_COMMIT_EVENTS && sinceCommit >= LIFETIME_MIN_COMMIT_MS)) {
+        commit();
+    }
+}
+
+bool LifetimeStats::commit() {
+    if (!dirty) {
+        return true;
+    }
+    // Even a failed attempt waits for the next interval, so a bad NVS
+    // partition isn't retried on every loop pass
+    lastCommitMs = millis();
+
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = LIFETIME_MAGIC;
+    record.version = LIFETIME_VERSION;
+    record.seq = seq + 1;
+    record.counters = data;
+    record.crc = crc32Update(0, &record, offsetof(Record, crc));
+
+    char key[8];
+    slotKey(record.seq, key, sizeof(key));
+    Preferences prefs;
+    bool ok = prefs.begin(LIFETIME_NAMESPACE, false) && prefs.putBytes(key, &record, sizeof(record)) == sizeof(record);
+    prefs.end();
+    if (!ok) {
+        commitErrors++;
+        LOG_WARN("Failed to save lifetime statistics");
+        return false;
+    }
+    seq = record.seq;
+    commits++;
+    dirty = false;
+    pendingEvents = 0;
+    return true;
+}
+
+void LifetimeStats::recordEvent(const DeauthEvent& event) {
+    data.events++;
+    if (event.denylisted) {
+        data.denylistedEvents++;
+    }
+    LifetimeSsid* slot = nullptr;
+    if (event.protected_index >= 0 && (size_t)event.protected_index < slots.size() &&
+        slots[event.protected_index] >= 0) {
+        slot = &data.ssids[slots[event.protected_index]];
+        slot->events++;
+    }
+    // An incident is a run of events against one protected entry with no
+    // pause longer than LIFETIME_INCIDENT_GAP; a reboot starts a new one
+    size_t key = (size_t)(event.protected_index + 1);
+    if (event.protected_index >= -1 && key < lastEventAt.size()) {
+        uint32_t now = (uint32_t)event.timestamp;
+        uint32_t& last = lastEventAt[key];
+        if (last == 0 || now - last > LIFETIME_INCIDENT_GAP) {
+            data.incidents++;
+            if (slot) {
+                slot->incidents++;
+            }
+        }
+        last = now ? now : 1;
+    }
+    pendingEvents++;
+    dirty = true;
+}
+
+void LifetimeStats::recordDropped(uint64_t count) {
+    if (count > 0) {
+        data.droppedEvents += (uint32_t)count;
+        dirty = true;
+    }
+}
+
+void LifetimeStats::recordReport(ReportResult result, size_t events) {
+    switch (result) {
+        case REPORT_OK:
+            data.reportsSent++;
+            data.eventsReported += events;
+            break;
+        case REPORT_REJECTED:
+            data.reportsRejected++;
+            break;
+        case REPORT_RETRY:
+            data.reportsFailed++;
+            break;
+    }
+    dirty = true;
+}
+
+LifetimeStatus LifetimeStats::status() const {
+    LifetimeStatus s;
+    s.loaded = loaded;
+    s.commits = commits;
+    s.commitErrors = commitErrors;
+    s.record = seq;
+    return s;
+}
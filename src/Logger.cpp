@@ -1,20 +1,32 @@
 #include "Logger.h"
 #include <time.h>
 
+#define JOURNAL_FILE "/deauthdetector/journal.wal"
+
 // Define global logger instance
 Logger logger;
 
-Logger::Logger() : sessionFile(""), debugFile("/deauthdetector/logs/debug.log"), config(nullptr) {}
+Logger::Logger() : debugFile("/deauthdetector/logs/debug.log"), config(nullptr) {}
 
 void Logger::setConfig(AppConfig* cfg) {
     config = cfg;
 }
 
 bool Logger::begin() {    
+    // Serial output goes through the drain task from here on, SD or not
+    bool compress = config ? config->logging.compress : DEFAULT_LOG_COMPRESS;
+    if (compress) {
+        debugFile += ".ddz";
+    }
+    if (!debug.begin(debugFile.c_str(), compress)) {
+        // No writer to queue this through
+        Serial.println("Warning: Failed to start debug log writer");
+    }
+    
     // Create /deauthdetector directory if it doesn't exist
     if (!SD.exists("/deauthdetector")) {
         if (!SD.mkdir("/deauthdetector")) {
-            Serial.println("Failed to create /deauthdetector directory");
+            LOG_ERROR("Failed to create /deauthdetector directory");
             return false;
         }
     }
@@ -22,152 +34,79 @@ bool Logger::begin() {
     // Create /deauthdetector/logs directory if it doesn't exist
     if (!SD.exists("/deauthdetector/logs")) {
         if (!SD.mkdir("/deauthdetector/logs")) {
-            Serial.println("Failed to create /deauthdetector/logs directory");
+            LOG_ERROR("Failed to create /deauthdetector/logs directory");
             return false;
         }
     }
     
     // Create debug log file (cleared on each boot)
     if (!createDebugFile()) {
-        Serial.println("Warning: Failed to create debug log file");
+        LOG_WARN("Failed to create debug log file");
+    } else {
+        debug.setFileEnabled(config && config->debug.enabled);
+    }
+    
+    // Binary trace (Trace.h), decoded on the host with tools/ddtrace
+    if (config && config->debug.trace != "off") {
+        TraceOutput output = config->debug.trace == "sd" ? TRACE_OUTPUT_SD : TRACE_OUTPUT_SERIAL;
+        if (!debug.setTraceOutput(output, "/deauthdetector/logs/trace.bin")) {
+            LOG_WARN("Failed to start trace");
+        }
     }
     
     return createSessionFile();
 }
 
 bool Logger::createDebugFile() {
-    // Create/truncate debug log file on startup
-    File file = SD.open(debugFile.c_str(), FILE_WRITE);
-    if (!file) {
-        return false;
-    }
-    
-    // Write header with boot timestamp
+    // Create/truncate debug log file on startup, header with boot timestamp
     time_t now = time(nullptr);
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
     
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
-    
-    file.print("=== Debug Log Started: ");
-    file.print(timestamp);
-    file.println(" ===");
-    file.close();
-    
-    return true;
-}
-
-void Logger::writeToDebugFile(const char* msg, bool newline) {
-    if (!config || !config->debug.enabled) {
-        return;
-    }
-    
-    File file = SD.open(debugFile.c_str(), FILE_APPEND);
-    if (file) {
-        if (newline) {
-            file.println(msg);
-        } else {
-            file.print(msg);
-        }
-        file.close();
-    }
-}
-
-void Logger::debugPrint(const char* msg) {
-    Serial.print(msg);
-    writeToDebugFile(msg, false);
-}
-
-void Logger::debugPrint(const String& msg) {
-    debugPrint(msg.c_str());
+    char banner[64];
+    strftime(banner, sizeof(banner), "=== Debug Log Started: %Y-%m-%d %H:%M:%S ===", &timeinfo);
+    return debug.resetFile(banner);
 }
 
-void Logger::debugPrintln(const char* msg) {
-    Serial.println(msg);
-    writeToDebugFile(msg, true);
-}
-
-void Logger::debugPrintln(const String& msg) {
-    debugPrintln(msg.c_str());
-}
-
-void Logger::debugPrintln() {
-    Serial.println();
-    writeToDebugFile("", true);
+void Logger::log(uint8_t level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    debug.write(level, fmt, args);
+    va_end(args);
 }
 
 bool Logger::clearDebugLog() {
-    File file = SD.open(debugFile.c_str(), FILE_WRITE);
-    if (!file) {
-        return false;
-    }
-    
     time_t now = time(nullptr);
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
     
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
-    
-    file.print("=== Debug Log Cleared: ");
-    file.print(timestamp);
-    file.println(" ===");
-    file.close();
-    
-    return true;
+    char banner[64];
+    strftime(banner, sizeof(banner), "=== Debug Log Cleared: %Y-%m-%d %H:%M:%S ===", &timeinfo);
+    return debug.resetFile(banner);
 }
 
 bool Logger::createSessionFile() {
-    time_t now = time(nullptr);
-    struct tm timeinfo;
-    localtime_r(&now, &timeinfo);
-    
-    char filename[64];
-    strftime(filename, sizeof(filename), "/deauthdetector/logs/deauthdetect_session_%Y%m%d_%H%M%S.csv", &timeinfo);
-    sessionFile = String(filename);
-    
-    File file = SD.open(sessionFile.c_str(), FILE_WRITE);
-    if (!file) {
-        Serial.println("Failed to create session log file");
+    SessionLogOptions options;
+    options.segmentMaxBytes = (uint32_t)(config ? config->logging.segment_max_kb : DEFAULT_SEGMENT_MAX_KB) * 1024;
+    options.segmentMaxSeconds = (uint32_t)(config ? config->logging.segment_max_minutes : DEFAULT_SEGMENT_MAX_MINUTES) * 60;
+    options.budgetBytes = (uint64_t)(config ? config->logging.budget_mb : DEFAULT_LOG_BUDGET_MB) * 1024 * 1024;
+    options.compress = config ? config->logging.compress : DEFAULT_LOG_COMPRESS;
+    
+    // Nothing to replay to without an API endpoint, so no journal either
+    bool reporting = config && !config->api.endpoint_url.isEmpty();
+    
+    // Loads the segment manifest, opens the first segment and the journal and starts the writer task
+    if (!session.begin("/deauthdetector/logs",
+            "timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count,tool,tool_confidence,denylisted,vendor,randomized",
+            options, reporting ? JOURNAL_FILE : nullptr)) {
+        LOG_ERROR("Failed to create session log file");
         return false;
     }
     
-    // Write CSV header
-    file.println("timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count");
-    file.close();
-    
-    Serial.print("Created session log: ");
-    Serial.println(sessionFile);
+    LOG_INFO("Created session log: %s", session.currentPath(session.csvExtension()).c_str());
     return true;
 }
 
 bool Logger::logEvent(const DeauthEvent& event) {
-    File file = SD.open(sessionFile.c_str(), FILE_APPEND);
-    if (!file) {
-        Serial.println("Failed to open log file for writing");
-        return false;
-    }
-    
-    char timestamp[32];
-    struct tm timeinfo;
-    localtime_r(&event.timestamp, &timeinfo);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
-    
-    file.print(timestamp);
-    file.print(",\"");
-    file.print(event.target_ssid);
-    file.print("\",\"");
-    file.print(event.target_bssid);
-    file.print("\",\"");
-    file.print(event.attacker_mac);
-    file.print("\",");
-    file.print(event.channel);
-    file.print(",");
-    file.print(event.rssi);
-    file.print(",");
-    file.println(event.packet_count);
-    
-    file.close();
-    return true;
+    return session.enqueue(event);
 }
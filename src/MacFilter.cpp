@@ -0,0 +1,115 @@
+#include "MacFilter.h"
+#include "Logger.h"
+#include <SD.h>
+
+MacFilter::MacFilter() : bloomMask(0), tableMask(0), count(0) {}
+
+void MacFilter::clear() {
+    bloom.clear();
+    table.clear();
+    bloomMask = 0;
+    tableMask = 0;
+    count = 0;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool MacFilter::parseMac(const char* text, uint8_t* mac) {
+    for (int i = 0; i < 6; i++) {
+        int hi = hexValue(text[0]);
+        int lo = hi < 0 ? -1 : hexValue(text[1]);
+        if (lo < 0) return false;
+        mac[i] = (hi << 4) | lo;
+        text += 2;
+        if (i < 5) {
+            if (*text != ':' && *text != '-') return false;
+            text++;
+        }
+    }
+    return true;
+}
+
+bool MacFilter::load(const char* path) {
+    clear();
+    if (!SD.exists(path)) {
+        return false;
+    }
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint64_t> keys;
+    int lineNumber = 0;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        lineNumber++;
+        int hash = line.indexOf('#');
+        if (hash >= 0) {
+            line = line.substring(0, hash);
+        }
+        line.trim();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        uint8_t mac[6];
+        if (line.length() != 17 || !parseMac(line.c_str(), mac)) {
+            LOG_WARN("%s:%d: not a MAC address, skipped", path, (int)lineNumber);
+            continue;
+        }
+        keys.push_back(key(mac));
+    }
+    file.close();
+
+    build(keys);
+    return count > 0;
+}
+
+void MacFilter::build(const std::vector<uint64_t>& keys) {
+    if (keys.empty()) {
+        return;
+    }
+
+    // ~16 bits per entry with 4 hashes: under 0.3% false positives, and a
+    // false positive only costs one probe of the exact table
+    size_t bits = 1024;
+    while (bits < keys.size() * 16) {
+        bits <<= 1;
+    }
+    bloom.assign(bits / 32, 0);
+    bloomMask = bits - 1;
+
+    // Exact table at <= 50% load
+    size_t slots = 8;
+    while (slots < keys.size() * 2) {
+        slots <<= 1;
+    }
+    table.assign(slots, 0);
+    tableMask = slots - 1;
+
+    for (uint64_t k : keys) {
+        uint64_t h = mix(k);
+        size_t slot = h & tableMask;
+        while (table[slot] != 0 && table[slot] != (k | PRESENT)) {
+            slot = (slot + 1) & tableMask;
+        }
+        if (table[slot] != 0) {
+            continue;   // duplicate line
+        }
+        table[slot] = k | PRESENT;
+        count++;
+
+        uint32_t h1 = (uint32_t)h;
+        uint32_t h2 = (uint32_t)(h >> 32) | 1;
+        for (int i = 0; i < BLOOM_HASHES; i++) {
+            uint32_t bit = (h1 + i * h2) & bloomMask;
+            bloom[bit >> 5] |= 1UL << (bit & 31);
+        }
+    }
+}
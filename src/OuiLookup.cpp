@@ -0,0 +1,46 @@
+#include "OuiLookup.h"
+#include "OuiTable.h"
+
+static constexpr size_t OUI_COUNT = sizeof(OUI_TABLE) / sizeof(OUI_TABLE[0]);
+static constexpr size_t OUI_VENDOR_COUNT = sizeof(OUI_VENDORS) / sizeof(OUI_VENDORS[0]);
+
+// Binary search needs strictly ascending OUIs and valid vendor indexes;
+// a bad regeneration fails the build instead of returning wrong vendors
+static constexpr bool ouiTableValid() {
+    for (size_t i = 0; i < OUI_COUNT; i++) {
+        if ((OUI_TABLE[i] & 0xFF) == OUI_UNKNOWN || (OUI_TABLE[i] & 0xFF) >= OUI_VENDOR_COUNT) {
+            return false;
+        }
+        if (i > 0 && (OUI_TABLE[i - 1] >> 8) >= (OUI_TABLE[i] >> 8)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(ouiTableValid(), "OuiTable.h must be sorted by OUI with valid vendor indexes");
+
+uint8_t ouiLookup(const uint8_t* mac) {
+    if (macIsRandomized(mac)) {
+        return OUI_UNKNOWN;
+    }
+
+    uint32_t oui = ((uint32_t)mac[0] << 16) | ((uint32_t)mac[1] << 8) | mac[2];
+    size_t lo = 0;
+    size_t hi = OUI_COUNT;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        uint32_t entry = OUI_TABLE[mid] >> 8;
+        if (entry < oui) {
+            lo = mid + 1;
+        } else if (entry > oui) {
+            hi = mid;
+        } else {
+            return OUI_TABLE[mid] & 0xFF;
+        }
+    }
+    return OUI_UNKNOWN;
+}
+
+const char* ouiVendorName(uint8_t vendor) {
+    return vendor < OUI_VENDOR_COUNT ? OUI_VENDORS[vendor] : "";
+}
@@ -0,0 +1,207 @@
+#include "PcapWriter.h"
+#include "PsramAllocator.h"
+#include <algorithm>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <time.h>
+
+static const char PCAP_PREFIX[] = "capture_";
+static const char PCAP_EXT[] = ".pcapng";
+
+PcapWriter pcapWriter;
+
+PcapWriter::PcapWriter()
+    : limits(), batch(nullptr), fileBytes(0), task(nullptr), active(false), captured(0), dropped(0),
+      written(0), writeErrors(0), files(0), filesDeleted(0), bytes(0) {}
+
+bool PcapWriter::begin(const char* captureDir, const PcapLimits& captureLimits) {
+    if (task) {
+        return false;
+    }
+    dir = captureDir;
+    limits = captureLimits;
+
+    void* slots = memAlloc(MEM_CAPTURE, pool.bytes());
+    batch = (uint8_t*)memAlloc(MEM_CAPTURE, PCAP_BATCH);
+    if (!slots || !batch || (!SD.exists(dir.c_str()) && !SD.mkdir(dir.c_str()))) {
+        cleanup(slots);
+        return false;
+    }
+    listFiles();
+    if (!openFile()) {
+        cleanup(slots);
+        return false;
+    }
+    pool.begin(slots);
+    if (xTaskCreatePinnedToCore(taskEntry, "pcap", 4096, this, 1, &task, 0) != pdPASS) {
+        task = nullptr;
+        file.close();
+        cleanup(slots);
+        return false;
+    }
+    active = true;
+    return true;
+}
+
+// After a failed begin(): nothing stays charged to MEM_CAPTURE
+void PcapWriter::cleanup(void* slots) {
+    memFree(slots);
+    memFree(batch);
+    batch = nullptr;
+    names.clear();
+}
+
+// Names start with the time, so sorting by name is oldest first
+void PcapWriter::listFiles() {
+    File root = SD.open(dir.c_str(), FILE_READ);
+    if (!root) {
+        return;
+    }
+    for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+        String name = f.name();
+        f.close();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) {
+            name = name.substring(slash + 1);
+        }
+        if (name.startsWith(PCAP_PREFIX) && name.endsWith(PCAP_EXT)) {
+            names.push_back(name);
+        }
+    }
+    root.close();
+    std::sort(names.begin(), names.end());
+}
+
+// New file named after the current time, with the section and interface
+// headers; then deletes the oldest files beyond the limit
+bool PcapWriter::openFile() {
+    time_t now = time(nullptr);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    char name[48];
+    strftime(name, sizeof(name), "capture_%Y%m%d_%H%M%S", &timeinfo);
+
+    // Size rotation can outpace the clock's one-second resolution
+    size_t len = strlen(name);
+    String candidate = String(name) + PCAP_EXT;
+    for (int n = 2; n < 100 && SD.exists((dir + "/" + candidate).c_str()); n++) {
+        snprintf(name + len, sizeof(name) - len, "_%02d", n);
+        candidate = String(name) + PCAP_EXT;
+    }
+
+    path = dir + "/" + candidate;
+    file = SD.open(path.c_str(), FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[PCAP_FILE_HEADER_LEN];
+    size_t n = pcapFileHeader(header, PCAP_SNAP_LEN);
+    fileBytes = file.write(header, n);
+    file.flush();
+    if (fileBytes != n) {
+        // Packets after a partial section header would be unreadable
+        file.close();
+        SD.remove(path.c_str());
+        return false;
+    }
+    names.push_back(candidate);
+    files.fetch_add(1);
+
+    while (limits.maxFiles > 0 && names.size() > limits.maxFiles) {
+        SD.remove((dir + "/" + names.front()).c_str());
+        names.erase(names.begin());
+        filesDeleted.fetch_add(1);
+    }
+    return true;
+}
+
+void PcapWriter::capture(const uint8_t* frame, uint16_t len, uint8_t channel, int8_t rssi, uint32_t rxUs) {
+    uint32_t pos;
+    Frame* f = pool.claim(pos);
+    if (!f) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    f->rxUs = rxUs;
+    f->origLength = len;
+    f->length = len < PCAP_SNAP_LEN ? len : PCAP_SNAP_LEN;
+    f->channel = channel;
+    f->rssi = rssi;
+    memcpy(f->data, frame, f->length);
+    pool.publish(pos);
+    captured.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PcapWriter::taskEntry(void* arg) {
+    static_cast<PcapWriter*>(arg)->run();
+}
+
+void PcapWriter::run() {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(PCAP_DRAIN_MS));
+        drain();
+    }
+}
+
+// Packs waiting frames into the batch and appends it, a batch at a time,
+// until the pool is empty. Slots go back to the pool as soon as they are
+// packed, so the WiFi task can refill them during the write.
+void PcapWriter::drain() {
+    for (;;) {
+        // Receive timestamps run on the same clock as esp_timer; their age
+        // against it, taken off the wall clock, dates each frame. Signed, so
+        // frames that arrive during the batch come out a little later
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        int64_t wallUs = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+        uint32_t nowRxUs = (uint32_t)esp_timer_get_time();
+
+        size_t used = 0;
+        uint32_t frames = 0;
+        const Frame* f;
+        while (used + pcapPacketLen(PCAP_SNAP_LEN) <= PCAP_BATCH && (f = pool.peek()) != nullptr) {
+            int64_t timeUs = wallUs - (int32_t)(nowRxUs - f->rxUs);
+            used += pcapPacket(batch + used, timeUs, f->channel, f->rssi, f->data, f->length, f->origLength);
+            pool.release();
+            frames++;
+        }
+        if (used == 0) {
+            return;
+        }
+
+        if (limits.fileMaxBytes > 0 && fileBytes > PCAP_FILE_HEADER_LEN && fileBytes + used > limits.fileMaxBytes) {
+            file.close();
+            openFile();
+        }
+        // A failed write may have left part of a block, which would end the
+        // file for readers; carry on in a new one
+        if (!file) {
+            openFile();
+        }
+        size_t done = file ? file.write(batch, used) : 0;
+        if (file) {
+            file.flush();
+        }
+        if (done == used) {
+            fileBytes += used;
+            written.fetch_add(frames);
+            bytes.fetch_add(used);
+        } else {
+            // Dropped rather than held, like the session log
+            writeErrors.fetch_add(1);
+            file.close();
+        }
+    }
+}
+
+PcapStats PcapWriter::getStats() const {
+    PcapStats stats;
+    stats.captured = captured.load();
+    stats.dropped = dropped.load();
+    stats.written = written.load();
+    stats.writeErrors = writeErrors.load();
+    stats.files = files.load();
+    stats.filesDeleted = filesDeleted.load();
+    stats.bytes = bytes.load();
+    return stats;
+}
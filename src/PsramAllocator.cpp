@@ -0,0 +1,149 @@
+#include "PsramAllocator.h"
+#include <atomic>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+// Every block starts with this header, so frees need no size and no
+// subsystem. 16 bytes keeps the payload as aligned as the heap's own blocks.
+struct MemHeader {
+    uint32_t bytes;
+    uint16_t magic;
+    uint8_t  sub;
+    uint8_t  psram;
+    uint32_t reserved[2];
+};
+
+static const uint16_t MEM_MAGIC = 0xD0A7;
+
+static const char* const SUBSYSTEM_NAMES[MEM_SUBSYSTEMS] = {
+    "events", "trends", "bssids", "maclists", "signatures", "reporter", "web", "logs", "capture", "config"
+};
+
+struct MemCounters {
+    std::atomic<size_t>   psram;
+    std::atomic<size_t>   internal;
+    std::atomic<size_t>   peak;
+    std::atomic<uint32_t> failures;
+};
+
+static MemCounters counters[MEM_SUBSYSTEMS];
+
+static void charge(MemSubsystem sub, bool psram, size_t bytes) {
+    MemCounters& c = counters[sub];
+    (psram ? c.psram : c.internal).fetch_add(bytes);
+    size_t now = c.psram.load() + c.internal.load();
+    size_t peak = c.peak.load();
+    while (now > peak && !c.peak.compare_exchange_weak(peak, now)) {
+    }
+}
+
+static void refund(MemSubsystem sub, bool psram, size_t bytes) {
+    MemCounters& c = counters[sub];
+    (psram ? c.psram : c.internal).fetch_sub(bytes);
+}
+
+static MemHeader* headerOf(const void* ptr) {
+    MemHeader* h = (MemHeader*)ptr - 1;
+    return h->magic == MEM_MAGIC ? h : nullptr;
+}
+
+void* memAlloc(MemSubsystem sub, size_t bytes, MemPlacement placement) {
+    if (sub >= MEM_SUBSYSTEMS) {
+        return nullptr;
+    }
+
+    size_t total = sizeof(MemHeader) + bytes;
+    MemHeader* h = nullptr;
+    bool psram = false;
+    if (placement != MEM_INTERNAL_ONLY) {
+        h = (MemHeader*)heap_caps_calloc(1, total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        psram = h != nullptr;
+    }
+    if (!h && placement != MEM_PSRAM_ONLY) {
+        h = (MemHeader*)heap_caps_calloc(1, total, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!h) {
+        // A PSRAM-only miss is an expected probe, not a failure
+        if (placement != MEM_PSRAM_ONLY) {
+            counters[sub].failures.fetch_add(1);
+        }
+        return nullptr;
+    }
+
+    h->bytes = bytes;
+    h->magic = MEM_MAGIC;
+    h->sub = sub;
+    h->psram = psram;
+    charge(sub, psram, bytes);
+    return h + 1;
+}
+
+void* memRealloc(void* ptr, size_t bytes) {
+    if (!ptr) {
+        return nullptr;     // no subsystem to charge
+    }
+    MemHeader* h = headerOf(ptr);
+    if (!h) {
+        return nullptr;
+    }
+
+    MemSubsystem sub = (MemSubsystem)h->sub;
+    bool psram = h->psram;
+    size_t old = h->bytes;
+    uint32_t caps = (psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT;
+    MemHeader* moved = (MemHeader*)heap_caps_realloc(h, sizeof(MemHeader) + bytes, caps);
+    if (!moved) {
+        counters[sub].failures.fetch_add(1);
+        return nullptr;
+    }
+
+    moved->bytes = bytes;
+    refund(sub, psram, old);
+    charge(sub, psram, bytes);
+    return moved + 1;
+}
+
+void memFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    MemHeader* h = headerOf(ptr);
+    if (!h) {
+        return;     // not ours; leaking beats corrupting the heap
+    }
+    refund((MemSubsystem)h->sub, h->psram, h->bytes);
+    h->magic = 0;
+    heap_caps_free(h);
+}
+
+bool memInPsram(const void* ptr) {
+    const MemHeader* h = ptr ? headerOf(ptr) : nullptr;
+    return h && h->psram;
+}
+
+MemUsage memUsage(MemSubsystem sub) {
+    MemUsage usage = {};
+    if (sub < MEM_SUBSYSTEMS) {
+        const MemCounters& c = counters[sub];
+        usage.psram = c.psram.load();
+        usage.internal = c.internal.load();
+        usage.peak = c.peak.load();
+        usage.failures = c.failures.load();
+    }
+    return usage;
+}
+
+const char* memSubsystemName(MemSubsystem sub) {
+    return sub < MEM_SUBSYSTEMS ? SUBSYSTEM_NAMES[sub] : "?";
+}
+
+HeapRegionStats memRegionStats(bool psram) {
+    uint32_t caps = (psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT;
+    HeapRegionStats stats;
+    stats.total = heap_caps_get_total_size(caps);
+    stats.free = heap_caps_get_free_size(caps);
+    stats.largest = heap_caps_get_largest_free_block(caps);
+    stats.minFree = heap_caps_get_minimum_free_size(caps);
+    stats.fragmentation = stats.free > 0 ? 100 - (uint8_t)((uint64_t)stats.largest * 100 / stats.free) : 0;
+    return stats;
+}
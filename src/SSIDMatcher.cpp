@@ -0,0 +1,164 @@
+#include "SSIDMatcher.h"
+
+constexpr int SSIDMatcher::NO_MATCH;
+
+SSIDMatcher::SSIDMatcher() : exactMask(0) {}
+
+uint32_t SSIDMatcher::hash(const char* s, size_t len) {
+    // FNV-1a, 32-bit
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void SSIDMatcher::compile(const std::vector<String>& list) {
+    patterns = list;
+    globs.clear();
+    trie.clear();
+
+    // Root node of the prefix trie
+    TrieNode root = { -1, -1, -1, 0 };
+    trie.push_back(root);
+
+    // Size the exact table to a power of two at <= 50% load
+    size_t slots = 8;
+    while (slots < patterns.size() * 2) {
+        slots <<= 1;
+    }
+    ExactSlot empty = { 0, -1 };
+    exactTable.assign(slots, empty);
+    exactMask = slots - 1;
+
+    for (size_t i = 0; i < patterns.size(); i++) {
+        const String& p = patterns[i];
+        int star = p.indexOf('*');
+        int question = p.indexOf('?');
+
+        if (star < 0 && question < 0) {
+            insertExact(p, i);
+        } else if (question < 0 && star == (int)p.length() - 1) {
+            insertPrefix(p.c_str(), p.length() - 1, i);
+        } else {
+            globs.push_back(i);
+        }
+    }
+}
+
+void SSIDMatcher::insertExact(const String& ssid, int index) {
+    uint32_t h = hash(ssid.c_str(), ssid.length());
+    uint32_t slot = h & exactMask;
+
+    while (exactTable[slot].index >= 0) {
+        // Duplicate entry in the config: keep the first one
+        if (exactTable[slot].hash == h && patterns[exactTable[slot].index] == ssid) {
+            return;
+        }
+        slot = (slot + 1) & exactMask;
+    }
+    exactTable[slot].hash = h;
+    exactTable[slot].index = index;
+}
+
+int SSIDMatcher::findChild(int node, char ch) const {
+    for (int c = trie[node].firstChild; c >= 0; c = trie[c].nextSibling) {
+        if (trie[c].ch == ch) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+void SSIDMatcher::insertPrefix(const char* prefix, size_t len, int index) {
+    int node = 0;
+    for (size_t i = 0; i < len; i++) {
+        int child = findChild(node, prefix[i]);
+        if (child < 0) {
+            TrieNode n = { -1, trie[node].firstChild, -1, prefix[i] };
+            child = trie.size();
+            trie.push_back(n);
+            trie[node].firstChild = child;
+        }
+        node = child;
+    }
+    if (trie[node].terminal < 0) {
+        trie[node].terminal = index;
+    }
+}
+
+int SSIDMatcher::match(const char* ssid, size_t len) const {
+    if (patterns.empty()) {
+        return NO_MATCH;
+    }
+
+    // 1. Exact names
+    uint32_t h = hash(ssid, len);
+    for (uint32_t slot = h & exactMask; exactTable[slot].index >= 0; slot = (slot + 1) & exactMask) {
+        const ExactSlot& s = exactTable[slot];
+        if (s.hash == h) {
+            const String& p = patterns[s.index];
+            if (p.length() == len && memcmp(p.c_str(), ssid, len) == 0) {
+                return s.index;
+            }
+        }
+    }
+
+    // 2. Longest matching prefix
+    int best = trie[0].terminal;
+    int node = 0;
+    for (size_t i = 0; i < len; i++) {
+        node = findChild(node, ssid[i]);
+        if (node < 0) {
+            break;
+        }
+        if (trie[node].terminal >= 0) {
+            best = trie[node].terminal;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+
+    // 3. General globs
+    for (int16_t index : globs) {
+        if (globMatch(patterns[index].c_str(), ssid, len)) {
+            return index;
+        }
+    }
+
+    return NO_MATCH;
+}
+
+bool SSIDMatcher::isWildcard(int index) const {
+    const String& p = patterns[index];
+    return p.indexOf('*') >= 0 || p.indexOf('?') >= 0;
+}
+
+bool SSIDMatcher::globMatch(const char* pattern, const char* text, size_t textLen) {
+    // Iterative '*' / '?' matcher with single-star backtracking
+    const char* p = pattern;
+    size_t t = 0;
+    const char* starP = nullptr;
+    size_t starT = 0;
+
+    while (t < textLen) {
+        if (*p == '?' || (*p != '*' && *p != '\0' && *p == text[t])) {
+            p++;
+            t++;
+        } else if (*p == '*') {
+            starP = p++;
+            starT = t;
+        } else if (starP) {
+            p = starP + 1;
+            t = ++starT;
+        } else {
+            return false;
+        }
+    }
+    while (*p == '*') {
+        p++;
+    }
+    return *p == '\0';
+}
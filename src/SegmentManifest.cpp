@@ -0,0 +1,197 @@
+#include "SegmentManifest.h"
+#include "BinaryLogWriter.h"
+#include <SD.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <time.h>
+
+static const char* const SEGMENT_PREFIX = "deauthdetect_session_";
+static const char* const MANIFEST_HEADER = "name,opened,closed,first_event,last_event,events,bytes";
+
+static size_t fileSize(const String& path) {
+    File f = SD.open(path.c_str(), FILE_READ);
+    if (!f) {
+        return 0;
+    }
+    size_t size = f.size();
+    f.close();
+    return size;
+}
+
+String SegmentManifest::path(const char* name, const char* ext) const {
+    return dir + "/" + name + ext;
+}
+
+void SegmentManifest::load(const char* directory) {
+    dir = directory;
+    entries.clear();
+    File f = SD.open((dir + "/manifest.csv").c_str(), FILE_READ);
+    if (!f) {
+        rebuild();
+        save();
+        return;
+    }
+
+    f.readStringUntil('\n');    // header
+    while (f.available()) {
+        String line = f.readStringUntil('\n');
+        line.trim();
+        SegmentInfo info = {};
+        if (sscanf(line.c_str(), "%39[^,],%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32,
+                   info.name, &info.opened, &info.closed, &info.firstEvent, &info.lastEvent,
+                   &info.events, &info.bytes) == 7) {
+            entries.push_back(info);
+        }
+    }
+    f.close();
+
+    // Forget segments deleted by hand; close the one a reboot interrupted
+    for (size_t i = 0; i < entries.size();) {
+        SegmentInfo& info = entries[i];
+        if (!SD.exists(path(info.name, ".csv").c_str()) && !SD.exists(path(info.name, ".csv.ddz").c_str()) &&
+            !SD.exists(path(info.name, ".ddb").c_str())) {
+            entries.erase(entries.begin() + i);
+            continue;
+        }
+        if (info.closed == 0) {
+            repair(info);
+        }
+        i++;
+    }
+    save();
+}
+
+// First run with a manifest, or it was deleted: every session CSV in the
+// directory becomes a closed segment
+void SegmentManifest::rebuild() {
+    File root = SD.open(dir.c_str(), FILE_READ);
+    if (!root) {
+        return;
+    }
+    size_t prefixLen = strlen(SEGMENT_PREFIX);
+    for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+        String name = f.name();
+        f.close();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) {
+            name = name.substring(slash + 1);
+        }
+        // Plain or compressed CSV
+        size_t extLen = name.endsWith(".csv") ? 4 : name.endsWith(".csv.ddz") ? 8 : 0;
+        if (!name.startsWith(SEGMENT_PREFIX) || extLen == 0 || name.length() - extLen >= sizeof(SegmentInfo::name)) {
+            continue;
+        }
+
+        SegmentInfo info = {};
+        strlcpy(info.name, name.c_str(), name.length() - extLen + 1);
+        struct tm tm = {};
+        if (sscanf(info.name + prefixLen, "%4d%2d%2d_%2d%2d%2d",
+                   &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) == 6) {
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            info.opened = (uint32_t)mktime(&tm);
+        }
+        repair(info);
+        entries.push_back(info);
+    }
+    root.close();
+
+    std::sort(entries.begin(), entries.end(), [](const SegmentInfo& a, const SegmentInfo& b) {
+        return a.opened != b.opened ? a.opened < b.opened : strcmp(a.name, b.name) < 0;
+    });
+}
+
+// Sizes come from the files; event count and range from the binary log's
+// block index, which is current up to its last flush
+void SegmentManifest::repair(SegmentInfo& info) {
+    info.bytes = fileSize(path(info.name, ".csv")) + fileSize(path(info.name, ".csv.ddz")) +
+                 fileSize(path(info.name, ".ddb"));
+
+    File f = SD.open(path(info.name, ".ddb").c_str(), FILE_READ);
+    if (f) {
+        BlogFileSource source = {f};
+        PsramVector<BlogDictEntry, MEM_LOGS> dict(BLOG_DICT_ENTRIES);
+        BlogReader<BlogFileSource> reader(source, dict.data());
+        if (reader.open()) {
+            uint32_t events = 0;
+            BlogIndex index;
+            for (uint32_t b = 0; b < reader.blockCount() && reader.readIndex(b, index); b++) {
+                if (b == 0) {
+                    info.firstEvent = (uint32_t)(index.firstUs / 1000000);
+                }
+                info.lastEvent = (uint32_t)(index.lastUs / 1000000);
+                events += index.count;
+            }
+            info.events = events;
+        }
+        f.close();
+    }
+    info.closed = info.lastEvent > info.opened ? info.lastEvent : info.opened;
+    if (info.closed == 0) {
+        info.closed = 1;    // 0 would read as still open
+    }
+}
+
+bool SegmentManifest::save() {
+    String tmp = dir + "/manifest.tmp";
+    String target = dir + "/manifest.csv";
+    File f = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!f) {
+        return false;
+    }
+    f.println(MANIFEST_HEADER);
+    char line[128];
+    for (const SegmentInfo& info : entries) {
+        snprintf(line, sizeof(line), "%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32,
+                 info.name, info.opened, info.closed, info.firstEvent, info.lastEvent, info.events, info.bytes);
+        f.println(line);
+    }
+    f.close();
+
+    // FAT has no atomic replace; a crash in between leaves manifest.tmp and
+    // no manifest, and the next boot rebuilds it from the directory
+    SD.remove(target.c_str());
+    return SD.rename(tmp.c_str(), target.c_str());
+}
+
+SegmentInfo& SegmentManifest::open(const char* name, uint32_t opened) {
+    SegmentInfo info = {};
+    strlcpy(info.name, name, sizeof(info.name));
+    info.opened = opened;
+    entries.push_back(info);
+    return entries.back();
+}
+
+SegmentInfo* SegmentManifest::current() {
+    return !entries.empty() && entries.back().closed == 0 ? &entries.back() : nullptr;
+}
+
+void SegmentManifest::closeCurrent(uint32_t closed) {
+    SegmentInfo* info = current();
+    if (info) {
+        info->closed = closed > info->opened ? closed : info->opened;
+        if (info->closed == 0) {
+            info->closed = 1;
+        }
+    }
+}
+
+size_t SegmentManifest::enforceBudget(uint64_t budgetBytes) {
+    size_t deleted = 0;
+    while (budgetBytes > 0 && totalBytes() > budgetBytes && !entries.empty() && entries.front().closed != 0) {
+        SD.remove(path(entries.front().name, ".csv").c_str());
+        SD.remove(path(entries.front().name, ".csv.ddz").c_str());
+        SD.remove(path(entries.front().name, ".ddb").c_str());
+        entries.erase(entries.begin());
+        deleted++;
+    }
+    return deleted;
+}
+
+uint64_t SegmentManifest::totalBytes() const {
+    uint64_t total = 0;
+    for (const SegmentInfo& info : entries) {
+        total += info.bytes;
+    }
+    return total;
+}
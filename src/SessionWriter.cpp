@@ -0,0 +1,441 @@
+#include "SessionWriter.h"
+#include "Logger.h"
+#include "OuiLookup.h"
+#include "PsramAllocator.h"
+#include <sys/time.h>
+#include <time.h>
+
+// Longest CSV line append() can produce, with room to spare
+static const size_t SESSION_LINE_MAX = 256;
+
+static void raiseTo(std::atomic<uint32_t>& value, uint32_t candidate) {
+    uint32_t seen = value.load();
+    while (candidate > seen && !value.compare_exchange_weak(seen, candidate)) {
+    }
+}
+
+SessionWriter::SessionWriter()
+    : options(), manifestLock(nullptr), queue(nullptr), synced(nullptr), task(nullptr), buffer(nullptr),
+      used(0), bufferedEvents(0), oldestMs(0), bufferFirst(0), bufferLast(0), windowStart(0), windowEvents(0),
+      segmentBytes(0), storedClosed(0), segmentOpened(0), segmentOpen(false), segmentEvents(0), segmentFirst(0), segmentLast(0), counters() {}
+
+bool SessionWriter::begin(const char* dir, const char* csvHeader, const SessionLogOptions& logOptions,
+                          const char* journalPath) {
+    if (task) {
+        return false;   // one writer per boot; the task owns the files
+    }
+    header = csvHeader;
+    options = logOptions;
+
+    buffer = (char*)memAlloc(MEM_LOGS, SESSION_BUFFER_SIZE);
+    queue = xQueueCreate(SESSION_QUEUE_DEPTH, sizeof(Message));
+    synced = xSemaphoreCreateBinary();
+    manifestLock = xSemaphoreCreateMutex();
+    if (!buffer || !queue || !synced || !manifestLock) {
+        return false;
+    }
+
+    // The task isn't running yet, so no locking until it is
+    manifest.load(dir);
+    segmentOpen = openSegment();
+    if (!segmentOpen) {
+        return false;
+    }
+    // Without a journal events are still logged, just not replayed after a crash
+    if (journalPath && !journal.begin(journalPath)) {
+        LOG_WARN("Event journal unavailable");
+    }
+    // Core 0 at low priority: card writes yield to WiFi and never preempt
+    // the main loop on core 1
+    return xTaskCreatePinnedToCore(taskEntry, "sessionlog", 4096, this, 1, &task, 0) == pdPASS;
+}
+
+// Starts a segment named after the current time: CSV with its header,
+// binary log, manifest entry. Then trims old segments to the budget.
+bool SessionWriter::openSegment() {
+    time_t now = time(nullptr);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    char name[sizeof(SegmentInfo::name)];
+    strftime(name, sizeof(name), "deauthdetect_session_%Y%m%d_%H%M%S", &timeinfo);
+
+    // Size rotation can outpace the clock's one-second resolution
+    size_t len = strlen(name);
+    for (int n = 2; n < 100 && (SD.exists(manifest.path(name, ".csv").c_str()) ||
+                                SD.exists(manifest.path(name, ".csv.ddz").c_str())); n++) {
+        snprintf(name + len, sizeof(name) - len, "_%d", n);
+    }
+
+    path = manifest.path(name, csvExtension());
+    if (options.compress) {
+        if (!packed.begin(path.c_str())) {
+            return false;
+        }
+        String line = header + "\r\n";
+        packed.append(line.c_str(), line.length(), (uint32_t)now, (uint32_t)now);
+        packed.flush();
+        segmentBytes = line.length();
+    } else {
+        file = SD.open(path.c_str(), FILE_WRITE);
+        if (!file) {
+            return false;
+        }
+        segmentBytes = file.println(header);
+        file.flush();
+    }
+
+    // The binary log is optional; the CSV alone is still a complete segment
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    binary.begin(manifest.path(name, ".ddb").c_str(), (int64_t)tv.tv_sec * 1000000 + tv.tv_usec);
+
+    segmentOpened = (uint32_t)now;
+    segmentEvents = 0;
+    segmentFirst = 0;
+    segmentLast = 0;
+    counters.segments.fetch_add(1);
+
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    SegmentInfo& info = manifest.open(name, (uint32_t)now);
+    info.bytes = csvStoredBytes() + binary.bytes();
+    counters.segmentsDeleted.fetch_add(manifest.enforceBudget(options.budgetBytes));
+    manifest.save();
+    xSemaphoreGive(manifestLock);
+    return true;
+}
+
+void SessionWriter::closeSegment() {
+    binary.close();
+    packed.close();
+    file.close();
+    storedClosed += csvStoredBytes();
+    updateManifest();
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    manifest.closeCurrent((uint32_t)time(nullptr));
+    xSemaphoreGive(manifestLock);
+}
+
+// Closes the current segment and starts the next. If that fails, lines
+// are dropped and counted as write errors, and each flush tries again.
+void SessionWriter::rotate() {
+    flush();
+    closeSegment();
+    segmentOpen = openSegment();
+    if (!segmentOpen) {
+        counters.writeErrors.fetch_add(1);
+        LOG_WARN("Could not start a new session log segment, retrying");
+    }
+}
+
+bool SessionWriter::rotationDue() const {
+    if (options.segmentMaxBytes && segmentBytes + used >= options.segmentMaxBytes) {
+        return true;
+    }
+    // Wall clock, so the segment opened before NTP sync (named 1970...)
+    // is closed by the first event after it
+    uint32_t now = (uint32_t)time(nullptr);
+    return options.segmentMaxSeconds && (now >= segmentOpened + options.segmentMaxSeconds || now < segmentOpened);
+}
+
+size_t SessionWriter::csvStoredBytes() const {
+    if (!segmentOpen) {
+        return 0;
+    }
+    return options.compress ? packed.bytes() : segmentBytes;
+}
+
+// Moves what was written since the last call into the current manifest
+// entry; the file itself is only rewritten on rotation and sync
+void SessionWriter::updateManifest() {
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    SegmentInfo* info = manifest.current();
+    if (info) {
+        if (segmentEvents > 0) {
+            if (info->firstEvent == 0) {
+                info->firstEvent = segmentFirst;
+            }
+            info->lastEvent = segmentLast;
+            info->events += segmentEvents;
+        }
+        info->bytes = csvStoredBytes() + binary.bytes();
+    }
+    xSemaphoreGive(manifestLock);
+    counters.storedBytes.store(storedClosed + csvStoredBytes());
+    segmentEvents = 0;
+}
+
+bool SessionWriter::enqueue(const DeauthEvent& event) {
+    Message message;
+    message.kind = Message::EVENT;
+    message.event = event;
+    if (!queue || xQueueSend(queue, &message, 0) != pdTRUE) {
+        counters.rejected.fetch_add(1);
+        return false;
+    }
+    counters.queued.fetch_add(1);
+    raiseTo(counters.queueHighWater, SESSION_QUEUE_DEPTH - uxQueueSpacesAvailable(queue));
+    return true;
+}
+
+size_t SessionWriter::space() const {
+    return queue ? uxQueueSpacesAvailable(queue) : 0;
+}
+
+size_t SessionWriter::admit(size_t wanted) {
+    size_t room = space();
+    if (room < wanted) {
+        counters.throttled.fetch_add(1);
+        return room;
+    }
+    return wanted;
+}
+
+bool SessionWriter::sync(uint32_t timeoutMs) {
+    if (!task) {
+        return false;
+    }
+    Message marker = {};
+    marker.kind = Message::SYNC;
+    xSemaphoreTake(synced, 0);      // a give left over from a timed-out sync
+    if (xQueueSend(queue, &marker, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+        return false;
+    }
+    return xSemaphoreTake(synced, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void SessionWriter::journalAck(uint64_t seq) {
+    if (!task || !journal.isOpen()) {
+        return;
+    }
+    Message message = {};
+    message.kind = Message::ACK;
+    message.event.seq = seq;
+    xQueueSend(queue, &message, 0);
+}
+
+void SessionWriter::consumeJournalBacklog(size_t count) {
+    if (!journal.consumeBacklog(count) || !task) {
+        return;
+    }
+    // Unlike an ack this one must get through, or the next boot replays
+    // the whole backlog again
+    Message message = {};
+    message.kind = Message::CLEAR;
+    if (xQueueSend(queue, &message, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        counters.writeErrors.fetch_add(1);
+    }
+}
+
+SessionWriterStats SessionWriter::getStats() const {
+    SessionWriterStats stats;
+    stats.queued = counters.queued.load();
+    stats.written = counters.written.load();
+    stats.rejected = counters.rejected.load();
+    stats.throttled = counters.throttled.load();
+    stats.flushes = counters.flushes.load();
+    stats.writeErrors = counters.writeErrors.load();
+    stats.queueHighWater = counters.queueHighWater.load();
+    stats.maxFlushUs = counters.maxFlushUs.load();
+    stats.peakEventsPerSec = counters.peakEventsPerSec.load();
+    stats.bytes = counters.bytes.load();
+    stats.storedBytes = counters.storedBytes.load();
+    stats.segments = counters.segments.load();
+    stats.segmentsDeleted = counters.segmentsDeleted.load();
+    return stats;
+}
+
+String SessionWriter::currentPath(const char* ext) {
+    if (!manifestLock) {
+        return "";
+    }
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    SegmentInfo* info = manifest.current();
+    String result = info ? manifest.path(info->name, ext) : "";
+    xSemaphoreGive(manifestLock);
+    return result;
+}
+
+size_t SessionWriter::segmentCount() {
+    if (!manifestLock) {
+        return 0;
+    }
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    size_t n = manifest.size();
+    xSemaphoreGive(manifestLock);
+    return n;
+}
+
+size_t SessionWriter::copySegments(SegmentInfo* out, size_t max) {
+    if (!manifestLock) {
+        return 0;
+    }
+    xSemaphoreTake(manifestLock, portMAX_DELAY);
+    size_t n = manifest.size() < max ? manifest.size() : max;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = manifest.at(i);
+    }
+    xSemaphoreGive(manifestLock);
+    return n;
+}
+
+void SessionWriter::taskEntry(void* arg) {
+    static_cast<SessionWriter*>(arg)->run();
+}
+
+void SessionWriter::run() {
+    Message message;
+    for (;;) {
+        // Sleep until the next event, or until the oldest buffered line is due
+        TickType_t wait = portMAX_DELAY;
+        if (used > 0 || journal.pending()) {
+            unsigned long age = millis() - oldestMs;
+            wait = age >= SESSION_FLUSH_MS ? 0 : pdMS_TO_TICKS(SESSION_FLUSH_MS - age);
+        }
+
+        if (xQueueReceive(queue, &message, wait) != pdTRUE) {
+            flush();
+            continue;
+        }
+        if (message.kind == Message::ACK || message.kind == Message::CLEAR) {
+            // Journal-only records ride along with the next flush
+            if (used == 0 && !journal.pending()) {
+                oldestMs = millis();
+            }
+            if (message.kind == Message::ACK) {
+                journal.ack(message.event.seq);
+            } else {
+                journal.clearBacklog();
+            }
+            continue;
+        }
+        if (message.kind == Message::SYNC) {
+            flush();
+            updateManifest();
+            xSemaphoreTake(manifestLock, portMAX_DELAY);
+            manifest.save();
+            xSemaphoreGive(manifestLock);
+            xSemaphoreGive(synced);
+            continue;
+        }
+
+        if (segmentOpen && rotationDue()) {
+            rotate();
+        }
+        append(message.event);
+        if (used >= SESSION_FLUSH_BYTES || millis() - oldestMs >= SESSION_FLUSH_MS) {
+            flush();
+        }
+    }
+}
+
+void SessionWriter::append(const DeauthEvent& event) {
+    if (SESSION_BUFFER_SIZE - used < SESSION_LINE_MAX) {
+        flush();
+    }
+    if (used == 0) {
+        oldestMs = millis();
+        bufferFirst = (uint32_t)event.timestamp;
+    }
+    bufferLast = (uint32_t)event.timestamp;
+
+    char timestamp[32];
+    struct tm timeinfo;
+    localtime_r(&event.timestamp, &timeinfo);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+
+    size_t room = SESSION_BUFFER_SIZE - used;
+    int n = snprintf(buffer + used, room,
+                     "%s,\"%s\",\"%s\",\"%s\",%d,%d,%d,\"%s\",%d,%d,\"%s\",%d\r\n",
+                     timestamp, event.target_ssid, event.target_bssid, event.attacker_mac,
+                     event.channel, event.rssi, event.packet_count, event.tool,
+                     event.tool_confidence, event.denylisted ? 1 : 0,
+                     ouiVendorName(event.vendor), event.randomized ? 1 : 0);
+    if (n > 0) {
+        used += (size_t)n < room ? (size_t)n : room - 1;
+        bufferedEvents++;
+    }
+    binary.append(event);
+    journal.append(event);
+
+    uint32_t seconds = (uint32_t)event.timestamp;
+    if (segmentFirst == 0) {
+        segmentFirst = seconds;
+    }
+    segmentLast = seconds;
+    segmentEvents++;
+}
+
+void SessionWriter::flush() {
+    if (used > 0 && !segmentOpen) {
+        // The buffered lines go into the new segment, so keep their counts
+        uint32_t events = segmentEvents, first = segmentFirst, last = segmentLast;
+        segmentOpen = openSegment();
+        if (segmentOpen) {
+            segmentEvents = events;
+            segmentFirst = first;
+            segmentLast = last;
+        } else {
+            counters.writeErrors.fetch_add(1);
+            used = 0;
+            bufferedEvents = 0;
+            segmentEvents = 0;
+        }
+    }
+    if (used == 0) {
+        if (journal.pending() && !journal.flush()) {
+            counters.writeErrors.fetch_add(1);
+        }
+        return;
+    }
+
+    unsigned long start = micros();
+    size_t done;
+    if (options.compress) {
+        packed.append(buffer, used, bufferFirst, bufferLast);
+        done = packed.flush() ? used : 0;
+    } else {
+        // Reopen after a failed write; the card may have been reseated
+        if (!file) {
+            file = SD.open(path.c_str(), FILE_APPEND);
+        }
+        done = file ? file.write((const uint8_t*)buffer, used) : 0;
+        if (file) {
+            file.flush();
+        }
+    }
+    bool binaryOk = binary.flush();
+    bool journalOk = journal.flush();
+    uint32_t elapsed = micros() - start;
+
+    counters.flushes.fetch_add(1);
+    raiseTo(counters.maxFlushUs, elapsed);
+    if (!binaryOk || !journalOk) {
+        counters.writeErrors.fetch_add(1);
+    }
+    if (done == used) {
+        counters.written.fetch_add(bufferedEvents);
+        counters.bytes.fetch_add(used);
+        windowEvents += bufferedEvents;
+        segmentBytes += used;
+    } else if (options.compress) {
+        // Still in the open block, which the next flush rewrites; a block
+        // that is sealed unwritten is dropped
+        counters.writeErrors.fetch_add(1);
+        segmentBytes += used;
+    } else {
+        // Lines that didn't make it are dropped rather than held: a missing
+        // card would otherwise stall the queue and with it the event ring
+        counters.writeErrors.fetch_add(1);
+        file.close();
+    }
+    used = 0;
+    bufferedEvents = 0;
+    updateManifest();
+
+    unsigned long now = millis();
+    if (now - windowStart >= 1000) {
+        raiseTo(counters.peakEventsPerSec, (uint32_t)((uint64_t)windowEvents * 1000 / (now - windowStart)));
+        windowStart = now;
+        windowEvents = 0;
+    }
+}
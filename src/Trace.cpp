@@ -0,0 +1,20 @@
+#include "Trace.h"
+#include "PsramAllocator.h"
+
+TraceRing traceRing;
+bool traceActive = false;
+std::atomic<uint32_t> traceDropped(0);
+
+bool traceBegin() {
+    if (!traceRing.isReady()) {
+        // Internal RAM: the WiFi task writes here for every captured frame
+        void* slots = memAlloc(MEM_LOGS, TraceRing::bytes(), MEM_INTERNAL_ONLY);
+        if (!slots) {
+            return false;
+        }
+        traceRing.begin(slots);
+    }
+    traceActive = true;
+    TRACE(TRACE_START, traceFormatHash());
+    return true;
+}
@@ -0,0 +1,283 @@
+#include "TrendStore.h"
+#include <SD.h>
+#include "PsramAllocator.h"
+
+static const uint32_t BUCKET_SECONDS[TREND_LEVELS] = { 1, 60, 3600 };
+static const size_t BUCKET_COUNT[TREND_LEVELS] = { 300, 1440, 168 };
+
+static const uint32_t TREND_FILE_MAGIC = 0x52544444;   // "DDTR"
+static const uint16_t TREND_FILE_VERSION = 1;
+
+struct TrendFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t series;
+    uint32_t slots;
+    int64_t  head[TREND_LEVELS];
+};
+
+TrendStore::TrendStore() : counts(nullptr), fileMatches(false) {
+    for (int i = 0; i < TREND_LEVELS; i++) {
+        head[i] = -1;
+        unsaved[i] = INT64_MAX;
+    }
+}
+
+TrendStore::~TrendStore() {
+    memFree(counts);
+}
+
+uint32_t TrendStore::bucketSeconds(TrendLevel level) {
+    return BUCKET_SECONDS[level];
+}
+
+size_t TrendStore::bucketCount(TrendLevel level) {
+    return BUCKET_COUNT[level];
+}
+
+size_t TrendStore::levelOffset(TrendLevel level) {
+    size_t offset = 0;
+    for (int i = 0; i < level; i++) {
+        offset += BUCKET_COUNT[i] * TREND_SERIES;
+    }
+    return offset;
+}
+
+size_t TrendStore::totalSlots() {
+    return levelOffset(TREND_LEVELS);
+}
+
+bool TrendStore::begin() {
+    if (counts) {
+        return true;
+    }
+    counts = (uint32_t*)memAlloc(MEM_TRENDS, totalSlots() * sizeof(uint32_t));
+    return counts != nullptr;
+}
+
+uint32_t* TrendStore::slot(TrendLevel level, int64_t number) {
+    return counts + levelOffset(level) + (size_t)(number % BUCKET_COUNT[level]) * TREND_SERIES;
+}
+
+void TrendStore::touch(TrendLevel level, int64_t number) {
+    if (number < unsaved[level]) {
+        unsaved[level] = number;
+    }
+}
+
+void TrendStore::advance(TrendLevel level, int64_t number) {
+    if (number <= head[level]) {
+        return;
+    }
+
+    int64_t len = BUCKET_COUNT[level];
+    if (head[level] < 0 || number - head[level] >= len) {
+        memset(counts + levelOffset(level), 0, len * TREND_SERIES * sizeof(uint32_t));
+        head[level] = number;
+        touch(level, number - len + 1);
+        return;
+    }
+    touch(level, head[level] + 1);
+    while (head[level] < number) {
+        head[level]++;
+        memset(slot(level, head[level]), 0, TREND_SERIES * sizeof(uint32_t));
+    }
+}
+
+void TrendStore::record(time_t now, int ssidIndex, int channel) {
+    if (!counts || channel < 1 || channel > TREND_CHANNELS) {
+        return;
+    }
+
+    for (int i = 0; i < TREND_LEVELS; i++) {
+        TrendLevel level = (TrendLevel)i;
+        int64_t number = (int64_t)now / BUCKET_SECONDS[i];
+        advance(level, number);
+        if (number <= head[i] - (int64_t)BUCKET_COUNT[i]) {
+            continue;   // older than the ring reaches
+        }
+
+        uint32_t* bucket = slot(level, number);
+        touch(level, number);
+        bucket[channelSeries(channel)]++;
+        if (ssidIndex >= 0 && ssidIndex < TREND_MAX_SSIDS) {
+            bucket[ssidSeries(ssidIndex)]++;
+        }
+    }
+}
+
+size_t TrendStore::query(TrendLevel level, int series, time_t now, uint32_t* out, size_t max) {
+    if (!counts || series < 0 || series >= TREND_SERIES) {
+        return 0;
+    }
+
+    int64_t number = (int64_t)now / BUCKET_SECONDS[level];
+    advance(level, number);
+
+    size_t n = max < BUCKET_COUNT[level] ? max : BUCKET_COUNT[level];
+    for (size_t i = 0; i < n; i++) {
+        int64_t b = head[level] - (int64_t)(n - 1 - i);
+        out[i] = b >= 0 ? slot(level, b)[series] : 0;
+    }
+    return n;
+}
+
+uint32_t TrendStore::total(TrendLevel level, time_t now, size_t buckets) {
+    if (!counts) {
+        return 0;
+    }
+
+    advance(level, (int64_t)now / BUCKET_SECONDS[level]);
+
+    if (buckets > BUCKET_COUNT[level]) {
+        buckets = BUCKET_COUNT[level];
+    }
+    uint32_t sum = 0;
+    for (size_t i = 0; i < buckets && head[level] - (int64_t)i >= 0; i++) {
+        const uint32_t* bucket = slot(level, head[level] - i);
+        for (int ch = 1; ch <= TREND_CHANNELS; ch++) {
+            sum += bucket[channelSeries(ch)];
+        }
+    }
+    return sum;
+}
+
+static void fillHeader(TrendFileHeader& header, const int64_t* head, size_t slots) {
+    header.magic = TREND_FILE_MAGIC;
+    header.version = TREND_FILE_VERSION;
+    header.series = TREND_SERIES;
+    header.slots = slots;
+    for (int i = 0; i < TREND_LEVELS; i++) {
+        header.head[i] = i == TREND_SECONDS ? -1 : head[i];
+    }
+}
+
+bool TrendStore::save(const char* path) {
+    if (!counts || time(nullptr) < TREND_MIN_VALID_TIME) {
+        return false;
+    }
+
+    bool ok = fileMatches ? writeChanges(path) : writeAll(path);
+    saved(ok);
+    return ok;
+}
+
+bool TrendStore::saveChanges(const char* path) {
+    if (!counts || !fileMatches || time(nullptr) < TREND_MIN_VALID_TIME) {
+        return false;
+    }
+    bool ok = writeChanges(path);
+    saved(ok);
+    return ok;
+}
+
+// After a failed write the file is in an unknown state until save()
+// writes it whole again
+void TrendStore::saved(bool ok) {
+    fileMatches = ok;
+    if (ok) {
+        for (int i = 0; i < TREND_LEVELS; i++) {
+            unsaved[i] = INT64_MAX;
+        }
+    }
+}
+
+// The whole file; done at boot and in config mode, since it is big enough
+// to stall monitoring
+bool TrendStore::writeAll(const char* path) {
+    File file = SD.open(path, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+
+    TrendFileHeader header;
+    fillHeader(header, head, totalSlots());
+    size_t bytes = totalSlots() * sizeof(uint32_t);
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write((const uint8_t*)counts, bytes) == bytes;
+    file.close();
+    return ok;
+}
+
+// Every 5 minutes that is a handful of minute buckets and one or two hour
+// buckets, under a kilobyte, plus the header
+bool TrendStore::writeChanges(const char* path) {
+    File file = SD.open(path, "r+");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = TREND_MINUTES; ok && i < TREND_LEVELS; i++) {
+        TrendLevel level = (TrendLevel)i;
+        if (unsaved[i] > head[i]) {
+            continue;
+        }
+        int64_t from = unsaved[i];
+        if (from < head[i] - (int64_t)BUCKET_COUNT[i] + 1) {
+            from = head[i] - (int64_t)BUCKET_COUNT[i] + 1;
+        }
+        if (from < 0) {
+            from = 0;
+        }
+        for (int64_t b = from; ok && b <= head[i]; b++) {
+            const uint32_t* bucket = slot(level, b);
+            size_t offset = sizeof(TrendFileHeader) + (bucket - counts) * sizeof(uint32_t);
+            size_t bytes = TREND_SERIES * sizeof(uint32_t);
+            ok = file.seek(offset) && file.write((const uint8_t*)bucket, bytes) == bytes;
+        }
+    }
+
+    // Last, so a save cut short keeps the previous heads; buckets already
+    // rewritten then read back misplaced, but the file stays loadable
+    TrendFileHeader header;
+    fillHeader(header, head, totalSlots());
+    ok = ok && file.seek(0) && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    file.close();
+    return ok;
+}
+
+bool TrendStore::load(const char* path, time_t now) {
+    if (!counts || now < TREND_MIN_VALID_TIME || !SD.exists(path)) {
+        return false;
+    }
+
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    TrendFileHeader header;
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == TREND_FILE_MAGIC && header.version == TREND_FILE_VERSION &&
+              header.series == TREND_SERIES && header.slots == totalSlots();
+
+    // A file from the future means the clock is wrong; leave it alone
+    for (int i = 0; ok && i < TREND_LEVELS; i++) {
+        ok = header.head[i] <= (int64_t)now / BUCKET_SECONDS[i];
+    }
+
+    size_t bytes = totalSlots() * sizeof(uint32_t);
+    if (ok) {
+        ok = file.read((uint8_t*)counts, bytes) == bytes;
+    }
+    file.close();
+
+    fileMatches = ok;
+    if (!ok) {
+        memset(counts, 0, bytes);
+        for (int i = 0; i < TREND_LEVELS; i++) {
+            head[i] = -1;
+            unsaved[i] = INT64_MAX;
+        }
+        return false;
+    }
+
+    // Only what moving up to 'now' zeroes differs from the file
+    for (int i = 0; i < TREND_LEVELS; i++) {
+        head[i] = header.head[i];
+        unsaved[i] = INT64_MAX;
+        advance((TrendLevel)i, (int64_t)now / BUCKET_SECONDS[i]);
+    }
+    return true;
+}
@@ -1,8 +1,35 @@
 #include "WebPortal.h"
 #include "Logger.h"
+#include "PsramAllocator.h"
+#include "LoopStats.h"
+#include "BinaryLogWriter.h"
+#include "OuiLookup.h"
+#include "PcapWriter.h"
+#include "CompressedLogWriter.h"
+#include "LifetimeStats.h"
+#include <algorithm>
 
-WebPortal::WebPortal(ConfigManager* configMgr) 
-    : configManager(configMgr), server(80), active(false), lastActivity(0) {}
+// Appends s as the inside of a quoted field. SSIDs and signature names are
+// arbitrary bytes: for JSON, quotes, backslashes and control bytes are
+// escaped; for CSV, quotes are doubled.
+static void appendQuoted(String& out, const char* s, bool json) {
+    for (; *s; s++) {
+        if (*s == '"') {
+            out += json ? "\\\"" : "\"\"";
+        } else if (*s == '\\' && json) {
+            out += "\\\\";
+        } else if ((unsigned char)*s < 0x20 && json) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*s);
+            out += esc;
+        } else {
+            out += *s;
+        }
+    }
+}
+
+WebPortal::WebPortal(ConfigManager* configMgr, DeauthDetector* det) 
+    : configManager(configMgr), detector(det), server(80), active(false), lastActivity(0) {}
 
 void WebPortal::begin(bool apMode) {
     server.on("/", [this]() { this->handleRoot(); });
@@ -10,13 +37,18 @@ void WebPortal::begin(bool apMode) {
     server.on("/status", [this]() { this->handleStatus(); });
     server.on("/debug/log", [this]() { this->handleDebugLog(); });
     server.on("/debug/clear", HTTP_POST, [this]() { this->handleDebugClear(); });
+    server.on("/survey", [this]() { this->handleSurvey(); });
+    server.on("/trends", [this]() { this->handleTrends(); });
+    server.on("/events", [this]() { this->handleEvents(); });
+    server.on("/log", [this]() { this->handleLog(); });
+    server.on("/segments", [this]() { this->handleSegments(); });
     server.onNotFound([this]() { this->handleNotFound(); });
     
     server.begin();
     active = true;
     lastActivity = millis();
     
-    logger.debugPrintln("Web portal started");
+    LOG_INFO("Web portal started");
 }
 
 void WebPortal::handle() {
@@ -28,7 +60,7 @@ void WebPortal::handle() {
 void WebPortal::stop() {
     server.stop();
     active = false;
-    logger.debugPrintln("Web portal stopped");
+    LOG_INFO("Web portal stopped");
 }
 
 void WebPortal::resetIdleTimer() {
@@ -125,6 +157,11 @@ void WebPortal::handleSave() {
         config.detection.channel_hop_interval_ms = server.arg("channel_hop_interval").toInt();
     }
     
+    config.survey.enabled = server.hasArg("survey_enabled");
+    if (server.hasArg("survey_bucket")) {
+        config.survey.bucket_seconds = server.arg("survey_bucket").toInt();
+    }
+    
     if (server.hasArg("api_url")) {
         config.api.endpoint_url = server.arg("api_url");
     }
@@ -147,6 +184,28 @@ void WebPortal::handleSave() {
     
     // Debug config - checkbox only sends value if checked
     config.debug.enabled = server.hasArg("debug_enabled");
+    if (server.hasArg("debug_trace")) {
+        config.debug.trace = server.arg("debug_trace");
+    }
+    
+    if (server.hasArg("segment_max_kb")) {
+        config.logging.segment_max_kb = server.arg("segment_max_kb").toInt();
+    }
+    if (server.hasArg("segment_max_minutes")) {
+        config.logging.segment_max_minutes = server.arg("segment_max_minutes").toInt();
+    }
+    if (server.hasArg("log_budget_mb")) {
+        config.logging.budget_mb = server.arg("log_budget_mb").toInt();
+    }
+    config.logging.compress = server.hasArg("log_compress");
+    
+    config.capture.enabled = server.hasArg("capture_enabled");
+    if (server.hasArg("capture_file_max_kb")) {
+        config.capture.file_max_kb = server.arg("capture_file_max_kb").toInt();
+    }
+    if (server.hasArg("capture_max_files")) {
+        config.capture.max_files = server.arg("capture_max_files").toInt();
+    }
     
     // Save to SD card
     if (configManager->saveConfig()) {
@@ -174,6 +233,119 @@ void WebPortal::handleStatus() {
     String json = "{";
     json += "\"heap\":" + String(ESP.getFreeHeap()) + ",";
     json += "\"uptime\":" + String(millis() / 1000);
+    if (detector) {
+        json += ",\"allowlisted_frames\":" + String(detector->getAllowlistedFrames());
+        json += ",\"preset\":\"" + String(DeauthDetector::presetName()) + "\"";
+    }
+
+    // Heap regions, then what each subsystem holds in them
+    json += ",\"memory\":{";
+    for (int psram = 0; psram <= 1; psram++) {
+        HeapRegionStats region = memRegionStats(psram);
+        json += psram ? ",\"psram\":{" : "\"internal\":{";
+        json += "\"total\":" + String(region.total);
+        json += ",\"free\":" + String(region.free);
+        json += ",\"largest_free\":" + String(region.largest);
+        json += ",\"min_free\":" + String(region.minFree);
+        json += ",\"fragmentation\":" + String(region.fragmentation) + "}";
+    }
+    json += ",\"subsystems\":{";
+    for (int i = 0; i < MEM_SUBSYSTEMS; i++) {
+        MemUsage usage = memUsage((MemSubsystem)i);
+        if (i > 0) json += ",";
+        json += "\"" + String(memSubsystemName((MemSubsystem)i)) + "\":{";
+        json += "\"psram\":" + String(usage.psram);
+        json += ",\"internal\":" + String(usage.internal);
+        json += ",\"peak\":" + String(usage.peak);
+        json += ",\"failures\":" + String(usage.failures) + "}";
+    }
+    json += "}}";
+
+    // Session log writer and the monitor loop it is meant to keep fast
+    SessionWriterStats log = logger.getSessionStats();
+    json += ",\"session_log\":{";
+    json += "\"queued\":" + String(log.queued);
+    json += ",\"written\":" + String(log.written);
+    json += ",\"rejected\":" + String(log.rejected);
+    json += ",\"throttled\":" + String(log.throttled);
+    json += ",\"flushes\":" + String(log.flushes);
+    json += ",\"write_errors\":" + String(log.writeErrors);
+    json += ",\"queue_high_water\":" + String(log.queueHighWater);
+    json += ",\"max_flush_us\":" + String(log.maxFlushUs);
+    json += ",\"peak_events_per_sec\":" + String(log.peakEventsPerSec);
+    json += ",\"bytes\":" + String(log.bytes);
+    json += ",\"stored_bytes\":" + String(log.storedBytes);
+    json += ",\"segments\":" + String(log.segments);
+    json += ",\"segments_deleted\":" + String(log.segmentsDeleted) + "}";
+    DebugLogStats debugLog = logger.getDebugStats();
+    json += ",\"debug_log\":{";
+    json += "\"min_level\":" + String(DEBUG_LOG_MIN_LEVEL);
+    json += ",\"queued\":" + String(debugLog.queued);
+    json += ",\"dropped\":" + String(debugLog.dropped);
+    json += ",\"written\":" + String(debugLog.written);
+    json += ",\"write_errors\":" + String(debugLog.writeErrors);
+    json += ",\"trace_records\":" + String(debugLog.traceRecords);
+    json += ",\"trace_dropped\":" + String(debugLog.traceDropped) + "}";
+    PcapStats capture = pcapWriter.getStats();
+    json += ",\"capture\":{";
+    json += "\"active\":" + String(pcapWriter.isActive() ? "true" : "false");
+    json += ",\"captured\":" + String(capture.captured);
+    json += ",\"dropped\":" + String(capture.dropped);
+    json += ",\"written\":" + String(capture.written);
+    json += ",\"write_errors\":" + String(capture.writeErrors);
+    json += ",\"files\":" + String(capture.files);
+    json += ",\"files_deleted\":" + String(capture.filesDeleted);
+    json += ",\"bytes\":" + String(capture.bytes) + "}";
+    JournalStats journal = logger.getJournalStats();
+    json += ",\"journal\":{";
+    json += "\"open\":" + String(journal.open ? "true" : "false");
+    json += ",\"backlog\":" + String(journal.backlog);
+    json += ",\"replayed\":" + String(journal.replayed);
+    json += ",\"records\":" + String(journal.records);
+    json += ",\"write_errors\":" + String(journal.writeErrors);
+    json += ",\"compactions\":" + String(journal.compactions);
+    json += ",\"overflow\":" + String(journal.overflow) + "}";
+    // Across every boot; the 64-bit totals don't fit String's constructors
+    const LifetimeCounters& life = lifetimeStats.counters();
+    LifetimeStatus lifeStatus = lifetimeStats.status();
+    char big[24];
+    json += ",\"lifetime\":{";
+    json += "\"boots\":" + String(life.boots);
+    snprintf(big, sizeof(big), "%llu", (unsigned long long)life.uptimeSeconds);
+    json += ",\"uptime\":" + String(big);
+    json += ",\"events\":" + String(life.events);
+    json += ",\"incidents\":" + String(life.incidents);
+    snprintf(big, sizeof(big), "%llu", (unsigned long long)life.frames);
+    json += ",\"frames\":" + String(big);
+    json += ",\"denylisted_events\":" + String(life.denylistedEvents);
+    snprintf(big, sizeof(big), "%llu", (unsigned long long)life.allowlistedFrames);
+    json += ",\"allowlisted_frames\":" + String(big);
+    json += ",\"dropped_events\":" + String(life.droppedEvents);
+    json += ",\"reports_sent\":" + String(life.reportsSent);
+    json += ",\"reports_rejected\":" + String(life.reportsRejected);
+    json += ",\"reports_failed\":" + String(life.reportsFailed);
+    json += ",\"events_reported\":" + String(life.eventsReported);
+    json += ",\"ssids\":[";
+    bool firstSsid = true;
+    for (const LifetimeSsid& s : life.ssids) {
+        if (!s.name[0]) break;
+        snprintf(big, sizeof(big), "%llu", (unsigned long long)s.frames);
+        json += String(firstSsid ? "" : ",") + "{\"ssid\":\"";
+        appendQuoted(json, s.name, true);
+        json += "\",\"events\":" + String(s.events) + ",\"incidents\":" + String(s.incidents);
+        json += ",\"frames\":" + String(big) + "}";
+        firstSsid = false;
+    }
+    json += "]";
+    json += ",\"loaded\":" + String(lifeStatus.loaded ? "true" : "false");
+    json += ",\"commits\":" + String(lifeStatus.commits);
+    json += ",\"commit_errors\":" + String(lifeStatus.commitErrors);
+    json += ",\"record\":" + String(lifeStatus.record) + "}";
+    json += ",\"loop\":{";
+    json += "\"passes\":" + String(loopStats.passes);
+    json += ",\"avg_us\":" + String(loopStats.averageUs());
+    json += ",\"max_us\":" + String(loopStats.maxUs);
+    json += ",\"log_max_us\":" + String(loopStats.logMaxUs) + "}";
     json += "}";
     
     server.send(200, "application/json", json);
@@ -203,8 +375,30 @@ void WebPortal::handleDebugLog() {
         return;
     }
     
-    // Stream the file content
-    server.streamFile(file, "text/plain");
+    if (!debugFile.endsWith(".ddz")) {
+        // Stream the file content
+        server.streamFile(file, "text/plain");
+        file.close();
+        return;
+    }
+    
+    // Compressed: expanded one block at a time
+    PsramVector<uint8_t, MEM_WEB> payload(DDZ_STORED_MAX);
+    PsramVector<uint8_t, MEM_WEB> text(DDZ_BLOCK_RAW);
+    DdzFileSource source = {file};
+    DdzReader<DdzFileSource> reader(source, payload.data(), text.data());
+    if (!reader.open()) {
+        file.close();
+        server.send(500, "text/plain", "Debug log file is damaged");
+        return;
+    }
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    reader.scan(0, UINT32_MAX, [&](const char* block, size_t len, const DdzBlock&) {
+        server.sendContent(block, len);
+        return true;
+    });
+    server.sendContent("");
     file.close();
 }
 
@@ -224,6 +418,437 @@ void WebPortal::handleDebugClear() {
     }
 }
 
+void WebPortal::handleSurvey() {
+    if (!authenticate()) return;
+    
+    resetIdleTimer();
+    
+    if (!detector || !detector->isSurveyEnabled()) {
+        server.send(404, "application/json", "{\"error\":\"survey disabled\"}");
+        return;
+    }
+    
+    const ChannelSurvey& survey = detector->getSurvey();
+    BasicJsonDocument<PsramJsonAllocator<MEM_WEB>> doc(24576);
+    doc["bucket_ms"] = survey.bucketMs();
+    JsonArray buckets = doc.createNestedArray("buckets");
+    
+    // Newest completed bucket first
+    for (int age = 0; age < survey.completedBuckets(); age++) {
+        JsonArray channels = buckets.createNestedArray();
+        for (int ch = 1; ch <= SURVEY_CHANNELS; ch++) {
+            SurveyCounters c;
+            if (!survey.getBucket(age, ch, c) || c.dwellMs == 0) continue;
+            
+            JsonObject obj = channels.createNestedObject();
+            obj["channel"] = ch;
+            obj["dwell_ms"] = c.dwellMs;
+            obj["frames"] = c.frames;
+            obj["mgmt"] = c.mgmt;
+            obj["retries"] = c.retries;
+            JsonArray rssi = obj.createNestedArray("rssi_bins");
+            for (int b = 0; b < SURVEY_RSSI_BINS; b++) {
+                rssi.add(c.rssiBins[b]);
+            }
+        }
+    }
+    
+    String json;
+    serializeJson(doc, json);
+    server.send(200, "application/json", json);
+}
+
+void WebPortal::handleTrends() {
+    if (!authenticate()) return;
+    
+    resetIdleTimer();
+    
+    if (!detector || !detector->getTrends().isReady()) {
+        server.send(404, "application/json", "{\"error\":\"trends unavailable\"}");
+        return;
+    }
+    
+    String res = server.hasArg("res") ? server.arg("res") : "minute";
+    TrendLevel level = res == "second" ? TREND_SECONDS : (res == "hour" ? TREND_HOURS : TREND_MINUTES);
+    size_t count = TrendStore::bucketCount(level);
+    if (server.hasArg("count")) {
+        long requested = server.arg("count").toInt();
+        if (requested > 0 && (size_t)requested < count) {
+            count = requested;
+        }
+    }
+    
+    TrendStore& trends = detector->getTrends();
+    time_t now = time(nullptr);
+    time_t bucketSeconds = TrendStore::bucketSeconds(level);
+    PsramVector<uint32_t, MEM_WEB> counts(count);
+    
+    // Up to 22 series of 1440 buckets won't fit a JSON document, so the
+    // response is streamed one series at a time
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    
+    String chunk = "{\"resolution\":\"" + String(level == TREND_SECONDS ? "second" : (level == TREND_HOURS ? "hour" : "minute")) + "\"";
+    chunk += ",\"bucket_seconds\":" + String((unsigned long)bucketSeconds);
+    chunk += ",\"end\":" + String((unsigned long)(now - now % bucketSeconds));
+    chunk += ",\"ssids\":[";
+    
+    const std::vector<String>& ssids = configManager->getConfig().detection.protected_ssids;
+    for (size_t i = 0; i < ssids.size() && i < (size_t)TREND_MAX_SSIDS; i++) {
+        trends.query(level, TrendStore::ssidSeries(i), now, counts.data(), count);
+        if (i > 0) chunk += ",";
+        chunk += "{\"name\":\"";
+        appendQuoted(chunk, ssids[i].c_str(), true);
+        chunk += "\",\"counts\":[";
+        for (size_t b = 0; b < count; b++) {
+            if (b > 0) chunk += ",";
+            chunk += String(counts[b]);
+            if (chunk.length() > 1024) {
+                server.sendContent(chunk);
+                chunk = "";
+            }
+        }
+        chunk += "]}";
+    }
+    chunk += "]";
+    // Only the first TREND_MAX_SSIDS entries have a series of their own
+    size_t omitted = ssids.size() > (size_t)TREND_MAX_SSIDS ? ssids.size() - TREND_MAX_SSIDS : 0;
+    chunk += ",\"ssid_limit\":" + String(TREND_MAX_SSIDS);
+    chunk += ",\"ssids_omitted\":" + String((unsigned)omitted);
+    chunk += ",\"channels\":[";
+    
+    // Channels with no deauths in the window are left out
+    bool first = true;
+    for (int ch = 1; ch <= TREND_CHANNELS; ch++) {
+        trends.query(level, TrendStore::channelSeries(ch), now, counts.data(), count);
+        bool any = false;
+        for (size_t b = 0; b < count && !any; b++) {
+            any = counts[b] != 0;
+        }
+        if (!any) continue;
+        
+        if (!first) chunk += ",";
+        first = false;
+        chunk += "{\"channel\":" + String(ch) + ",\"counts\":[";
+        for (size_t b = 0; b < count; b++) {
+            if (b > 0) chunk += ",";
+            chunk += String(counts[b]);
+            if (chunk.length() > 1024) {
+                server.sendContent(chunk);
+                chunk = "";
+            }
+        }
+        chunk += "]}";
+    }
+    chunk += "]}";
+    server.sendContent(chunk);
+    server.sendContent("");
+}
+
+// Segments for /events and /log. session= names one segment in the logs
+// directory, without extension. Otherwise a from/to range reads every
+// segment the manifest says overlaps it, and no range reads the current
+// segment. A bad name is answered with 400 and returns false.
+bool WebPortal::selectSegments(PsramVector<SegmentInfo, MEM_WEB>& segments, int64_t fromUs, int64_t toUs) {
+    logger.syncSession();
+    SessionWriter& session = logger.getSession();
+    if (server.hasArg("session")) {
+        String name = server.arg("session");
+        if (name.length() == 0 || name.length() >= sizeof(SegmentInfo::name)) {
+            server.send(400, "application/json", "{\"error\":\"bad session name\"}");
+            return false;
+        }
+        for (size_t i = 0; i < name.length(); i++) {
+            char c = name[i];
+            if (!isalnum((unsigned char)c) && c != '_' && c != '-') {
+                server.send(400, "application/json", "{\"error\":\"bad session name\"}");
+                return false;
+            }
+        }
+        SegmentInfo info = {};
+        strlcpy(info.name, name.c_str(), sizeof(info.name));
+        segments.push_back(info);
+    } else {
+        segments.resize(session.segmentCount());
+        segments.resize(session.copySegments(segments.data(), segments.size()));
+        if (server.hasArg("from") || server.hasArg("to")) {
+            segments.erase(std::remove_if(segments.begin(), segments.end(), [&](const SegmentInfo& info) {
+                return info.events == 0 || (int64_t)info.lastEvent * 1000000 + 999999 < fromUs ||
+                       (int64_t)info.firstEvent * 1000000 > toUs;
+            }), segments.end());
+        } else if (!segments.empty()) {
+            if (segments.back().closed != 0) {
+                segments.clear();
+            } else {
+                segments.erase(segments.begin(), segments.end() - 1);
+            }
+        }
+    }
+    return true;
+}
+
+void WebPortal::handleEvents() {
+    if (!authenticate()) return;
+    
+    resetIdleTimer();
+    
+    bool json = server.hasArg("format") && server.arg("format") == "json";
+    int64_t fromUs = server.hasArg("from") ? (int64_t)server.arg("from").toInt() * 1000000 : INT64_MIN;
+    int64_t toUs = server.hasArg("to") ? (int64_t)server.arg("to").toInt() * 1000000 + 999999 : INT64_MAX;
+    
+    PsramVector<SegmentInfo, MEM_WEB> segments;
+    if (!selectSegments(segments, fromUs, toUs)) {
+        return;
+    }
+    
+    PsramVector<BlogDictEntry, MEM_WEB> dict(BLOG_DICT_ENTRIES);
+    
+    // A single named log is checked before the headers go out so a bad name
+    // still gets an error status; within a range, unreadable segments are
+    // skipped
+    if (server.hasArg("session")) {
+        String path = "/deauthdetector/logs/" + String(segments[0].name) + ".ddb";
+        File file = SD.open(path.c_str(), FILE_READ);
+        if (!file) {
+            server.send(404, "application/json", "{\"error\":\"session not found\"}");
+            return;
+        }
+        BlogFileSource source = {file};
+        BlogReader<BlogFileSource> reader(source, dict.data());
+        bool valid = reader.open();
+        file.close();
+        if (!valid) {
+            server.send(422, "application/json", "{\"error\":\"not a binary session log\"}");
+            return;
+        }
+    }
+    
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, json ? "application/json" : "text/csv", "");
+    
+    String chunk = json ? "[" : "timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count,tool,tool_confidence,denylisted,vendor,randomized\n";
+    bool first = true;
+    for (const SegmentInfo& info : segments) {
+        String path = "/deauthdetector/logs/" + String(info.name) + ".ddb";
+        File file = SD.open(path.c_str(), FILE_READ);
+        if (!file) {
+            continue;
+        }
+        BlogFileSource source = {file};
+        BlogReader<BlogFileSource> reader(source, dict.data());
+        if (!reader.open()) {
+            file.close();
+            continue;
+        }
+        reader.scan(fromUs, toUs, [&](const BlogEvent& e) {
+            char ssid[40], tool[40], bssid[18], attacker[18], timestamp[32];
+            time_t seconds = (time_t)(e.timeUs / 1000000);
+            struct tm timeinfo;
+            localtime_r(&seconds, &timeinfo);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+            blogFormatMac(e.bssid, bssid);
+            blogFormatMac(e.attacker, attacker);
+            reader.name(e.ssid, ssid);
+            reader.name(e.tool, tool);
+            // Field by field into the chunk, so no record can outgrow a buffer
+            if (json) {
+                char us[24];
+                snprintf(us, sizeof(us), "%lld", (long long)e.timeUs);
+                chunk += first ? "{\"timestamp\":\"" : ",{\"timestamp\":\"";
+                chunk += timestamp;
+                chunk += "\",\"timestamp_us\":";
+                chunk += us;
+                chunk += ",\"target_ssid\":\"";
+                appendQuoted(chunk, ssid, true);
+                chunk += "\",\"target_bssid\":\"";
+                chunk += bssid;
+                chunk += "\",\"attacker_mac\":\"";
+                chunk += attacker;
+                chunk += "\",\"channel\":" + String(e.channel);
+                chunk += ",\"rssi\":" + String((int)e.rssi);
+                chunk += ",\"packet_count\":" + String((unsigned)e.packetCount);
+                chunk += ",\"tool\":\"";
+                appendQuoted(chunk, tool, true);
+                chunk += "\",\"tool_confidence\":" + String(e.toolConfidence);
+                chunk += ",\"denylisted\":";
+                chunk += e.flags & BLOG_DENYLISTED ? "true" : "false";
+                chunk += ",\"vendor\":\"";
+                appendQuoted(chunk, ouiVendorName(e.vendor), true);
+                chunk += "\",\"randomized\":";
+                chunk += e.flags & BLOG_RANDOMIZED ? "true}" : "false}";
+            } else {
+                chunk += timestamp;
+                chunk += ",\"";
+                appendQuoted(chunk, ssid, false);
+                chunk += "\",\"";
+                chunk += bssid;
+                chunk += "\",\"";
+                chunk += attacker;
+                chunk += "\"," + String(e.channel) + "," + String((int)e.rssi) + "," + String((unsigned)e.packetCount) + ",\"";
+                appendQuoted(chunk, tool, false);
+                chunk += "\"," + String(e.toolConfidence) + "," + String(e.flags & BLOG_DENYLISTED ? 1 : 0) + ",\"";
+                appendQuoted(chunk, ouiVendorName(e.vendor), false);
+                chunk += "\"," + String(e.flags & BLOG_RANDOMIZED ? 1 : 0) + "\n";
+            }
+            first = false;
+            if (chunk.length() > 1024) {
+                server.sendContent(chunk);
+                chunk = "";
+            }
+            return true;
+        });
+        file.close();
+    }
+    if (json) chunk += "]";
+    server.sendContent(chunk);
+    server.sendContent("");
+}
+
+// Unix seconds of a session CSV line's leading timestamp, -1 for the
+// header or anything else that doesn't start with one
+static time_t csvLineTime(const char* line, size_t len) {
+    char stamp[21];
+    if (len < sizeof(stamp) - 1) {
+        return -1;
+    }
+    memcpy(stamp, line, sizeof(stamp) - 1);
+    stamp[sizeof(stamp) - 1] = '\0';
+    struct tm tm = {};
+    if (sscanf(stamp, "%4d-%2d-%2dT%2d:%2d:%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return -1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+void WebPortal::handleLog() {
+    if (!authenticate()) return;
+    
+    resetIdleTimer();
+    
+    // The session CSV as written, plain or compressed. Unlike /events it
+    // keeps working for segments whose binary log was lost, and reads no
+    // more than the blocks a range touches.
+    bool ranged = server.hasArg("from") || server.hasArg("to");
+    time_t from = server.hasArg("from") ? (time_t)server.arg("from").toInt() : 0;
+    time_t to = server.hasArg("to") ? (time_t)server.arg("to").toInt() : (time_t)UINT32_MAX;
+    PsramVector<SegmentInfo, MEM_WEB> segments;
+    if (!selectSegments(segments, ranged ? (int64_t)from * 1000000 : INT64_MIN,
+                        ranged ? (int64_t)to * 1000000 + 999999 : INT64_MAX)) {
+        return;
+    }
+    
+    auto csvPath = [](const SegmentInfo& info, bool& compressed) {
+        String path = "/deauthdetector/logs/" + String(info.name) + ".csv.ddz";
+        compressed = SD.exists(path.c_str());
+        return compressed ? path : "/deauthdetector/logs/" + String(info.name) + ".csv";
+    };
+    if (server.hasArg("session")) {
+        bool compressed;
+        if (!SD.exists(csvPath(segments[0], compressed).c_str())) {
+            server.send(404, "application/json", "{\"error\":\"session not found\"}");
+            return;
+        }
+    }
+    
+    PsramVector<uint8_t, MEM_WEB> payload(DDZ_STORED_MAX);
+    PsramVector<uint8_t, MEM_WEB> text(DDZ_BLOCK_RAW);
+    
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/csv", "");
+    
+    // Whole lines in, matching lines out; the header is sent once, first
+    String chunk = "timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count,tool,tool_confidence,denylisted,vendor,randomized\n";
+    auto emit = [&](const char* p, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            const char* nl = (const char*)memchr(p + done, '\n', len - done);
+            if (!nl) {
+                break;
+            }
+            size_t lineLen = nl - (p + done) + 1;
+            time_t t = csvLineTime(p + done, lineLen);
+            if (t >= 0 && (!ranged || (t >= from && t <= to))) {
+                chunk.concat(p + done, lineLen);
+                if (chunk.length() > 1024) {
+                    server.sendContent(chunk);
+                    chunk = "";
+                }
+            }
+            done += lineLen;
+        }
+        return done;
+    };
+    
+    for (const SegmentInfo& info : segments) {
+        bool compressed;
+        File file = SD.open(csvPath(info, compressed).c_str(), FILE_READ);
+        if (!file) {
+            continue;
+        }
+        if (compressed) {
+            DdzFileSource source = {file};
+            DdzReader<DdzFileSource> reader(source, payload.data(), text.data());
+            if (reader.open()) {
+                reader.scan(ranged ? (uint32_t)from : 0, ranged ? (uint32_t)to : UINT32_MAX,
+                            [&](const char* block, size_t len, const DdzBlock&) {
+                    emit(block, len);
+                    return true;
+                });
+            }
+        } else {
+            // Read in block-sized pieces, carrying a partial last line over
+            char* buf = (char*)text.data();
+            size_t held = 0;
+            for (;;) {
+                int n = file.read((uint8_t*)buf + held, DDZ_BLOCK_RAW - held);
+                if (n <= 0) {
+                    break;
+                }
+                held += n;
+                size_t done = emit(buf, held);
+                if (done == 0 && held == DDZ_BLOCK_RAW) {
+                    done = held;    // a line longer than the buffer is skipped
+                }
+                memmove(buf, buf + done, held - done);
+                held -= done;
+            }
+        }
+        file.close();
+    }
+    server.sendContent(chunk);
+    server.sendContent("");
+}
+
+void WebPortal::handleSegments() {
+    if (!authenticate()) return;
+    
+    resetIdleTimer();
+    
+    logger.syncSession();
+    SessionWriter& session = logger.getSession();
+    PsramVector<SegmentInfo, MEM_WEB> segments(session.segmentCount());
+    segments.resize(session.copySegments(segments.data(), segments.size()));
+    
+    String json = "[";
+    for (size_t i = 0; i < segments.size(); i++) {
+        const SegmentInfo& info = segments[i];
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + String(info.name) + "\"";
+        json += ",\"opened\":" + String(info.opened);
+        json += ",\"closed\":" + String(info.closed);
+        json += ",\"first_event\":" + String(info.firstEvent);
+        json += ",\"last_event\":" + String(info.lastEvent);
+        json += ",\"events\":" + String(info.events);
+        json += ",\"bytes\":" + String(info.bytes) + "}";
+    }
+    json += "]";
+    server.send(200, "application/json", json);
+}
+
 String WebPortal::generateHTML() {
     AppConfig& config = configManager->getConfig();
     
@@ -243,7 +868,7 @@ String WebPortal::generateHTML() {
         .tab-content { display: none; }
         .tab-content.active { display: block; }
         label { display: block; margin: 10px 0 5px; font-weight: bold; }
-        input[type='text'], input[type='password'], input[type='number'] { 
+        input[type='text'], input[type='password'], input[type='number'], select { 
             width: 100%; padding: 8px; border: 1px solid #ccc; border-radius: 4px; box-sizing: border-box;
         }
         input[type='checkbox'] { margin-right: 5px; }
@@ -345,6 +970,15 @@ String WebPortal::generateHTML() {
                 
                 <label>Channel Hop Interval (milliseconds):</label>
                 <input type='number' name='channel_hop_interval' value=')" + String(config.detection.channel_hop_interval_ms) + R"(' min='75'>
+                
+                <label>
+                    <input type='checkbox' name='survey_enabled' value='true' )" + 
+                    String(config.survey.enabled ? "checked" : "") + R"(>
+                    Channel Occupancy Survey
+                </label>
+                
+                <label>Survey Bucket (seconds):</label>
+                <input type='number' name='survey_bucket' value=')" + String(config.survey.bucket_seconds) + R"(' min='1'>
             </div>
             
             <div id='api' class='tab-content'>
@@ -374,7 +1008,7 @@ String WebPortal::generateHTML() {
             </div>
             
             <div id='debug' class='tab-content'>
-                <div class='info'>Configure debug logging to SD card</div>
+                <div class='info'>Configure debug logging, session log rotation and frame capture on the SD card</div>
                 
                 <label>
                     <input type='checkbox' name='debug_enabled' value='true' )" + 
@@ -382,6 +1016,40 @@ String WebPortal::generateHTML() {
                     Enable Debug Logging
                 </label>
                 
+                <label>Binary Trace Output:</label>
+                <select name='debug_trace'>
+                    <option value='off' )" + String(config.debug.trace == "off" ? "selected" : "") + R"(>Off</option>
+                    <option value='serial' )" + String(config.debug.trace == "serial" ? "selected" : "") + R"(>Serial</option>
+                    <option value='sd' )" + String(config.debug.trace == "sd" ? "selected" : "") + R"(>SD card (trace.bin)</option>
+                </select>
+                
+                <label>Session Log Segment Size (KB, 0 = unlimited):</label>
+                <input type='number' name='segment_max_kb' value=')" + String(config.logging.segment_max_kb) + R"(' min='0'>
+                
+                <label>Session Log Segment Length (minutes, 0 = unlimited):</label>
+                <input type='number' name='segment_max_minutes' value=')" + String(config.logging.segment_max_minutes) + R"(' min='0'>
+                
+                <label>Session Log Space Budget (MB, 0 = unlimited):</label>
+                <input type='number' name='log_budget_mb' value=')" + String(config.logging.budget_mb) + R"(' min='0'>
+                
+                <label>
+                    <input type='checkbox' name='log_compress' value='true' )" + 
+                    String(config.logging.compress ? "checked" : "") + R"(>
+                    Compress Session and Debug Logs (.ddz)
+                </label>
+                
+                <label>
+                    <input type='checkbox' name='capture_enabled' value='true' )" + 
+                    String(config.capture.enabled ? "checked" : "") + R"(>
+                    Record Deauth Frames (pcapng)
+                </label>
+                
+                <label>Capture File Size (KB, 0 = unlimited):</label>
+                <input type='number' name='capture_file_max_kb' value=')" + String(config.capture.file_max_kb) + R"(' min='0'>
+                
+                <label>Capture Files Kept (0 = unlimited):</label>
+                <input type='number' name='capture_max_files' value=')" + String(config.capture.max_files) + R"(' min='0'>
+                
                 <p style='margin-top: 20px;'>
                     <a href='/debug/log' target='_blank' style='color: #007bff;'>View Debug Log</a>
                 </p>
@@ -6,12 +6,11 @@ WiFiManager::WiFiManager(WiFiConfig& config) : wifiConfig(config) {}
 
 bool WiFiManager::connectSTA() {
     if (wifiConfig.sta_ssid.isEmpty()) {
-        logger.debugPrintln("WiFi SSID not configured");
+        LOG_WARN("WiFi SSID not configured");
         return false;
     }
     
-    logger.debugPrint("Connecting to WiFi: ");
-    logger.debugPrintln(wifiConfig.sta_ssid);
+    LOG_INFO("Connecting to WiFi: %s", wifiConfig.sta_ssid.c_str());
     
     WiFi.mode(WIFI_STA);
     WiFi.begin(wifiConfig.sta_ssid.c_str(), wifiConfig.sta_password.c_str());
@@ -19,17 +18,14 @@ bool WiFiManager::connectSTA() {
     int timeout = 20; // 20 seconds
     while (WiFi.status() != WL_CONNECTED && timeout > 0) {
         delay(1000);
-        logger.debugPrint(".");
         timeout--;
     }
-    logger.debugPrintln();
     
     if (WiFi.status() == WL_CONNECTED) {
-        logger.debugPrint("Connected! IP: ");
-        logger.debugPrintln(WiFi.localIP().toString());
+        LOG_INFO("Connected! IP: %s", WiFi.localIP().toString().c_str());
         return true;
     } else {
-        logger.debugPrintln("Connection failed");
+        LOG_WARN("Connection failed");
         return false;
     }
 }
@@ -50,13 +46,11 @@ bool WiFiManager::startAP(const char* ssid, const char* password) {
     }
     
     if (success) {
-        logger.debugPrint("AP started: ");
-        logger.debugPrintln(ssid);
-        logger.debugPrint("IP address: ");
-        logger.debugPrintln(WiFi.softAPIP().toString());
+        LOG_INFO("AP started: %s", ssid);
+        LOG_INFO("IP address: %s", WiFi.softAPIP().toString().c_str());
         return true;
     } else {
-        logger.debugPrintln("Failed to start AP");
+        LOG_ERROR("Failed to start AP");
         return false;
     }
 }
@@ -70,8 +64,7 @@ bool WiFiManager::isConnected() {
 }
 
 bool WiFiManager::syncNTP(NTPConfig& ntpConfig) {
-    logger.debugPrint("Syncing time with NTP server: ");
-    logger.debugPrintln(ntpConfig.server);
+    LOG_INFO("Syncing time with NTP server: %s", ntpConfig.server.c_str());
     
     configTime(ntpConfig.timezone_offset * 3600, 
                ntpConfig.daylight_savings ? 3600 : 0, 
@@ -81,18 +74,17 @@ bool WiFiManager::syncNTP(NTPConfig& ntpConfig) {
     int retry = 0;
     const int retry_count = 10;
     while (time(nullptr) < 100000 && ++retry < retry_count) {
-        logger.debugPrint(".");
         delay(1000);
     }
-    logger.debugPrintln();
     
     if (retry < retry_count) {
         time_t now = time(nullptr);
-        logger.debugPrint("Time synchronized: ");
-        logger.debugPrintln(ctime(&now));
+        char stamp[32];
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+        LOG_INFO("Time synchronized: %s", stamp);
         return true;
     } else {
-        logger.debugPrintln("Failed to sync time");
+        LOG_WARN("Failed to sync time");
         return false;
     }
 }
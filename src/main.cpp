@@ -7,6 +7,9 @@
 #include "Logger.h"
 #include "APIReporter.h"
 #include "AlertManager.h"
+#include "LoopStats.h"
+#include "PcapWriter.h"
+#include "LifetimeStats.h"
 
 // Application state
 enum AppState {
@@ -27,9 +30,13 @@ AlertManager* alertManager = nullptr;
 AppState currentState = STATE_INIT;
 unsigned long lastReportTime = 0;
 unsigned long lastDisplayUpdate = 0;
+unsigned long lastTrendSave = 0;
 unsigned long goButtonPressTime = 0;
 bool goButtonPressed = false;
-size_t lastEventCount = 0;
+LoopStats loopStats = {};
+
+#define TRENDS_FILE "/deauthdetector/trends.bin"
+static const unsigned long TREND_SAVE_INTERVAL_MS = 300000;    // 5 minutes
 
 // Define the specific pins used by the M5Cardputer for the SD card
 
@@ -43,6 +50,8 @@ void enterConfigMode();
 void enterMonitorMode();
 void handleConfigMode();
 void handleMonitorMode();
+void reportPendingEvents();
+bool replayJournal();
 void updateDisplay();
 
 void setup() {
@@ -78,6 +87,9 @@ void setup() {
         }
     }
     
+    // Lifetime counters live in NVS, not on the card; count this boot
+    lifetimeStats.begin();
+    
     // Load configuration
     if (!configManager.loadConfig()) {
         Serial.println("Configuration not found or invalid");
@@ -99,7 +111,7 @@ void setup() {
     logger.setConfig(&config);
     // Initialize logger
     if (!logger.begin()) {
-        logger.debugPrintln("Warning: Logger initialization failed");
+        LOG_WARN("Logger initialization failed");
     }
     
     // Initialize managers
@@ -122,6 +134,12 @@ void setup() {
         alertManager->setStatusSyncing();
         wifiManager->syncNTP(config.ntp);
         
+        // Deliver what an earlier boot journaled but never got acknowledged
+        if (logger.journalBacklog() > 0 && apiReporter) {
+            M5Cardputer.Display.println("Reporting journaled events...");
+            replayJournal();
+        }
+        
         // Turn off LED after successful time sync
         alertManager->setStatusReady();
         
@@ -129,7 +147,7 @@ void setup() {
         wifiManager->disconnect();
         M5Cardputer.Display.println("Disconnected");
     } else {
-        logger.debugPrintln("Warning: Could not connect to WiFi for time sync");
+        LOG_WARN("Could not connect to WiFi for time sync");
         alertManager->setStatusReady();
     }
 
@@ -141,6 +159,25 @@ void setup() {
     
 
     detector.begin(config.detection.protected_ssids, config.detection);
+    lifetimeStats.setProtected(config.detection.protected_ssids);
+    detector.enableSurvey(config.survey);
+    detector.loadSignatures("/deauthdetector/signatures.json");
+    detector.loadMacLists("/deauthdetector/allowlist.txt", "/deauthdetector/denylist.txt");
+    if (detector.loadTrends(TRENDS_FILE)) {
+        LOG_INFO("Restored trend history");
+    }
+    // Whole file now if needed, so monitoring only ever patches it
+    detector.saveTrends(TRENDS_FILE);
+    if (config.capture.enabled) {
+        PcapLimits limits;
+        limits.fileMaxBytes = (uint32_t)config.capture.file_max_kb * 1024;
+        limits.maxFiles = (uint32_t)config.capture.max_files;
+        if (pcapWriter.begin("/deauthdetector/captures", limits)) {
+            LOG_INFO("Recording deauth frames to /deauthdetector/captures");
+        } else {
+            LOG_WARN("Frame capture could not start");
+        }
+    }
     alertManager->setStatusReady();
     
     // Enter monitor mode
@@ -149,6 +186,7 @@ void setup() {
 
 void loop() {
     M5Cardputer.update();
+    lifetimeStats.tick(detector);
     
     switch (currentState) {
         case STATE_CONFIG_MODE:
@@ -165,17 +203,20 @@ void loop() {
 }
 
 void enterConfigMode() {
-    logger.debugPrintln("Entering Config Mode");
+    LOG_INFO("Entering Config Mode");
     currentState = STATE_CONFIG_MODE;
     
     // Stop monitoring if active
     detector.stopMonitoring();
+    detector.saveTrends(TRENDS_FILE);
+    logger.syncSession();
+    lifetimeStats.commit();
     
     // Start AP mode
     wifiManager->startAP("M5-DeauthDetector");
     
     // Start web portal
-    webPortal = new WebPortal(&configManager);
+    webPortal = new WebPortal(&configManager, &detector);
     webPortal->begin(true);
     
     // Update display
@@ -183,7 +224,7 @@ void enterConfigMode() {
 }
 
 void enterMonitorMode() {
-    logger.debugPrintln("Entering Monitor Mode");
+    LOG_INFO("Entering Monitor Mode");
     currentState = STATE_MONITOR_MODE;
     
     // Stop web portal if active
@@ -214,7 +255,7 @@ void enterMonitorMode() {
             Keyboard_Class::KeysState status = M5Cardputer.Keyboard.keysState();
             if (status.enter) {
                 enterPressed = true;
-                logger.debugPrintln("Enter pressed - skipping monitoring display");
+                LOG_DEBUG("Enter pressed - skipping monitoring display");
             }
         }
         
@@ -232,7 +273,7 @@ void handleConfigMode() {
         
         // Check for timeout
         if (webPortal->hasTimedOut()) {
-            logger.debugPrintln("Config mode timeout - returning to monitor mode");
+            LOG_INFO("Config mode timeout - returning to monitor mode");
             enterMonitorMode();
         }
     }
@@ -248,6 +289,8 @@ void handleConfigMode() {
 
 void handleMonitorMode() {
     AppConfig& config = configManager.getConfig();
+    unsigned long passStart = micros();
+    bool timedPass = true;
     
     // Update channel hopping
     detector.updateChannelHop();
@@ -257,45 +300,79 @@ void handleMonitorMode() {
         alertManager->update();
     }
     
-    // Check for new deauth events
-    std::vector<DeauthEvent> events = detector.getEvents();
+    // Trigger alert whenever new events arrived since last check; escalate
+    // if any came from a denylisted sender
+    static DeauthEvent alertBatch[16];
+    size_t alertCount = 0;
+    bool newEvents = false;
+    bool escalate = false;
+    while ((alertCount = detector.readEvents(CONSUMER_ALERTS, alertBatch, 16)) > 0) {
+        newEvents = true;
+        for (size_t i = 0; i < alertCount && !escalate; i++) {
+            escalate = alertBatch[i].denylisted;
+        }
+    }
+    if (newEvents) {
+        detector.ackEvents(CONSUMER_ALERTS);
+        if (alertManager) {
+            alertManager->triggerAlert(escalate);
+        }
+    }
     
-    if (!events.empty()) {
-        // Trigger alert whenever new events arrived since last check
-        if (alertManager && events.size() > lastEventCount) {
-            alertManager->triggerAlert();
+    // Hand the session writer only what its queue has room for, a batch per
+    // pass; anything else stays unread in the event ring until it catches up
+    static DeauthEvent batch[16];
+    unsigned long logStart = micros();
+    uint64_t waiting = detector.pendingEvents(CONSUMER_LOGGER);
+    if (waiting > 0) {
+        uint64_t lost = 0;
+        size_t room = logger.admitEvents(waiting < 16 ? (size_t)waiting : 16);
+        size_t count = room > 0 ? detector.readEvents(CONSUMER_LOGGER, batch, room, &lost) : 0;
+        if (lost > 0) {
+            LOG_WARN("Event ring overran logging, %lu events lost", (unsigned long)lost);
+            lifetimeStats.recordDropped(lost);
         }
-        lastEventCount = events.size();
-        
-        // Log events
-        for (const DeauthEvent& event : events) {
-            logger.logEvent(event);
+        for (size_t i = 0; i < count; i++) {
+            logger.logEvent(batch[i]);
+            lifetimeStats.recordEvent(batch[i]);
+        }
+        if (count > 0) {
+            detector.ackEvents(CONSUMER_LOGGER);
         }
     }
+    uint32_t logUs = micros() - logStart;
+    if (logUs > loopStats.logMaxUs) {
+        loopStats.logMaxUs = logUs;
+    }
     
     // Handle reporting interval
     unsigned long currentTime = millis();
     if (currentTime - lastReportTime >= (config.detection.reporting_interval_seconds * 1000)) {
-        if (detector.hasEvents()) {
-            std::vector<DeauthEvent> reportEvents = detector.getEvents();
-            
+        if (config.api.endpoint_url.isEmpty()) {
+            // Nowhere to report to: close the window without leaving monitor mode
+            if (detector.pendingEvents(CONSUMER_REPORTER) > 0) {
+                detector.readEvents(CONSUMER_REPORTER, nullptr, SIZE_MAX);
+                detector.ackEvents(CONSUMER_REPORTER);
+                detector.clearEvents();
+            }
+        } else if (detector.pendingEvents(CONSUMER_REPORTER) > 0 || logger.journalBacklog() > 0) {
             // Stop monitoring temporarily
             detector.stopMonitoring();
+            timedPass = false;
             
             // Connect to WiFi
             if (wifiManager->connectSTA()) {
                 // Send to API
                 if (apiReporter) {
-                    apiReporter->sendBatch(reportEvents);
+                    reportPendingEvents();
                 }
                 
                 // Disconnect
                 wifiManager->disconnect();
             }
             
-            // Clear events after reporting
+            // Start a new reporting window; unsent events stay queued
             detector.clearEvents();
-            lastEventCount = 0;
             
             // Resume monitoring
             detector.startMonitoring();
@@ -304,6 +381,13 @@ void handleMonitorMode() {
         lastReportTime = currentTime;
     }
     
+    // Persist trend history: only the buckets that changed, a few hundred
+    // bytes instead of the whole file, since frames wait while this runs
+    if (currentTime - lastTrendSave >= TREND_SAVE_INTERVAL_MS) {
+        detector.saveTrendChanges(TRENDS_FILE);
+        lastTrendSave = currentTime;
+    }
+    
     // Update display periodically
     if (currentTime - lastDisplayUpdate >= 1000) {
         updateDisplay();
@@ -350,16 +434,73 @@ void handleMonitorMode() {
             if (millis() - goButtonPressTime >= 2000) {
                 enterConfigMode();
                 goButtonPressed = false;
+                timedPass = false;
             }
         }
     } else {
         goButtonPressed = false;
     }
+    
+    if (timedPass) {
+        loopStats.record(micros() - passStart);
+    }
+}
+
+static DeauthEvent reportBatch[API_BATCH_MAX];
+
+// Sends the journal's backlog from earlier boots, oldest first; false if
+// the API couldn't be reached, leaving the rest for the next interval
+bool replayJournal() {
+    DeauthEvent* batch = reportBatch;
+    size_t count;
+    while ((count = logger.copyJournalBacklog(batch, API_BATCH_MAX)) > 0) {
+        ReportResult result = apiReporter->sendBatch(batch, count);
+        lifetimeStats.recordReport(result, count);
+        if (result == REPORT_RETRY) {
+            return false;
+        }
+        if (result == REPORT_REJECTED) {
+            LOG_WARN("API rejected journaled batch, discarding %u events", (unsigned)count);
+        }
+        logger.consumeJournalBacklog(count);
+    }
+    return true;
+}
+
+// Sends everything the reporter hasn't had acknowledged, in API-sized
+// batches, after the journal's backlog. A batch that failed in transit is
+// rewound and retried at the next interval; one the server rejected is
+// dropped. Either way the journal learns the batch is done with.
+void reportPendingEvents() {
+    if (!replayJournal()) {
+        return;
+    }
+    DeauthEvent* batch = reportBatch;
+    for (;;) {
+        uint64_t lost = 0;
+        size_t count = detector.readEvents(CONSUMER_REPORTER, batch, API_BATCH_MAX, &lost);
+        if (lost > 0) {
+            LOG_WARN("%lu events were overwritten before they could be reported", (unsigned long)lost);
+        }
+        if (count == 0) {
+            break;
+        }
+        ReportResult result = apiReporter->sendBatch(batch, count);
+        lifetimeStats.recordReport(result, count);
+        if (result == REPORT_RETRY) {
+            detector.rewindEvents(CONSUMER_REPORTER);
+            break;
+        }
+        if (result == REPORT_REJECTED) {
+            LOG_WARN("API rejected batch, discarding %u events", (unsigned)count);
+        }
+        detector.ackEvents(CONSUMER_REPORTER);
+        logger.journalAck(batch[count - 1].seq);
+    }
 }
 
 void updateDisplay() {
     AppConfig& config = configManager.getConfig();
-    std::vector<DeauthEvent> events = detector.getEvents();
     
     switch (display.getCurrentView()) {
         case VIEW_DASHBOARD:
@@ -367,11 +508,23 @@ void updateDisplay() {
             break;
             
         case VIEW_LIVE_LOG:
-            display.showLiveLog(events);
+        {
+            DeauthEvent recent[5];
+            size_t count = detector.getRecentEvents(recent, 5);
+            display.showLiveLog(recent, count);
             break;
+        }
             
         case VIEW_DETAILED:
             display.showDetailed(config.detection.protected_ssids, detector);
             break;
+            
+        case VIEW_SURVEY:
+            display.showSurvey(detector);
+            break;
+            
+        case VIEW_TRENDS:
+            display.showTrends(detector);
+            break;
     }
 }
@@ -0,0 +1,1069 @@
+// Session log analyzer.
+//
+// Reads session CSVs from any number of sensors (deauthdetect_session_*.csv,
+// or *.csv.ddz when logging.compress is on) and prints incident summaries,
+// per-SSID, per-attacker, per-channel and per-tool statistics and a time
+// histogram.
+//
+//   ddanalyze /media/sd*/deauthdetector/logs/deauthdetect_session_*
+//   ddanalyze --top 20 --bucket 600 --gap 120 sensor1/*.csv sensor2/*.csv
+//   ddanalyze --from 1769782800 --to 1769869200 logs/*.csv
+//
+// Files are memory-mapped and cut into chunks at line ends; a pool of
+// threads (--threads, default one per core) parses the chunks in place.
+// The parser works on pointers into the mapping and allocates nothing per
+// line; names are copied once, the first time each is seen. Compressed
+// logs are split into runs of blocks and expanded into a per-thread buffer.
+//
+// An incident is a run of events against one BSSID with no gap longer
+// than --gap seconds, resolved to the minute. Times are printed as written
+// by the sensor, which is its local time.
+//
+// packet_count is the BSSID's running frame count within the sensor's
+// reporting window (1, 2, ... up to packet_threshold), so an event stands
+// for its rise over the previous event for that BSSID, or for its whole
+// count where a new window began. Frames are those rises summed; frames
+// past the threshold leave no event and aren't counted. Each directory is
+// taken as one sensor, its files in name order, so a window that spans
+// two segments is joined up across the chunks and files it was cut into.
+//
+// Synthetic logs in the firmware's format, for benchmarking:
+//
+//   ddanalyze --generate /tmp/ddlogs --size 4096 --files 16
+//   ddanalyze --threads 1 /tmp/ddlogs/*.csv
+//   ddanalyze /tmp/ddlogs/*.csv
+
+#include "CompressedLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char CSV_HEADER[] =
+    "timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count,tool,tool_confidence,"
+    "denylisted,vendor,randomized";
+
+struct Options {
+    size_t   top = 10;
+    int64_t  bucket = 3600;
+    int64_t  gap = 300;
+    int64_t  from = INT64_MIN;
+    int64_t  to = INT64_MAX;
+    unsigned threads = 0;
+    size_t   chunkMb = 32;
+    // --generate
+    std::string generate;
+    size_t   sizeMb = 1024;
+    size_t   files = 8;
+    uint32_t seed = 1;
+};
+
+// ---- Parsing ---------------------------------------------------------------
+
+// A field as a view into the line
+struct Field {
+    const char* p;
+    size_t n;
+};
+
+struct Row {
+    int64_t  time;
+    Field    ssid;
+    uint64_t bssid;
+    uint64_t attacker;
+    int      channel;
+    int      rssi;
+    int      packets;
+    Field    tool;
+    int      confidence;
+    bool     denylisted;
+    Field    vendor;
+    bool     randomized;
+};
+
+inline bool digits(const char* p, size_t n, int& out) {
+    int v = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned d = (unsigned)(p[i] - '0');
+        if (d > 9) return false;
+        v = v * 10 + (int)d;
+    }
+    out = v;
+    return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+inline int64_t daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// "YYYY-MM-DDTHH:MM:SSZ", as SessionWriter writes it
+inline bool parseTime(const char* p, const char* end, int64_t& t) {
+    if (end - p < 20 || p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':' ||
+        p[19] != 'Z') {
+        return false;
+    }
+    int y, mo, d, h, mi, s;
+    if (!digits(p, 4, y) || !digits(p + 5, 2, mo) || !digits(p + 8, 2, d) || !digits(p + 11, 2, h) ||
+        !digits(p + 14, 2, mi) || !digits(p + 17, 2, s) || mo < 1 || mo > 12) {
+        return false;
+    }
+    t = daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+    return true;
+}
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// "AA:BB:CC:DD:EE:FF" as 48 bits
+inline bool parseMac(const char* p, uint64_t& mac) {
+    uint64_t v = 0;
+    for (int i = 0; i < 6; i++) {
+        int hi = hexValue(p[i * 3]);
+        int lo = hexValue(p[i * 3 + 1]);
+        if (hi < 0 || lo < 0 || (i < 5 && p[i * 3 + 2] != ':')) return false;
+        v = v << 8 | (uint64_t)(hi << 4 | lo);
+    }
+    mac = v;
+    return true;
+}
+
+inline bool parseInt(const char*& p, const char* end, int& out) {
+    bool neg = p < end && *p == '-';
+    if (neg) p++;
+    const char* start = p;
+    int v = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) {
+        v = v * 10 + (*p++ - '0');
+    }
+    if (p == start) return false;
+    out = neg ? -v : v;
+    return true;
+}
+
+inline bool expect(const char*& p, const char* end, char c) {
+    if (p >= end || *p != c) return false;
+    p++;
+    return true;
+}
+
+// A quoted field that holds no quotes (tool and vendor names)
+inline bool parseQuoted(const char*& p, const char* end, Field& f) {
+    if (!expect(p, end, '"')) return false;
+    const char* q = (const char*)memchr(p, '"', end - p);
+    if (!q) return false;
+    f = {p, (size_t)(q - p)};
+    p = q + 1;
+    return true;
+}
+
+// One line without its line ending. The SSID is written unescaped and may
+// hold quotes and commas, so it ends at the first "," that is followed by
+// a well-formed quoted BSSID.
+bool parseRow(const char* p, const char* end, Row& r) {
+    if (!parseTime(p, end, r.time)) return false;
+    p += 20;
+    if (!expect(p, end, ',') || !expect(p, end, '"')) return false;
+    const char* ssid = p;
+    for (;;) {
+        const char* q = (const char*)memchr(p, '"', end - p);
+        if (!q || end - q < 22) return false;
+        if (q[1] == ',' && q[2] == '"' && q[20] == '"' && parseMac(q + 3, r.bssid)) {
+            r.ssid = {ssid, (size_t)(q - ssid)};
+            p = q + 21;
+            break;
+        }
+        p = q + 1;
+    }
+    int denylisted, randomized;
+    if (!expect(p, end, ',') || end - p < 19 || p[0] != '"' || p[18] != '"' || !parseMac(p + 1, r.attacker)) {
+        return false;
+    }
+    p += 19;
+    if (!expect(p, end, ',') || !parseInt(p, end, r.channel) ||
+        !expect(p, end, ',') || !parseInt(p, end, r.rssi) ||
+        !expect(p, end, ',') || !parseInt(p, end, r.packets) ||
+        !expect(p, end, ',') || !parseQuoted(p, end, r.tool) ||
+        !expect(p, end, ',') || !parseInt(p, end, r.confidence) ||
+        !expect(p, end, ',') || !parseInt(p, end, denylisted) ||
+        !expect(p, end, ',') || !parseQuoted(p, end, r.vendor) ||
+        !expect(p, end, ',') || !parseInt(p, end, randomized)) {
+        return false;
+    }
+    r.denylisted = denylisted != 0;
+    r.randomized = randomized != 0;
+    return p == end;
+}
+
+inline uint64_t hashBytes(const char* p, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ (uint8_t)p[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+// ---- Aggregation -----------------------------------------------------------
+
+struct Span {
+    uint64_t events = 0;
+    uint64_t frames = 0;
+    int64_t  first = INT64_MAX;
+    int64_t  last = INT64_MIN;
+
+    void add(int64_t t, uint64_t frames_) {
+        events++;
+        frames += frames_;
+        first = std::min(first, t);
+        last = std::max(last, t);
+    }
+    void merge(const Span& o) {
+        events += o.events;
+        frames += o.frames;
+        first = std::min(first, o.first);
+        last = std::max(last, o.last);
+    }
+};
+
+struct NamedSpan : Span {
+    std::string name;
+};
+
+struct SsidStats : NamedSpan {
+    std::unordered_set<uint64_t> bssids;
+    std::unordered_set<uint64_t> attackers;
+    int bestRssi = -128;
+};
+
+// One tool or vendor name seen for an attacker. The one reported wins on
+// confidence, then events, then name, so the pick doesn't depend on the
+// order chunks were parsed and merged in.
+struct Vote {
+    std::string name;
+    uint64_t events = 0;
+    int      confidence = 0;
+
+    bool beats(const Vote& o) const {
+        if (confidence != o.confidence) return confidence > o.confidence;
+        if (events != o.events) return events > o.events;
+        return name < o.name;
+    }
+};
+
+typedef std::unordered_map<uint64_t, Vote> Votes;        // by name hash
+
+inline void vote(Votes& votes, Field name, int confidence) {
+    Vote& v = votes[hashBytes(name.p, name.n)];
+    if (v.events == 0) v.name.assign(name.p, name.n);
+    v.events++;
+    v.confidence = std::max(v.confidence, confidence);
+}
+
+inline void mergeVotes(Votes& votes, Votes& o) {
+    for (auto& kv : o) {
+        Vote& v = votes[kv.first];
+        if (v.events == 0) v.name = std::move(kv.second.name);
+        v.events += kv.second.events;
+        v.confidence = std::max(v.confidence, kv.second.confidence);
+    }
+}
+
+inline std::string winner(const Votes& votes) {
+    const Vote* best = nullptr;
+    for (const auto& kv : votes) {
+        if (!best || kv.second.beats(*best)) best = &kv.second;
+    }
+    return best ? best->name : "";
+}
+
+struct AttackerStats : Span {
+    uint64_t channels = 0;      // bit per channel 0-63
+    int      bestRssi = -128;
+    Votes    tools;
+    Votes    vendors;
+    bool     randomized = false;
+    bool     denylisted = false;
+};
+
+struct Cell {
+    uint64_t events = 0;
+    uint64_t frames = 0;
+};
+
+struct CellKey {
+    uint64_t bssid;
+    int64_t  minute;
+    bool operator==(const CellKey& o) const { return bssid == o.bssid && minute == o.minute; }
+};
+
+struct CellHash {
+    size_t operator()(const CellKey& k) const {
+        return (size_t)(k.bssid * 0x9E3779B97F4A7C15ull ^ (uint64_t)k.minute * 0xC2B2AE3D27D4EB4Full);
+    }
+};
+
+// A BSSID's packet_count within one chunk: the first and last count seen,
+// and where the first event's frames were booked. The first event is
+// booked as if it began a window; joinRuns() takes back the overlap once
+// the chunk before it is known.
+struct Run {
+    int      first;
+    int      last;
+    int64_t  time;
+    uint64_t ssid;              // name hash
+    uint64_t attacker;
+    uint64_t tool;              // name hash
+    int      channel;
+};
+
+typedef std::unordered_map<uint64_t, Run> Runs;         // by BSSID
+
+struct Agg {
+    uint64_t text = 0;          // CSV bytes parsed, after expanding
+    uint64_t lines = 0;
+    uint64_t malformed = 0;
+    uint64_t filtered = 0;
+    uint64_t damagedBlocks = 0;
+    Span     total;
+    std::unordered_map<uint64_t, SsidStats> ssids;          // by name hash
+    std::unordered_map<uint64_t, AttackerStats> attackers;  // by MAC
+    std::unordered_map<uint64_t, uint64_t> targetSsid;      // BSSID -> name hash
+    std::unordered_map<uint64_t, NamedSpan> tools;          // by name hash
+    Span     channels[256];
+    std::unordered_map<int64_t, uint64_t> histogram;        // bucket -> events
+    std::unordered_map<CellKey, Cell, CellHash> cells;      // BSSID and minute
+
+    void add(const Row& r, const Options& opt, Runs& runs) {
+        uint64_t sh = hashBytes(r.ssid.p, r.ssid.n);
+        Field tool = r.tool.n > 0 ? r.tool : Field{"(unknown)", 9};
+        uint64_t th = hashBytes(tool.p, tool.n);
+
+        int count = std::max(r.packets, 0);
+        uint64_t frames;
+        auto run = runs.find(r.bssid);
+        if (run == runs.end()) {
+            runs.emplace(r.bssid, Run{count, count, r.time, sh, r.attacker, th, r.channel});
+            frames = (uint64_t)count;
+        } else {
+            frames = (uint64_t)(count > run->second.last ? count - run->second.last : count);
+            run->second.last = count;
+        }
+
+        total.add(r.time, frames);
+
+        SsidStats& s = ssids[sh];
+        if (s.events == 0) s.name.assign(r.ssid.p, r.ssid.n);
+        s.add(r.time, frames);
+        s.bssids.insert(r.bssid);
+        s.attackers.insert(r.attacker);
+        s.bestRssi = std::max(s.bestRssi, r.rssi);
+        // A renamed network keeps one name, the same one on every run
+        auto target = targetSsid.emplace(r.bssid, sh);
+        if (!target.second) target.first->second = std::min(target.first->second, sh);
+
+        AttackerStats& a = attackers[r.attacker];
+        a.add(r.time, frames);
+        if (r.channel >= 0 && r.channel < 64) a.channels |= 1ull << r.channel;
+        a.bestRssi = std::max(a.bestRssi, r.rssi);
+        if (r.tool.n > 0) vote(a.tools, r.tool, r.confidence);
+        if (r.vendor.n > 0) vote(a.vendors, r.vendor, 0);
+        a.randomized |= r.randomized;
+        a.denylisted |= r.denylisted;
+
+        NamedSpan& t = tools[th];
+        if (t.events == 0) t.name.assign(tool.p, tool.n);
+        t.add(r.time, frames);
+
+        channels[r.channel & 0xFF].add(r.time, frames);
+        histogram[floorDiv(r.time, opt.bucket)]++;
+        Cell& c = cells[CellKey{r.bssid, floorDiv(r.time, 60)}];
+        c.events++;
+        c.frames += frames;
+    }
+
+    // The first event of a run continued the previous chunk's window,
+    // whose count had reached `overlap`: those frames were booked already
+    void unbook(uint64_t bssid, const Run& run, uint64_t overlap) {
+        total.frames -= overlap;
+        ssids[run.ssid].frames -= overlap;
+        attackers[run.attacker].frames -= overlap;
+        tools[run.tool].frames -= overlap;
+        channels[run.channel & 0xFF].frames -= overlap;
+        cells[CellKey{bssid, floorDiv(run.time, 60)}].frames -= overlap;
+    }
+
+    void merge(Agg& o) {
+        text += o.text;
+        lines += o.lines;
+        malformed += o.malformed;
+        filtered += o.filtered;
+        damagedBlocks += o.damagedBlocks;
+        total.merge(o.total);
+        for (auto& kv : o.ssids) {
+            SsidStats& s = ssids[kv.first];
+            if (s.events == 0) s.name = std::move(kv.second.name);
+            s.merge(kv.second);
+            s.bssids.insert(kv.second.bssids.begin(), kv.second.bssids.end());
+            s.attackers.insert(kv.second.attackers.begin(), kv.second.attackers.end());
+            s.bestRssi = std::max(s.bestRssi, kv.second.bestRssi);
+        }
+        for (auto& kv : o.attackers) {
+            AttackerStats& a = attackers[kv.first];
+            const AttackerStats& b = kv.second;
+            a.merge(b);
+            a.channels |= b.channels;
+            a.bestRssi = std::max(a.bestRssi, b.bestRssi);
+            mergeVotes(a.tools, kv.second.tools);
+            mergeVotes(a.vendors, kv.second.vendors);
+            a.randomized |= b.randomized;
+            a.denylisted |= b.denylisted;
+        }
+        for (auto& kv : o.targetSsid) {
+            auto target = targetSsid.emplace(kv.first, kv.second);
+            if (!target.second) target.first->second = std::min(target.first->second, kv.second);
+        }
+        for (auto& kv : o.tools) {
+            NamedSpan& t = tools[kv.first];
+            if (t.events == 0) t.name = std::move(kv.second.name);
+            t.merge(kv.second);
+        }
+        for (size_t i = 0; i < 256; i++) channels[i].merge(o.channels[i]);
+        for (auto& kv : o.histogram) histogram[kv.first] += kv.second;
+        for (auto& kv : o.cells) {
+            Cell& c = cells[kv.first];
+            c.events += kv.second.events;
+            c.frames += kv.second.frames;
+        }
+    }
+
+    static int64_t floorDiv(int64_t a, int64_t b) {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    }
+};
+
+// Whole lines in [p, end)
+void parseLines(const char* p, const char* end, Agg& agg, const Options& opt, Runs& runs) {
+    agg.text += (uint64_t)(end - p);
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = nl ? nl : end;
+        const char* e = lineEnd;
+        if (e > p && e[-1] == '\r') e--;
+        if (e > p) {
+            Row r;
+            if (parseRow(p, e, r)) {
+                agg.lines++;
+                if (r.time < opt.from || r.time > opt.to) {
+                    agg.filtered++;
+                } else {
+                    agg.add(r, opt, runs);
+                }
+            } else if ((size_t)(e - p) != sizeof(CSV_HEADER) - 1 || memcmp(p, CSV_HEADER, e - p) != 0) {
+                agg.lines++;
+                agg.malformed++;
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+// ---- Input -----------------------------------------------------------------
+
+struct Mapped {
+    std::string path;
+    const char* data = nullptr;
+    size_t size = 0;
+    bool compressed = false;
+    size_t sensor = 0;          // directory
+    size_t order = 0;           // by directory, then name
+};
+
+// A piece of work: a byte range of a plain file, or a run of blocks of a
+// compressed one (begin is the first block header, end one past the last)
+struct Chunk {
+    const Mapped* file;
+    size_t begin;
+    size_t end;
+    size_t seq;                 // position in the file
+};
+
+bool mapFile(const char* path, Mapped& m) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "%s: not a file\n", path);
+        close(fd);
+        return false;
+    }
+    m.path = path;
+    m.size = (size_t)st.st_size;
+    if (m.size > 0) {
+        void* p = mmap(nullptr, m.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            fprintf(stderr, "%s: cannot map\n", path);
+            close(fd);
+            return false;
+        }
+        madvise(p, m.size, MADV_SEQUENTIAL);
+        m.data = (const char*)p;
+    }
+    close(fd);
+    m.compressed = m.size >= sizeof(DdzHeader) && memcmp(m.data, DDZ_MAGIC, sizeof(DDZ_MAGIC)) == 0;
+    return true;
+}
+
+// Plain files are cut into chunkBytes pieces at line ends; compressed ones
+// into runs of blocks holding about as much text
+void splitFile(const Mapped& m, size_t chunkBytes, std::vector<Chunk>& chunks) {
+    size_t seq = 0;
+    if (!m.compressed) {
+        size_t begin = 0;
+        while (begin < m.size) {
+            size_t end = std::min(m.size, begin + chunkBytes);
+            const char* nl = end < m.size ? (const char*)memchr(m.data + end, '\n', m.size - end) : nullptr;
+            end = nl ? (size_t)(nl - m.data) + 1 : m.size;
+            chunks.push_back({&m, begin, end, seq++});
+            begin = end;
+        }
+        return;
+    }
+
+    size_t offset = sizeof(DdzHeader);
+    size_t begin = offset;
+    size_t text = 0;
+    for (;;) {
+        DdzBlock b;
+        if (m.size - offset < sizeof(b)) break;
+        memcpy(&b, m.data + offset, sizeof(b));
+        if (b.magic != DDZ_BLOCK_MAGIC || b.rawLen > DDZ_BLOCK_RAW || b.storedLen > DDZ_STORED_MAX ||
+            b.storedLen > m.size - offset - sizeof(b)) {
+            break;
+        }
+        offset += sizeof(b) + b.storedLen;
+        text += b.rawLen;
+        if (text >= chunkBytes) {
+            chunks.push_back({&m, begin, offset, seq++});
+            begin = offset;
+            text = 0;
+        }
+    }
+    if (offset > begin) {
+        chunks.push_back({&m, begin, offset, seq});
+    }
+}
+
+void parseChunk(const Chunk& c, Agg& agg, const Options& opt, uint8_t* text, Runs& runs) {
+    const Mapped& m = *c.file;
+    if (!m.compressed) {
+        parseLines(m.data + c.begin, m.data + c.end, agg, opt, runs);
+        return;
+    }
+    for (size_t offset = c.begin; offset < c.end;) {
+        DdzBlock b;
+        memcpy(&b, m.data + offset, sizeof(b));
+        const uint8_t* payload = (const uint8_t*)m.data + offset + sizeof(b);
+        offset += sizeof(b) + b.storedLen;
+        if (ddzBlockCrc(b, payload) != b.crc) {
+            agg.damagedBlocks++;
+            continue;
+        }
+        if (b.flags & DDZ_STORED) {
+            if (b.storedLen != b.rawLen) {
+                agg.damagedBlocks++;
+                continue;
+            }
+            parseLines((const char*)payload, (const char*)payload + b.rawLen, agg, opt, runs);
+        } else if (lzDecompress(payload, b.storedLen, text, DDZ_BLOCK_RAW) == b.rawLen) {
+            parseLines((const char*)text, (const char*)text + b.rawLen, agg, opt, runs);
+        } else {
+            agg.damagedBlocks++;
+        }
+    }
+}
+
+// Walks each sensor's chunks in log order. Where a chunk's first event for
+// a BSSID continues the window of the chunk before, the frames that window
+// had counted by then were booked twice; take them back.
+void joinRuns(const std::vector<Chunk>& chunks, const std::vector<Runs>& runs, Agg& agg) {
+    std::vector<size_t> order(chunks.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const Chunk& x = chunks[a];
+        const Chunk& y = chunks[b];
+        return x.file->order != y.file->order ? x.file->order < y.file->order : x.seq < y.seq;
+    });
+    std::unordered_map<uint64_t, int> last;     // BSSID -> count so far
+    size_t sensor = SIZE_MAX;
+    for (size_t i : order) {
+        if (chunks[i].file->sensor != sensor) {
+            sensor = chunks[i].file->sensor;
+            last.clear();
+        }
+        for (const auto& kv : runs[i]) {
+            auto prev = last.find(kv.first);
+            if (prev != last.end() && kv.second.first > prev->second) {
+                agg.unbook(kv.first, kv.second, (uint64_t)prev->second);
+            }
+            last[kv.first] = kv.second.last;
+        }
+    }
+}
+
+// ---- Report ----------------------------------------------------------------
+
+std::string formatTime(int64_t t) {
+    if (t == INT64_MAX || t == INT64_MIN) return "-";
+    time_t seconds = (time_t)t;
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+std::string formatDuration(int64_t s) {
+    char buf[32];
+    if (s < 3600) {
+        snprintf(buf, sizeof(buf), "%" PRId64 "m%02" PRId64 "s", s / 60, s % 60);
+    } else {
+        snprintf(buf, sizeof(buf), "%" PRId64 "h%02" PRId64 "m", s / 3600, s % 3600 / 60);
+    }
+    return buf;
+}
+
+std::string formatMac(uint64_t mac) {
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", (unsigned)(mac >> 40 & 0xFF),
+             (unsigned)(mac >> 32 & 0xFF), (unsigned)(mac >> 24 & 0xFF), (unsigned)(mac >> 16 & 0xFF),
+             (unsigned)(mac >> 8 & 0xFF), (unsigned)(mac & 0xFF));
+    return buf;
+}
+
+std::string formatChannels(uint64_t bits) {
+    std::string out;
+    for (int ch = 0; ch < 64; ch++) {
+        if (bits >> ch & 1) {
+            if (!out.empty()) out += ',';
+            out += std::to_string(ch);
+        }
+    }
+    return out.empty() ? "-" : out;
+}
+
+std::string clip(const std::string& s, size_t n) {
+    return s.size() <= n ? s : s.substr(0, n - 1) + "~";
+}
+
+struct Incident {
+    uint64_t bssid;
+    int64_t  start;         // minute
+    int64_t  end;           // minute, inclusive
+    uint64_t events;
+    uint64_t frames;
+    uint64_t peakFrames;    // busiest minute
+};
+
+std::vector<Incident> findIncidents(const Agg& agg, int64_t gap) {
+    std::vector<std::pair<CellKey, Cell>> cells(agg.cells.begin(), agg.cells.end());
+    std::sort(cells.begin(), cells.end(), [](const std::pair<CellKey, Cell>& a, const std::pair<CellKey, Cell>& b) {
+        return a.first.bssid != b.first.bssid ? a.first.bssid < b.first.bssid : a.first.minute < b.first.minute;
+    });
+    int64_t gapMinutes = std::max<int64_t>(1, (gap + 59) / 60);
+    std::vector<Incident> out;
+    for (const auto& kv : cells) {
+        const CellKey& k = kv.first;
+        if (out.empty() || out.back().bssid != k.bssid || k.minute - out.back().end > gapMinutes) {
+            out.push_back({k.bssid, k.minute, k.minute, 0, 0, 0});
+        }
+        Incident& in = out.back();
+        in.end = k.minute;
+        in.events += kv.second.events;
+        in.frames += kv.second.frames;
+        in.peakFrames = std::max(in.peakFrames, kv.second.frames);
+    }
+    return out;
+}
+
+template <typename T, typename Less>
+std::vector<const T*> topN(const std::vector<const T*>& items, size_t n, Less less) {
+    std::vector<const T*> out(items);
+    size_t k = std::min(n, out.size());
+    std::partial_sort(out.begin(), out.begin() + k, out.end(), less);
+    out.resize(k);
+    return out;
+}
+
+void report(const Agg& agg, const Options& opt, size_t files, uint64_t bytes, double seconds) {
+    printf("== Summary ==\n");
+    printf("files            %zu (%.1f MB, %.1f MB of text)\n", files, bytes / 1048576.0, agg.text / 1048576.0);
+    printf("lines            %" PRIu64 " (%" PRIu64 " malformed, %" PRIu64 " outside --from/--to)\n",
+           agg.lines, agg.malformed, agg.filtered);
+    if (agg.damagedBlocks) {
+        printf("damaged blocks   %" PRIu64 "\n", agg.damagedBlocks);
+    }
+    printf("events           %" PRIu64 "\n", agg.total.events);
+    printf("deauth frames    %" PRIu64 "\n", agg.total.frames);
+    printf("first / last     %s / %s\n", formatTime(agg.total.first).c_str(), formatTime(agg.total.last).c_str());
+    printf("SSIDs            %zu\n", agg.ssids.size());
+    printf("BSSIDs           %zu\n", agg.targetSsid.size());
+    printf("attackers        %zu\n", agg.attackers.size());
+    printf("parsed in        %.2f s (%.0f MB/s, %.1f M lines/s)\n", seconds,
+           seconds > 0 ? agg.text / 1048576.0 / seconds : 0.0, seconds > 0 ? agg.lines / 1e6 / seconds : 0.0);
+
+    auto ssidName = [&](uint64_t bssid) -> std::string {
+        auto t = agg.targetSsid.find(bssid);
+        if (t == agg.targetSsid.end()) return "";
+        auto s = agg.ssids.find(t->second);
+        return s == agg.ssids.end() ? "" : s->second.name;
+    };
+
+    std::vector<Incident> incidents = findIncidents(agg, opt.gap);
+    std::vector<const Incident*> ip;
+    for (const Incident& in : incidents) ip.push_back(&in);
+    printf("\n== Incidents (gap %" PRId64 " s, %zu in total, top %zu by frames) ==\n", opt.gap, incidents.size(),
+           std::min(opt.top, incidents.size()));
+    printf("%-19s  %-8s  %-24s  %-17s  %8s  %10s  %9s\n", "start", "length", "ssid", "bssid", "events", "frames",
+           "peak/min");
+    for (const Incident* in : topN(ip, opt.top, [](const Incident* a, const Incident* b) {
+             if (a->frames != b->frames) return a->frames > b->frames;
+             return a->bssid != b->bssid ? a->bssid < b->bssid : a->start < b->start;
+         })) {
+        printf("%-19s  %-8s  %-24s  %-17s  %8" PRIu64 "  %10" PRIu64 "  %9" PRIu64 "\n",
+               formatTime(in->start * 60).c_str(), formatDuration((in->end - in->start + 1) * 60).c_str(),
+               clip(ssidName(in->bssid), 24).c_str(), formatMac(in->bssid).c_str(), in->events, in->frames,
+               in->peakFrames);
+    }
+
+    std::vector<const SsidStats*> sp;
+    for (const auto& kv : agg.ssids) sp.push_back(&kv.second);
+    printf("\n== SSIDs (top %zu by frames) ==\n", std::min(opt.top, sp.size()));
+    printf("%-24s  %8s  %10s  %6s  %9s  %5s  %-19s  %-19s\n", "ssid", "events", "frames", "bssids", "attackers",
+           "rssi", "first", "last");
+    for (const SsidStats* s : topN(sp, opt.top, [](const SsidStats* a, const SsidStats* b) {
+             return a->frames != b->frames ? a->frames > b->frames : a->name < b->name;
+         })) {
+        printf("%-24s  %8" PRIu64 "  %10" PRIu64 "  %6zu  %9zu  %5d  %-19s  %-19s\n", clip(s->name, 24).c_str(),
+               s->events, s->frames, s->bssids.size(), s->attackers.size(), s->bestRssi,
+               formatTime(s->first).c_str(), formatTime(s->last).c_str());
+    }
+
+    std::vector<std::pair<uint64_t, const AttackerStats*>> ap;
+    for (const auto& kv : agg.attackers) ap.push_back({kv.first, &kv.second});
+    size_t na = std::min(opt.top, ap.size());
+    std::partial_sort(ap.begin(), ap.begin() + na, ap.end(), [](const std::pair<uint64_t, const AttackerStats*>& a,
+                                                                const std::pair<uint64_t, const AttackerStats*>& b) {
+        if (a.second->frames != b.second->frames) return a.second->frames > b.second->frames;
+        return a.first < b.first;
+    });
+    printf("\n== Attackers (top %zu by frames) ==\n", na);
+    printf("%-17s  %8s  %10s  %-10s  %5s  %-16s  %-14s  %s\n", "mac", "events", "frames", "channels", "rssi",
+           "tool", "vendor", "flags");
+    for (size_t i = 0; i < na; i++) {
+        const AttackerStats& a = *ap[i].second;
+        std::string tool = winner(a.tools), vendor = winner(a.vendors);
+        std::string flags = a.randomized ? "random" : "";
+        if (a.denylisted) flags += flags.empty() ? "denylisted" : ",denylisted";
+        printf("%-17s  %8" PRIu64 "  %10" PRIu64 "  %-10s  %5d  %-16s  %-14s  %s\n", formatMac(ap[i].first).c_str(),
+               a.events, a.frames, clip(formatChannels(a.channels), 10).c_str(), a.bestRssi,
+               clip(tool.empty() ? "-" : tool, 16).c_str(), clip(vendor.empty() ? "-" : vendor, 14).c_str(),
+               flags.empty() ? "-" : flags.c_str());
+    }
+
+    printf("\n== Channels ==\n");
+    printf("%7s  %8s  %10s\n", "channel", "events", "frames");
+    for (int ch = 0; ch < 256; ch++) {
+        const Span& c = agg.channels[ch];
+        if (c.events) {
+            printf("%7d  %8" PRIu64 "  %10" PRIu64 "\n", ch, c.events, c.frames);
+        }
+    }
+
+    std::vector<const NamedSpan*> tp;
+    for (const auto& kv : agg.tools) tp.push_back(&kv.second);
+    printf("\n== Tools ==\n");
+    printf("%-24s  %8s  %10s\n", "tool", "events", "frames");
+    for (const NamedSpan* t : topN(tp, tp.size(), [](const NamedSpan* a, const NamedSpan* b) {
+             return a->events != b->events ? a->events > b->events : a->name < b->name;
+         })) {
+        printf("%-24s  %8" PRIu64 "  %10" PRIu64 "\n", clip(t->name, 24).c_str(), t->events, t->frames);
+    }
+
+    std::vector<std::pair<int64_t, uint64_t>> hist(agg.histogram.begin(), agg.histogram.end());
+    std::sort(hist.begin(), hist.end());
+    uint64_t peak = 0;
+    for (const auto& h : hist) peak = std::max(peak, h.second);
+    printf("\n== Events per %" PRId64 " s ==\n", opt.bucket);
+    // Empty buckets inside the range are printed too, up to a limit
+    const size_t maxRows = 500;
+    size_t rows = 0;
+    for (size_t i = 0; i < hist.size() && rows < maxRows; i++) {
+        if (i > 0) {
+            for (int64_t b = hist[i - 1].first + 1; b < hist[i].first && rows < maxRows; b++, rows++) {
+                printf("%-19s  %8d\n", formatTime(b * opt.bucket).c_str(), 0);
+                if (hist[i].first - b > 3) {
+                    printf("%-19s\n", "...");
+                    rows++;
+                    break;
+                }
+            }
+        }
+        int width = peak ? (int)(hist[i].second * 50 / peak) : 0;
+        printf("%-19s  %8" PRIu64 "  %.*s\n", formatTime(hist[i].first * opt.bucket).c_str(), hist[i].second,
+               width, "##################################################");
+        rows++;
+    }
+    if (rows >= maxRows) {
+        printf("(histogram cut at %zu rows; use a larger --bucket)\n", maxRows);
+    }
+}
+
+// ---- Synthetic logs --------------------------------------------------------
+
+// Session CSVs as the firmware's SessionWriter writes them: a few protected
+// networks per sensor, a pool of attackers (some randomized, some known
+// tools) and bursty incidents separated by quiet stretches. packet_count
+// runs from 1 to the default packet_threshold per BSSID within each default
+// reporting window, as the detector counts it.
+bool generate(const Options& opt) {
+    const int64_t window = 10;      // reporting_interval_seconds
+    const int threshold = 250;      // packet_threshold
+    mkdir(opt.generate.c_str(), 0755);
+    static const char* ssids[] = {"Home_WiFi", "Office_Secure", "Guest", "IoT-Net", "Cafe \"Free\" WiFi",
+                                  "Lab,5G", "Warehouse", "Printer-Net"};
+    static const char* tools[] = {"", "esp8266-deauther", "mdk4", "aireplay-ng", "flipper-marauder"};
+    static const char* vendors[] = {"", "Espressif", "Raspberry Pi", "Intel", "Realtek"};
+    size_t perFile = opt.sizeMb * 1048576 / std::max<size_t>(1, opt.files);
+    std::atomic<size_t> next(0);
+    std::atomic<bool> ok(true);
+
+    auto work = [&]() {
+        std::vector<char> buf(1 << 20);
+        for (size_t f; (f = next.fetch_add(1)) < opt.files;) {
+            std::mt19937_64 rng(opt.seed * 1000003ull + f);
+            int64_t t = 1769782800 + (int64_t)(f % 4) * 86400;     // sensors start on different days
+            char name[64];
+            time_t start = (time_t)t;
+            struct tm tm;
+            gmtime_r(&start, &tm);
+            strftime(name, sizeof(name), "deauthdetect_session_%Y%m%d_%H%M%S", &tm);
+            std::string path = opt.generate + "/" + name + "_" + std::to_string(f) + ".csv";
+            FILE* out = fopen(path.c_str(), "wb");
+            if (!out) {
+                fprintf(stderr, "%s: cannot create\n", path.c_str());
+                ok = false;
+                return;
+            }
+            uint64_t bssids[8], attackers[64];
+            for (auto& b : bssids) b = rng() & 0xFCFFFFFFFFFFull;
+            for (size_t i = 0; i < 64; i++) {
+                attackers[i] = rng() & 0xFFFFFFFFFFFFull;
+                attackers[i] = i % 3 == 0 ? (attackers[i] | 0x020000000000ull) : (attackers[i] & 0xFCFFFFFFFFFFull);
+            }
+
+            size_t written = 0, used = 0;
+            int burst = 0;
+            size_t target = 0, attacker = 0;
+            int counts[8] = {};
+            int64_t windowStart = t;
+            used += (size_t)snprintf(buf.data(), buf.size(), "%s\r\n", CSV_HEADER);
+            while (written + used < perFile) {
+                if (burst == 0) {
+                    t += 60 + (int64_t)(rng() % 1800);     // quiet stretch
+                    burst = 5 + (int)(rng() % 400);
+                    target = rng() % 8;
+                    attacker = rng() % 64;
+                }
+                burst--;
+                t += rng() % 16 == 0;      // floods run at a dozen or more frames a second
+                if (t - windowStart >= window) {
+                    windowStart = t;
+                    std::fill(counts, counts + 8, 0);
+                }
+                bool denylisted = attacker % 11 == 0;
+                if (counts[target] >= threshold && !denylisted) {
+                    continue;   // past the threshold: no event until the next window
+                }
+                counts[target]++;
+                if (rng() % 64 == 0) {
+                    continue;   // an event dropped before logging still counted its frame
+                }
+                time_t now = (time_t)t;
+                gmtime_r(&now, &tm);
+                char stamp[32];
+                strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+                uint64_t b = bssids[target], a = attackers[(attacker + (rng() % 16 == 0)) % 64];
+                size_t tool = attacker % 5;
+                int n = snprintf(buf.data() + used, buf.size() - used,
+                    "%s,\"%s\",\"%02X:%02X:%02X:%02X:%02X:%02X\",\"%02X:%02X:%02X:%02X:%02X:%02X\",%d,%d,%d,\"%s\",%d,%d,\"%s\",%d\r\n",
+                    stamp, ssids[target], (unsigned)(b >> 40 & 0xFF), (unsigned)(b >> 32 & 0xFF),
+                    (unsigned)(b >> 24 & 0xFF), (unsigned)(b >> 16 & 0xFF), (unsigned)(b >> 8 & 0xFF),
+                    (unsigned)(b & 0xFF), (unsigned)(a >> 40 & 0xFF), (unsigned)(a >> 32 & 0xFF),
+                    (unsigned)(a >> 24 & 0xFF), (unsigned)(a >> 16 & 0xFF), (unsigned)(a >> 8 & 0xFF),
+                    (unsigned)(a & 0xFF), 1 + (int)(target * 5 % 13), -35 - (int)(rng() % 55),
+                    counts[target], tools[tool], tool ? 50 + (int)(rng() % 50) : 0, denylisted,
+                    vendors[attacker % 5], (a >> 41 & 1) ? 1 : 0);
+                used += (size_t)n;
+                if (buf.size() - used < 512) {
+                    fwrite(buf.data(), 1, used, out);
+                    written += used;
+                    used = 0;
+                }
+            }
+            fwrite(buf.data(), 1, used, out);
+            if (fclose(out) != 0) {
+                fprintf(stderr, "%s: write failed\n", path.c_str());
+                ok = false;
+            }
+        }
+    };
+    unsigned n = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < n; i++) pool.emplace_back(work);
+    for (auto& th : pool) th.join();
+    fprintf(stderr, "wrote %zu files, about %zu MB, to %s\n", opt.files, opt.sizeMb, opt.generate.c_str());
+    return ok;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: ddanalyze [options] file...        session CSVs (.csv or .csv.ddz)\n"
+        "       ddanalyze --generate DIR [--size MB] [--files N] [--seed N]\n"
+        "  --top N        rows per table (10)\n"
+        "  --bucket SECS  histogram bucket (3600)\n"
+        "  --gap SECS     longest pause inside one incident (300)\n"
+        "  --from SECS    ignore events before this time\n"
+        "  --to SECS      ignore events after this time\n"
+        "  --threads N    parser threads (one per core)\n"
+        "  --chunk MB     work unit size (32)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        else if (!strcmp(a, "--top")) opt.top = strtoul(value(), nullptr, 10);
+        else if (!strcmp(a, "--bucket")) opt.bucket = std::max(1ll, strtoll(value(), nullptr, 10));
+        else if (!strcmp(a, "--gap")) opt.gap = std::max(0ll, strtoll(value(), nullptr, 10));
+        else if (!strcmp(a, "--from")) opt.from = strtoll(value(), nullptr, 10);
+        else if (!strcmp(a, "--to")) opt.to = strtoll(value(), nullptr, 10);
+        else if (!strcmp(a, "--threads")) opt.threads = (unsigned)strtoul(value(), nullptr, 10);
+        else if (!strcmp(a, "--chunk")) opt.chunkMb = std::max(1ul, strtoul(value(), nullptr, 10));
+        else if (!strcmp(a, "--generate")) opt.generate = value();
+        else if (!strcmp(a, "--size")) opt.sizeMb = strtoul(value(), nullptr, 10);
+        else if (!strcmp(a, "--files")) opt.files = std::max(1ul, strtoul(value(), nullptr, 10));
+        else if (!strcmp(a, "--seed")) opt.seed = (uint32_t)strtoul(value(), nullptr, 10);
+        else if (a[0] == '-') { usage(); return 2; }
+        else paths.push_back(a);
+    }
+    if (!opt.generate.empty()) {
+        return generate(opt) ? 0 : 1;
+    }
+    if (paths.empty()) {
+        usage();
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Mapped> files(paths.size());
+    std::vector<Chunk> chunks;
+    uint64_t bytes = 0;
+    bool ok = true;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!mapFile(paths[i], files[i])) {
+            ok = false;
+            continue;
+        }
+        bytes += files[i].size;
+    }
+    // Each directory is one sensor's log, in name order
+    auto directory = [](const std::string& path) {
+        size_t slash = path.rfind('/');
+        return slash == std::string::npos ? std::string() : path.substr(0, slash);
+    };
+    std::vector<Mapped*> byName;
+    for (Mapped& m : files) {
+        if (m.data) byName.push_back(&m);
+    }
+    std::sort(byName.begin(), byName.end(), [&](const Mapped* a, const Mapped* b) {
+        std::string da = directory(a->path), db = directory(b->path);
+        return da != db ? da < db : a->path < b->path;
+    });
+    for (size_t i = 0; i < byName.size(); i++) {
+        bool sameSensor = i > 0 && directory(byName[i]->path) == directory(byName[i - 1]->path);
+        byName[i]->sensor = sameSensor ? byName[i - 1]->sensor : i;
+        byName[i]->order = i;
+        splitFile(*byName[i], opt.chunkMb * 1048576, chunks);
+    }
+    // Largest first, so one big file doesn't finish last on its own
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) {
+        return a.end - a.begin > b.end - b.begin;
+    });
+
+    unsigned n = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    n = (unsigned)std::max<size_t>(1, std::min<size_t>(n, chunks.size()));
+    std::vector<Agg> aggs(n);
+    std::vector<Runs> runs(chunks.size());
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < n; i++) {
+        pool.emplace_back([&, i]() {
+            std::vector<uint8_t> text(DDZ_BLOCK_RAW);
+            for (size_t c; (c = next.fetch_add(1)) < chunks.size();) {
+                parseChunk(chunks[c], aggs[i], opt, text.data(), runs[c]);
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    for (unsigned i = 1; i < n; i++) {
+        aggs[0].merge(aggs[i]);
+    }
+    joinRuns(chunks, runs, aggs[0]);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    report(aggs[0], opt, files.size(), bytes, seconds);
+    for (const Mapped& m : files) {
+        if (m.data) munmap((void*)m.data, m.size);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// Binary session log exporter.
+//
+// Reads the *.ddb files the firmware writes next to each session CSV (format
+// in include/BinaryLog.h) and prints their events as CSV, in the session
+// CSV's columns, or as JSON. --from and --to take Unix seconds and use the
+// block index, so a narrow range reads only the blocks it needs.
+//
+//   ddbexport deauthdetect_session_20260130_142001.ddb
+//   ddbexport --format json --from 1769782800 --to 1769786400 *.ddb
+//   ddbexport --info session.ddb
+//
+// Timestamps are printed in UTC; the device's own CSV uses its configured
+// time zone.
+
+#include "BinaryLog.h"
+#include "OuiTable.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FileSource {
+    FILE* f;
+    size_t bytes;
+    size_t size() { return bytes; }
+    bool readAt(size_t offset, void* buf, size_t n) {
+        return fseek(f, (long)offset, SEEK_SET) == 0 && fread(buf, 1, n, f) == n;
+    }
+};
+
+struct Options {
+    bool json = false;
+    bool info = false;
+    int64_t fromUs = INT64_MIN;
+    int64_t toUs = INT64_MAX;
+};
+
+const char* vendorName(uint8_t v) {
+    return v < sizeof(OUI_VENDORS) / sizeof(OUI_VENDORS[0]) ? OUI_VENDORS[v] : "";
+}
+
+// CSV fields are quoted; JSON strings escaped
+std::string quoted(const char* s, bool json) {
+    std::string out;
+    for (; *s; s++) {
+        if (*s == '"') out += json ? "\\\"" : "\"\"";
+        else if (*s == '\\' && json) out += "\\\\";
+        else if ((unsigned char)*s < 0x20 && json) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*s);
+            out += esc;
+        } else out += *s;
+    }
+    return out;
+}
+
+bool exportFile(const char* path, const Options& opt, bool& firstJson) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    FileSource src = {f, (size_t)ftell(f)};
+    std::vector<BlogDictEntry> dict(BLOG_DICT_ENTRIES);
+    BlogReader<FileSource> reader(src, dict.data());
+    if (!reader.open()) {
+        fprintf(stderr, "%s: not a binary session log\n", path);
+        fclose(f);
+        return false;
+    }
+
+    if (opt.info) {
+        size_t names = 0;
+        while (names < dict.size() && dict[names].len) names++;
+        uint64_t events = 0;
+        BlogIndex first = {}, last = {};
+        for (uint32_t b = 0; b < reader.blockCount(); b++) {
+            BlogIndex index;
+            if (!reader.readIndex(b, index)) break;
+            if (b == 0) first = index;
+            last = index;
+            events += index.count;
+        }
+        printf("%s: version %u, %u blocks, %" PRIu64 " events, %zu names\n",
+               path, reader.getHeader().version, reader.blockCount(), events, names);
+        if (events) {
+            printf("  first %" PRId64 ".%06" PRId64 "  last %" PRId64 ".%06" PRId64 "\n",
+                   first.firstUs / 1000000, first.firstUs % 1000000, last.lastUs / 1000000, last.lastUs % 1000000);
+        }
+        fclose(f);
+        return true;
+    }
+
+    reader.scan(opt.fromUs, opt.toUs, [&](const BlogEvent& e) {
+        char ssid[40], tool[40], bssid[18], attacker[18], timestamp[32];
+        time_t seconds = (time_t)(e.timeUs / 1000000);
+        struct tm tm;
+        gmtime_r(&seconds, &tm);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        blogFormatMac(e.bssid, bssid);
+        blogFormatMac(e.attacker, attacker);
+        reader.name(e.ssid, ssid);
+        reader.name(e.tool, tool);
+        if (opt.json) {
+            printf("%s\n{\"timestamp\":\"%s\",\"timestamp_us\":%" PRId64 ",\"target_ssid\":\"%s\","
+                   "\"target_bssid\":\"%s\",\"attacker_mac\":\"%s\",\"channel\":%u,\"rssi\":%d,"
+                   "\"packet_count\":%u,\"tool\":\"%s\",\"tool_confidence\":%u,\"denylisted\":%s,"
+                   "\"vendor\":\"%s\",\"randomized\":%s}",
+                   firstJson ? "" : ",", timestamp, e.timeUs, quoted(ssid, true).c_str(), bssid, attacker,
+                   e.channel, e.rssi, e.packetCount, quoted(tool, true).c_str(), e.toolConfidence,
+                   e.flags & BLOG_DENYLISTED ? "true" : "false", vendorName(e.vendor),
+                   e.flags & BLOG_RANDOMIZED ? "true" : "false");
+            firstJson = false;
+        } else {
+            printf("%s,\"%s\",\"%s\",\"%s\",%u,%d,%u,\"%s\",%u,%d,\"%s\",%d\n",
+                   timestamp, quoted(ssid, false).c_str(), bssid, attacker, e.channel, e.rssi,
+                   e.packetCount, quoted(tool, false).c_str(), e.toolConfidence,
+                   e.flags & BLOG_DENYLISTED ? 1 : 0, vendorName(e.vendor), e.flags & BLOG_RANDOMIZED ? 1 : 0);
+        }
+        return true;
+    });
+    fclose(f);
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: ddbexport [options] file.ddb...\n"
+        "  --format F   csv (default) or json\n"
+        "  --from T     only events at or after Unix time T\n"
+        "  --to T       only events at or before Unix time T\n"
+        "  --info       summarize each file instead of exporting\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        if (!strcmp(a, "--info")) { opt.info = true; continue; }
+        if (a[0] != '-') { files.push_back(a); continue; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--format") && (!strcmp(v, "csv") || !strcmp(v, "json"))) opt.json = !strcmp(v, "json");
+        else if (!strcmp(a, "--from")) opt.fromUs = strtoll(v, nullptr, 10) * 1000000;
+        else if (!strcmp(a, "--to")) opt.toUs = strtoll(v, nullptr, 10) * 1000000 + 999999;
+        else { usage(); return 2; }
+        i++;
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    if (!opt.info) {
+        printf(opt.json ? "[" : "timestamp,target_ssid,target_bssid,attacker_mac,channel,rssi,packet_count,"
+                                "tool,tool_confidence,denylisted,vendor,randomized\n");
+    }
+    bool ok = true;
+    bool firstJson = true;
+    for (const char* path : files) {
+        ok &= exportFile(path, opt, firstJson);
+    }
+    if (opt.json && !opt.info) {
+        printf("\n]\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Binary trace decoder.
+//
+// Expands the trace records the firmware writes (format in
+// include/TraceFormat.h) into text. Input is either trace.bin from the SD
+// card or a raw capture of the serial port taken with debug.trace set to
+// "serial"; in a serial capture the ordinary debug lines are passed through
+// in order between the decoded records.
+//
+//   ddtrace trace.bin
+//   pio device monitor --raw > capture.bin; ddtrace capture.bin
+//   ddtrace --raw trace.bin
+//
+// Times are seconds since boot, taken from the device's micros() and
+// unwrapped across its 71-minute rollover.
+
+#include "TraceFormat.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    bool raw = false;       // id and arguments instead of text
+    bool traceOnly = false; // drop the text between frames
+};
+
+struct Stats {
+    uint64_t records = 0;
+    uint64_t unknown = 0;
+    uint64_t lost = 0;
+};
+
+void formatMac(uint32_t hi, uint32_t lo, std::string& out) {
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             hi >> 24 & 0xFF, hi >> 16 & 0xFF, hi >> 8 & 0xFF, hi & 0xFF, lo >> 8 & 0xFF, lo & 0xFF);
+    out += mac;
+}
+
+// printf over 32-bit arguments, per TraceFormat.h's conversions
+std::string expand(const char* fmt, const TraceRecord& r) {
+    std::string out;
+    size_t arg = 0;
+    auto next = [&]() { return arg < r.argCount ? r.args[arg++] : 0u; };
+    for (const char* p = fmt; *p; p++) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p++;
+            continue;
+        }
+        std::string spec = "%";
+        for (p++; *p && strchr("-+ #0123456789.", *p); p++) {
+            spec += *p;
+        }
+        char buf[64];
+        switch (*p) {
+        case 'm': {
+            uint32_t hi = next();
+            formatMac(hi, next(), out);
+            continue;
+        }
+        case 'd':
+        case 'i':
+            snprintf(buf, sizeof(buf), (spec + "d").c_str(), (int32_t)next());
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            snprintf(buf, sizeof(buf), (spec + *p).c_str(), (unsigned)next());
+            break;
+        default:
+            out += spec;
+            if (!*p) return out;
+            out += *p;
+            continue;
+        }
+        out += buf;
+    }
+    return out;
+}
+
+class Decoder {
+public:
+    Decoder(const Options& opt) : opt(opt) {}
+
+    void chunk(const uint8_t* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        uint8_t frame[TRACE_FRAME_MAX];
+        TraceRecord r;
+        size_t n = len <= TRACE_WIRE_MAX ? traceCobsDecode(data, len, frame, sizeof(frame)) : 0;
+        if (n > 0 && traceUnpack(frame, n, r)) {
+            record(r);
+        } else if (!opt.traceOnly) {
+            fwrite(data, 1, len, stdout);
+        }
+    }
+
+    const Stats& stats() const { return totals; }
+
+private:
+    const Options& opt;
+    Stats totals;
+    bool started = false;
+    uint32_t lastUs = 0;
+    int64_t clockUs = 0;
+
+    void record(const TraceRecord& r) {
+        // Signed deltas: records from different tasks may be slightly out
+        // of order, and a 32-bit rollover is a small positive step
+        if (started) {
+            clockUs += (int32_t)(r.timeUs - lastUs);
+        } else {
+            clockUs = r.timeUs;
+            started = true;
+        }
+        lastUs = r.timeUs;
+        totals.records++;
+
+        printf("[%" PRId64 ".%06" PRId64 "] ", clockUs / 1000000, clockUs % 1000000);
+        if (r.id >= TRACE_FORMAT_COUNT || opt.raw) {
+            if (r.id >= TRACE_FORMAT_COUNT) totals.unknown++;
+            printf("#%u", r.id);
+            for (size_t i = 0; i < r.argCount; i++) {
+                printf(" %08" PRIx32, r.args[i]);
+            }
+            printf("\n");
+            return;
+        }
+        if (r.argCount != traceArgCount(TRACE_FORMAT_STRINGS[r.id])) {
+            totals.unknown++;
+        }
+        printf("%s\n", expand(TRACE_FORMAT_STRINGS[r.id], r).c_str());
+
+        if (r.id == TRACE_START && r.args[0] != traceFormatHash()) {
+            fprintf(stderr, "warning: trace written by firmware with a different format table "
+                            "(%08" PRIx32 ", expected %08" PRIx32 "); text may be wrong\n",
+                    r.args[0], traceFormatHash());
+        }
+        if (r.id == TRACE_DROPPED) {
+            totals.lost += r.args[0];
+        }
+    }
+};
+
+bool decodeFile(const char* path, Decoder& decoder) {
+    FILE* f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    // Chunks end at 0x00; a chunk is either one frame or text
+    std::vector<uint8_t> chunk;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] == 0) {
+                decoder.chunk(chunk.data(), chunk.size());
+                chunk.clear();
+            } else {
+                chunk.push_back(buf[i]);
+            }
+        }
+    }
+    decoder.chunk(chunk.data(), chunk.size());
+    if (f != stdin) {
+        fclose(f);
+    }
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: ddtrace [options] file...   (- reads stdin)\n"
+        "  --raw          print format ids and raw arguments\n"
+        "  --trace-only   drop the debug text in serial captures\n"
+        "  --formats      list the format table and exit\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        if (!strcmp(a, "--raw")) { opt.raw = true; continue; }
+        if (!strcmp(a, "--trace-only")) { opt.traceOnly = true; continue; }
+        if (!strcmp(a, "--formats")) {
+            printf("format table %08" PRIx32 "\n", traceFormatHash());
+            for (size_t id = 0; id < TRACE_FORMAT_COUNT; id++) {
+                printf("%3zu  %s\n", id, TRACE_FORMAT_STRINGS[id]);
+            }
+            return 0;
+        }
+        if (a[0] == '-' && a[1]) { usage(); return 2; }
+        files.push_back(a);
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    Decoder decoder(opt);
+    bool ok = true;
+    for (const char* path : files) {
+        ok &= decodeFile(path, decoder);
+    }
+    const Stats& s = decoder.stats();
+    fprintf(stderr, "%" PRIu64 " records, %" PRIu64 " dropped on the device, %" PRIu64 " malformed\n",
+            s.records, s.lost, s.unknown);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+// Block-compressed log expander.
+//
+// Reads the .ddz logs the firmware writes when logging.compress is on
+// (session CSVs as *.csv.ddz, the debug log as debug.log.ddz; format in
+// include/CompressedLog.h) and prints their text.
+//
+//   ddunzip session_20250101_120000.csv.ddz > session.csv
+//   ddunzip --extract /media/sd/deauthdetector/logs/*.ddz
+//   ddunzip --info debug.log.ddz
+//   ddunzip --from 1735732800 --to 1735736400 session_*.csv.ddz
+//   ddunzip --pack session.csv
+//
+// --from/--to (Unix seconds) select whole blocks by the times in their
+// headers, so a few lines either side of the range may come along. --pack
+// compresses a text file the way the firmware does, for checking ratios.
+
+#include "CompressedLog.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FileSource {
+    FILE* f;
+    size_t bytes;
+    size_t size() { return bytes; }
+    bool readAt(size_t offset, void* buf, size_t n) {
+        return fseek(f, (long)offset, SEEK_SET) == 0 && fread(buf, 1, n, f) == n;
+    }
+};
+
+struct Options {
+    bool info = false;
+    bool extract = false;
+    bool pack = false;
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+};
+
+std::string formatTime(uint32_t t) {
+    if (t == 0) {
+        return "-";
+    }
+    time_t seconds = t;
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+bool expandFile(const char* path, const Options& opt) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    FileSource source = {f, (size_t)ftell(f)};
+    std::vector<uint8_t> payload(DDZ_STORED_MAX);
+    std::vector<uint8_t> text(DDZ_BLOCK_RAW);
+    DdzReader<FileSource> reader(source, payload.data(), text.data());
+    if (!reader.open()) {
+        fprintf(stderr, "%s: not a compressed log\n", path);
+        fclose(f);
+        return false;
+    }
+
+    FILE* out = stdout;
+    std::string outPath = path;
+    if (opt.extract) {
+        if (outPath.size() > 4 && outPath.compare(outPath.size() - 4, 4, ".ddz") == 0) {
+            outPath.resize(outPath.size() - 4);
+        } else {
+            outPath += ".txt";
+        }
+        out = fopen(outPath.c_str(), "wb");
+        if (!out) {
+            fprintf(stderr, "%s: cannot create\n", outPath.c_str());
+            fclose(f);
+            return false;
+        }
+    }
+
+    if (opt.info) {
+        printf("%s\n", path);
+        printf("  block    offset    text  stored  lines  first                last\n");
+    }
+    uint64_t blocks = 0, raw = 0, lines = 0;
+    size_t offset = sizeof(DdzHeader);
+    bool damaged = false;
+    DdzBlock b;
+    while (reader.next(b)) {
+        size_t at = offset;
+        offset += sizeof(DdzBlock) + b.storedLen;
+        if (b.lastTime != 0 && (b.lastTime < opt.from || b.firstTime > opt.to)) {
+            continue;
+        }
+        const char* t = reader.expand(b);
+        if (!t) {
+            damaged = true;
+            offset = at;
+            break;
+        }
+        if (opt.info) {
+            printf("  %5" PRIu64 "  %8zu  %6" PRIu32 "  %6" PRIu32 "  %5" PRIu32 "  %-19s  %s%s\n", blocks, at,
+                   b.rawLen, b.storedLen, b.lines, formatTime(b.firstTime).c_str(),
+                   formatTime(b.lastTime).c_str(), b.flags & DDZ_STORED ? "  stored" : "");
+        } else {
+            fwrite(t, 1, b.rawLen, out);
+        }
+        blocks++;
+        raw += b.rawLen;
+        lines += b.lines;
+    }
+
+    if (opt.info) {
+        // Bytes past the last block are normal: the writer rewrites its open
+        // block in place and a shorter version leaves the old tail behind
+        printf("  %" PRIu64 " blocks, %" PRIu64 " lines, %" PRIu64 " bytes of text in %zu bytes (%.1fx), "
+               "%zu trailing bytes\n", blocks, lines, raw, offset, offset ? (double)raw / (double)offset : 0.0,
+               source.bytes - offset);
+    }
+    if (damaged) {
+        fprintf(stderr, "%s: damaged block at offset %zu; the rest of the file is skipped\n", path, offset);
+    }
+    if (out != stdout) {
+        fclose(out);
+        fprintf(stderr, "%s -> %s\n", path, outPath.c_str());
+    }
+    fclose(f);
+    return true;
+}
+
+// Compresses a text file into path.ddz in DDZ_BLOCK_RAW blocks cut at line
+// ends, as the firmware's writer does. Blocks carry no times.
+bool packFile(const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    std::string outPath = std::string(path) + ".ddz";
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "%s: cannot create\n", outPath.c_str());
+        fclose(in);
+        return false;
+    }
+    DdzHeader header;
+    ddzInitHeader(header);
+    fwrite(&header, sizeof(header), 1, out);
+
+    std::vector<uint8_t> raw(DDZ_BLOCK_RAW);
+    std::vector<uint8_t> payload(DDZ_STORED_MAX);
+    std::vector<uint16_t> table(LZ_HASH_SIZE);
+    uint64_t inBytes = 0, outBytes = sizeof(header);
+    size_t held = 0;
+    for (;;) {
+        held += fread(raw.data() + held, 1, DDZ_BLOCK_RAW - held, in);
+        if (held == 0) {
+            break;
+        }
+        size_t take = held;
+        if (held == DDZ_BLOCK_RAW) {
+            while (take > 0 && raw[take - 1] != '\n') {
+                take--;
+            }
+            if (take == 0) {
+                take = held;
+            }
+        }
+
+        DdzBlock block = {};
+        block.magic = DDZ_BLOCK_MAGIC;
+        block.rawLen = (uint32_t)take;
+        for (size_t i = 0; i < take; i++) {
+            block.lines += raw[i] == '\n';
+        }
+        size_t n = lzCompress(raw.data(), take, payload.data(), payload.size(), table.data());
+        if (n == 0 || n >= take) {
+            memcpy(payload.data(), raw.data(), take);
+            n = take;
+            block.flags = DDZ_STORED;
+        }
+        block.storedLen = (uint32_t)n;
+        block.crc = ddzBlockCrc(block, payload.data());
+        fwrite(&block, sizeof(block), 1, out);
+        fwrite(payload.data(), 1, n, out);
+        inBytes += take;
+        outBytes += sizeof(block) + n;
+
+        memmove(raw.data(), raw.data() + take, held - take);
+        held -= take;
+    }
+    fclose(in);
+    fclose(out);
+    fprintf(stderr, "%s -> %s: %" PRIu64 " -> %" PRIu64 " bytes (%.1fx)\n", path, outPath.c_str(),
+            inBytes, outBytes, outBytes ? (double)inBytes / (double)outBytes : 0.0);
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: ddunzip [options] file...\n"
+        "  --info         list blocks and the compression ratio instead of the text\n"
+        "  --extract      write each file's text beside it, without .ddz\n"
+        "  --from SECS    only blocks with lines at or after this Unix time\n"
+        "  --to SECS      only blocks with lines at or before this Unix time\n"
+        "  --pack         compress text files to file.ddz\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        if (!strcmp(a, "--info")) { opt.info = true; continue; }
+        if (!strcmp(a, "--extract")) { opt.extract = true; continue; }
+        if (!strcmp(a, "--pack")) { opt.pack = true; continue; }
+        if ((!strcmp(a, "--from") || !strcmp(a, "--to")) && i + 1 < argc) {
+            uint32_t t = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            (a[2] == 'f' ? opt.from : opt.to) = t;
+            continue;
+        }
+        if (a[0] == '-') { usage(); return 2; }
+        files.push_back(a);
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    bool ok = true;
+    for (const char* path : files) {
+        ok &= opt.pack ? packFile(path) : expandFile(path, opt);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,334 @@
+// Hop-schedule coverage simulator.
+//
+// Drives the firmware's HopScheduler with a simulated main loop and replays
+// synthetic deauth bursts against the resulting channel timeline to estimate
+// how often a burst of N frames lasting T ms is seen at all, and how many of
+// its frames are lost.
+//
+//   hopsim --channels 1,6,11 --hop-ms 75 --burst-frames 10 --burst-ms 500
+//   hopsim --regress hopsim/baseline.txt
+//
+// In --regress mode every scenario in the file is run and the exit status is
+// non-zero if any falls below its detection floor or above its undercount
+// ceiling, so scheduler changes can't quietly reduce coverage.
+
+#include "HopScheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Scenario {
+    std::string      name = "adhoc";
+    std::vector<int> channels = {1, 6, 11};
+    unsigned long    hopMs = 75;          // channel_hop_interval_ms
+    unsigned long    loopMs = 10;         // main loop pass time
+    unsigned long    loopJitterMs = 5;    // extra 0..jitter per pass
+    double           switchMs = 0.0;      // retune dead time after each hop
+    int              burstFrames = 10;
+    double           burstMs = 500.0;
+    int              trials = 20000;
+    size_t           ringSize = 64;       // RAW_RING_SIZE in DetectorPolicy.h (StandardPolicy)
+    unsigned long    reportIntervalS = 0; // 0 = no reporting pauses
+    unsigned long    reportPauseMs = 0;
+    uint32_t         seed = 1;
+    double           minDetect = -1.0;    // < 0 = no floor
+    double           maxUndercount = -1.0;
+};
+
+// One stretch of time with the radio tuned to a single channel entry
+struct Segment {
+    double start;
+    double end;
+    int    index;     // into Scenario::channels, -1 = monitoring paused
+};
+
+struct Timeline {
+    std::vector<Segment> segments;
+    std::vector<double>  drains;   // main loop pass times (ring drained)
+    double               horizon;
+};
+
+struct ChannelStats {
+    int    channel = 0;
+    double dwellShare = 0;
+    double revisitMean = 0;
+    double revisitMax = 0;
+    int    bursts = 0;
+    int    missed = 0;
+    double undercountSum = 0;
+};
+
+Timeline buildTimeline(const Scenario& sc, std::mt19937& rng) {
+    Timeline tl;
+    // Long enough for many hop cycles and several report pauses
+    double cycle = (double)sc.hopMs * sc.channels.size();
+    tl.horizon = std::max(600000.0, cycle * 2000);
+    if (sc.reportIntervalS > 0) {
+        tl.horizon = std::max(tl.horizon, sc.reportIntervalS * 1000.0 * 20);
+    }
+
+    std::uniform_int_distribution<unsigned long> jitter(0, sc.loopJitterMs);
+    HopScheduler hop;
+    unsigned long now = 0;
+    unsigned long nextReport = sc.reportIntervalS * 1000;
+    hop.reset(now);
+    double segStart = 0;
+
+    while (now < tl.horizon) {
+        // Reporting: monitoring stops, WiFi reconnects, then hopping restarts at index 0
+        if (sc.reportIntervalS > 0 && now >= nextReport) {
+            tl.segments.push_back({segStart, (double)now, (int)hop.current()});
+            tl.segments.push_back({(double)now, (double)(now + sc.reportPauseMs), -1});
+            now += sc.reportPauseMs;
+            hop.reset(now);
+            segStart = now;
+            nextReport = now + sc.reportIntervalS * 1000;
+            continue;
+        }
+
+        tl.drains.push_back(now);
+        HopStep step = hop.poll(now, sc.channels.size(), sc.hopMs);
+        if (step.hop) {
+            tl.segments.push_back({segStart, (double)now, (int)step.from});
+            segStart = now;
+        }
+        now += sc.loopMs + jitter(rng);
+    }
+    tl.segments.push_back({segStart, (double)now, (int)hop.current()});
+    tl.horizon = now;
+    return tl;
+}
+
+const Segment* segmentAt(const Timeline& tl, double t) {
+    auto it = std::upper_bound(tl.segments.begin(), tl.segments.end(), t,
+                               [](double v, const Segment& s) { return v < s.start; });
+    if (it == tl.segments.begin()) return nullptr;
+    --it;
+    return t < it->end ? &*it : nullptr;
+}
+
+std::vector<ChannelStats> run(const Scenario& sc, double& detectRate, double& undercount) {
+    std::mt19937 rng(sc.seed);
+    Timeline tl = buildTimeline(sc, rng);
+
+    std::vector<ChannelStats> stats(sc.channels.size());
+    std::vector<double> lastEnd(sc.channels.size(), -1);
+    std::vector<double> revisitSum(sc.channels.size(), 0);
+    std::vector<int> revisitCount(sc.channels.size(), 0);
+
+    for (size_t i = 0; i < sc.channels.size(); i++) {
+        stats[i].channel = sc.channels[i];
+    }
+
+    // Dwell share and revisit latency straight from the schedule
+    for (const Segment& s : tl.segments) {
+        if (s.index < 0) continue;
+        ChannelStats& cs = stats[s.index];
+        cs.dwellShare += (s.end - s.start) / tl.horizon;
+        if (lastEnd[s.index] >= 0) {
+            double gap = s.start - lastEnd[s.index];
+            if (gap > 0) {
+                revisitSum[s.index] += gap;
+                revisitCount[s.index]++;
+                cs.revisitMax = std::max(cs.revisitMax, gap);
+            }
+        }
+        lastEnd[s.index] = s.end;
+    }
+    for (size_t i = 0; i < stats.size(); i++) {
+        stats[i].revisitMean = revisitCount[i] ? revisitSum[i] / revisitCount[i] : 0;
+    }
+
+    // Bursts: evenly spaced frames on one of the monitored channels
+    std::uniform_int_distribution<size_t> pickChannel(0, sc.channels.size() - 1);
+    std::uniform_real_distribution<double> pickStart(0, tl.horizon - sc.burstMs - 1);
+    double spacing = sc.burstFrames > 1 ? sc.burstMs / (sc.burstFrames - 1) : 0;
+    size_t ringCapacity = sc.ringSize > 0 ? sc.ringSize - 1 : 0;
+
+    int detected = 0;
+    double undercountSum = 0;
+    std::vector<double> captured;
+    captured.reserve(sc.burstFrames);
+
+    for (int trial = 0; trial < sc.trials; trial++) {
+        size_t target = pickChannel(rng);
+        double start = pickStart(rng);
+        captured.clear();
+
+        for (int f = 0; f < sc.burstFrames; f++) {
+            double t = start + f * spacing;
+            const Segment* seg = segmentAt(tl, t);
+            if (seg && seg->index == (int)target && t >= seg->start + sc.switchMs) {
+                captured.push_back(t);
+            }
+        }
+
+        // Ring overflow: frames between two drains beyond capacity are dropped
+        int kept = 0;
+        size_t inWindow = 0;
+        double windowEnd = -1;
+        for (double t : captured) {
+            if (t >= windowEnd) {
+                auto it = std::lower_bound(tl.drains.begin(), tl.drains.end(), t);
+                windowEnd = it == tl.drains.end() ? tl.horizon : *it;
+                inWindow = 0;
+            }
+            if (inWindow < ringCapacity) {
+                inWindow++;
+                kept++;
+            }
+        }
+
+        ChannelStats& cs = stats[target];
+        cs.bursts++;
+        double under = 1.0 - (double)kept / sc.burstFrames;
+        cs.undercountSum += under;
+        undercountSum += under;
+        if (kept > 0) {
+            detected++;
+        } else {
+            cs.missed++;
+        }
+    }
+
+    detectRate = (double)detected / sc.trials;
+    undercount = undercountSum / sc.trials;
+    return stats;
+}
+
+bool report(const Scenario& sc, bool verbose) {
+    double detect = 0, under = 0;
+    std::vector<ChannelStats> stats = run(sc, detect, under);
+
+    bool ok = true;
+    if (sc.minDetect >= 0 && detect < sc.minDetect) ok = false;
+    if (sc.maxUndercount >= 0 && under > sc.maxUndercount) ok = false;
+
+    if (verbose) {
+        printf("scenario        %s\n", sc.name.c_str());
+        printf("schedule        %zu channels, hop %lu ms, loop %lu+%lu ms, switch %.1f ms\n",
+               sc.channels.size(), sc.hopMs, sc.loopMs, sc.loopJitterMs, sc.switchMs);
+        printf("burst           %d frames over %.0f ms, %d trials\n",
+               sc.burstFrames, sc.burstMs, sc.trials);
+        printf("detection       %.4f\n", detect);
+        printf("undercount      %.4f (expected share of frames not seen)\n\n", under);
+        printf("  ch   dwell%%   revisit_mean_ms   revisit_max_ms   missed%%   undercount\n");
+        for (const ChannelStats& cs : stats) {
+            printf("  %2d   %6.1f   %15.1f   %14.1f   %7.2f   %10.4f\n",
+                   cs.channel, cs.dwellShare * 100, cs.revisitMean, cs.revisitMax,
+                   cs.bursts ? 100.0 * cs.missed / cs.bursts : 0.0,
+                   cs.bursts ? cs.undercountSum / cs.bursts : 0.0);
+        }
+        printf("\n");
+    } else {
+        printf("%-28s detect %.4f (min %.4f)  undercount %.4f (max %.4f)  %s\n",
+               sc.name.c_str(), detect, sc.minDetect, under, sc.maxUndercount,
+               ok ? "ok" : "FAIL");
+    }
+    return ok;
+}
+
+std::vector<int> parseChannels(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item == "all") {
+            for (int c = 1; c <= 14; c++) out.push_back(c);
+        } else if (!item.empty()) {
+            out.push_back(atoi(item.c_str()));
+        }
+    }
+    return out;
+}
+
+// name channels hop_ms loop_ms burst_frames burst_ms min_detect max_undercount
+int runRegression(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 2;
+    }
+
+    int failures = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ls(line);
+        Scenario sc;
+        std::string channels;
+        if (!(ls >> sc.name >> channels >> sc.hopMs >> sc.loopMs >> sc.burstFrames
+                 >> sc.burstMs >> sc.minDetect >> sc.maxUndercount)) {
+            fprintf(stderr, "bad scenario line: %s\n", line.c_str());
+            return 2;
+        }
+        sc.channels = parseChannels(channels);
+        if (!report(sc, false)) failures++;
+    }
+    return failures ? 1 : 0;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: hopsim [options]\n"
+        "       hopsim --regress FILE\n"
+        "  --channels LIST        comma list or 'all' (default 1,6,11)\n"
+        "  --hop-ms N             channel_hop_interval_ms (default 75)\n"
+        "  --loop-ms N            main loop pass time (default 10)\n"
+        "  --loop-jitter-ms N     random extra per pass (default 5)\n"
+        "  --switch-ms X          dead time after each retune (default 0)\n"
+        "  --burst-frames N       deauths per burst (default 10)\n"
+        "  --burst-ms X           burst duration (default 500)\n"
+        "  --trials N             bursts to simulate (default 20000)\n"
+        "  --ring N               raw capture ring size (default 64)\n"
+        "  --report-interval-s N  reporting_interval_seconds (default 0 = off)\n"
+        "  --report-pause-ms N    monitoring gap per report (default 0)\n"
+        "  --seed N               RNG seed (default 1)\n"
+        "  --min-detect P         exit 1 if detection rate < P\n"
+        "  --max-undercount U     exit 1 if undercount > U\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Scenario sc;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        if (!v) { usage(); return 2; }
+        i++;
+        if      (!strcmp(a, "--regress"))           return runRegression(v);
+        else if (!strcmp(a, "--channels"))          sc.channels = parseChannels(v);
+        else if (!strcmp(a, "--hop-ms"))            sc.hopMs = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--loop-ms"))           sc.loopMs = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--loop-jitter-ms"))    sc.loopJitterMs = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--switch-ms"))         sc.switchMs = atof(v);
+        else if (!strcmp(a, "--burst-frames"))      sc.burstFrames = atoi(v);
+        else if (!strcmp(a, "--burst-ms"))          sc.burstMs = atof(v);
+        else if (!strcmp(a, "--trials"))            sc.trials = atoi(v);
+        else if (!strcmp(a, "--ring"))              sc.ringSize = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--report-interval-s")) sc.reportIntervalS = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--report-pause-ms"))   sc.reportPauseMs = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--seed"))              sc.seed = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--min-detect"))        sc.minDetect = atof(v);
+        else if (!strcmp(a, "--max-undercount"))    sc.maxUndercount = atof(v);
+        else { usage(); return 2; }
+    }
+
+    if (sc.channels.empty() || sc.burstFrames < 1 || sc.trials < 1) {
+        usage();
+        return 2;
+    }
+    return report(sc, true) ? 0 : 1;
+}
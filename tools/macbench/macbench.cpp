@@ -0,0 +1,210 @@
+// Capture classification benchmark.
+//
+// Times the firmware's batch path from MacBatch.h (split into MAC columns,
+// hash, resolve against a BssidTable) over synthetic capture streams, at
+// batch sizes 1-16 with both the scalar and SSE2 kernels, next to the
+// per-frame path it replaced (format the BSSID with snprintf, look it up in
+// a std::map keyed by string).
+//
+//   macbench
+//   macbench --captures 2000000 --aps 200 --pattern flood
+//
+// Patterns:
+//   flood    one BSSID sends every frame (the usual attack)
+//   bursts   runs of 8-64 frames from a random known BSSID
+//   mixed    every frame from a uniformly random known BSSID
+//   unknown  half the frames from BSSIDs not in the table
+
+#include "MacBatch.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::array<uint8_t, 6> Mac;
+
+struct Options {
+    size_t   captures = 1000000;
+    size_t   aps = 64;
+    int      rounds = 5;
+    uint32_t seed = 1;
+    std::string pattern = "all";
+};
+
+Mac randomMac(std::mt19937& rng) {
+    Mac m;
+    for (auto& b : m) b = (uint8_t)rng();
+    m[0] &= 0xFC;   // globally administered unicast, like a real AP
+    return m;
+}
+
+std::vector<Mac> makeStream(const std::string& pattern, const std::vector<Mac>& aps, size_t n, std::mt19937& rng) {
+    std::vector<Mac> out;
+    out.reserve(n);
+    std::uniform_int_distribution<size_t> pick(0, aps.size() - 1);
+    if (pattern == "flood") {
+        out.assign(n, aps[pick(rng)]);
+    } else if (pattern == "bursts") {
+        std::uniform_int_distribution<size_t> len(8, 64);
+        while (out.size() < n) {
+            const Mac& m = aps[pick(rng)];
+            for (size_t i = len(rng); i > 0 && out.size() < n; i--) out.push_back(m);
+        }
+    } else if (pattern == "mixed") {
+        for (size_t i = 0; i < n; i++) out.push_back(aps[pick(rng)]);
+    } else {
+        for (size_t i = 0; i < n; i++) out.push_back((rng() & 1) ? aps[pick(rng)] : randomMac(rng));
+    }
+    return out;
+}
+
+typedef void (*HashKernel)(const MacColumn&, size_t, uint32_t*);
+
+template <uint32_t (*RepeatMask)(const MacColumn&, size_t)>
+uint64_t runBatch(const BssidTable& table, const std::vector<Mac>& stream, size_t batch, HashKernel hash) {
+    MacColumn col;
+    uint32_t hashes[MAC_BATCH_MAX];
+    int found[MAC_BATCH_MAX];
+    uint64_t sum = 0;
+    for (size_t base = 0; base < stream.size(); base += batch) {
+        size_t n = std::min(batch, stream.size() - base);
+        for (size_t i = 0; i < n; i++) {
+            macSplit(stream[base + i].data(), col.hi[i], col.lo[i]);
+        }
+        hash(col, n, hashes);
+        table.template findBatch<RepeatMask>(col, n, hashes, found);
+        for (size_t i = 0; i < n; i++) sum += (uint32_t)found[i];
+    }
+    return sum;
+}
+
+uint64_t runStrings(const std::map<std::string, int>& map, const std::vector<Mac>& stream) {
+    uint64_t sum = 0;
+    char buf[18];
+    for (const Mac& m : stream) {
+        snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+        auto it = map.find(buf);
+        sum += it == map.end() ? (uint32_t)-1 : (uint32_t)it->second;
+    }
+    return sum;
+}
+
+// Best of several rounds, in ns per capture
+template <typename F>
+double timeIt(int rounds, size_t captures, uint64_t& check, F f) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        check = f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / captures;
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+void report(const char* pattern, const char* path, size_t batch, double ns) {
+    char b[8];
+    if (batch) snprintf(b, sizeof(b), "%zu", batch); else snprintf(b, sizeof(b), "-");
+    printf("%-8s %-8s %5s %10.2f %10.1f\n", pattern, path, b, ns, 1000.0 / ns);
+}
+
+bool bench(const Options& opt, const std::string& pattern) {
+    std::mt19937 rng(opt.seed);
+    std::vector<Mac> aps;
+    BssidTable table;
+    std::map<std::string, int> map;
+    while (aps.size() < opt.aps) {
+        Mac m = randomMac(rng);
+        uint32_t hi, lo;
+        macSplit(m.data(), hi, lo);
+        if (table.insert(macHash(hi, lo), hi, lo, (uint16_t)aps.size()) != (int)aps.size()) continue;
+        char buf[18];
+        snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+        map[buf] = (int)aps.size();
+        aps.push_back(m);
+    }
+    std::vector<Mac> stream = makeStream(pattern, aps, opt.captures, rng);
+
+    uint64_t expect = 0, got = 0;
+    report(pattern.c_str(), "string", 0, timeIt(opt.rounds, stream.size(), expect, [&] { return runStrings(map, stream); }));
+
+    bool ok = true;
+    for (size_t batch = 1; batch <= MAC_BATCH_MAX; batch *= 2) {
+        double ns = timeIt(opt.rounds, stream.size(), got, [&] {
+            return runBatch<macRepeatMaskScalar>(table, stream, batch, macHashBatchScalar);
+        });
+        report(pattern.c_str(), "scalar", batch, ns);
+        ok &= got == expect;
+#if defined(__SSE2__)
+        ns = timeIt(opt.rounds, stream.size(), got, [&] {
+            return runBatch<macRepeatMaskSse2>(table, stream, batch, macHashBatchSse2);
+        });
+        report(pattern.c_str(), "sse2", batch, ns);
+        ok &= got == expect;
+#endif
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: batch path disagrees with the string path\n", pattern.c_str());
+    }
+    return ok;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: macbench [options]\n"
+        "  --captures N   frames per stream (default 1000000)\n"
+        "  --aps N        known BSSIDs in the table, at most %zu (default 64)\n"
+        "  --pattern P    flood, bursts, mixed, unknown or all (default all)\n"
+        "  --rounds N     timed rounds per case, best is reported (default 5)\n"
+        "  --seed N       RNG seed (default 1)\n",
+        BssidTable::CAPACITY);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i += 2) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(); return 0; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--captures")) opt.captures = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--aps")) opt.aps = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--pattern")) opt.pattern = v;
+        else if (!strcmp(a, "--rounds")) opt.rounds = atoi(v);
+        else if (!strcmp(a, "--seed")) opt.seed = strtoul(v, nullptr, 10);
+        else { usage(); return 2; }
+    }
+    if (opt.captures == 0 || opt.aps == 0 || opt.aps > BssidTable::CAPACITY || opt.rounds < 1) {
+        usage();
+        return 2;
+    }
+
+    std::vector<std::string> patterns;
+    if (opt.pattern == "all") {
+        patterns = {"flood", "bursts", "mixed", "unknown"};
+    } else if (opt.pattern == "flood" || opt.pattern == "bursts" || opt.pattern == "mixed" || opt.pattern == "unknown") {
+        patterns = {opt.pattern};
+    } else {
+        usage();
+        return 2;
+    }
+
+    printf("%-8s %-8s %5s %10s %10s\n", "pattern", "path", "batch", "ns/frame", "Mframes/s");
+    bool ok = true;
+    for (const std::string& p : patterns) {
+        ok &= bench(opt, p);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+// OUI table generator.
+//
+// Reads the IEEE MA-L registry (oui.csv from
+// https://standards-oui.ieee.org/oui/oui.csv) and writes include/OuiTable.h
+// with the assignments of the vendors listed in vendors.txt, sorted for the
+// firmware's binary search.
+//
+//   ouigen --csv oui.csv --vendors ouigen/vendors.txt --out ../include/OuiTable.h
+//
+// tools/ouigen/oui-subset.csv is a small extract of the registry covering
+// the common OUIs of each vendor; it is what the committed table is built
+// from, since the full file is several megabytes. Point --csv at the full
+// registry for complete coverage.
+//
+// Each table entry is one uint32_t, (oui << 8) | vendor index, so the table
+// costs four bytes of flash per assignment and at most 255 vendors fit.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Vendor {
+    std::string name;
+    std::vector<std::string> patterns;   // lower case
+};
+
+std::string lower(std::string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+bool loadVendors(const char* path, std::vector<Vendor>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            fprintf(stderr, "%s: missing '=' in \"%s\"\n", path, line.c_str());
+            return false;
+        }
+        Vendor v;
+        v.name = trim(line.substr(0, eq));
+        std::string rest = line.substr(eq + 1);
+        size_t start = 0;
+        while (start <= rest.size()) {
+            size_t bar = rest.find('|', start);
+            if (bar == std::string::npos) bar = rest.size();
+            std::string p = trim(rest.substr(start, bar - start));
+            if (!p.empty()) v.patterns.push_back(lower(p));
+            start = bar + 1;
+        }
+        out.push_back(v);
+    }
+    return true;
+}
+
+// One CSV record; quoted fields may contain commas and "" escapes
+std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') { fields.back() += '"'; i++; }
+            else if (c == '"') quoted = false;
+            else fields.back() += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+const char* baseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+void usage() {
+    fprintf(stderr, "usage: ouigen --csv oui.csv --vendors vendors.txt --out OuiTable.h\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* csvPath = nullptr;
+    const char* vendorsPath = nullptr;
+    const char* outPath = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--csv")) csvPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--vendors")) vendorsPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--out")) outPath = argv[i + 1];
+        else { usage(); return 2; }
+    }
+    if (!csvPath || !vendorsPath || !outPath) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Vendor> vendors;
+    if (!loadVendors(vendorsPath, vendors)) {
+        fprintf(stderr, "cannot read %s\n", vendorsPath);
+        return 1;
+    }
+    if (vendors.empty() || vendors.size() > 255) {
+        fprintf(stderr, "need 1-255 vendors, got %zu\n", vendors.size());
+        return 1;
+    }
+
+    std::ifstream csv(csvPath);
+    if (!csv) {
+        fprintf(stderr, "cannot read %s\n", csvPath);
+        return 1;
+    }
+
+    std::vector<uint32_t> entries;
+    std::vector<size_t> perVendor(vendors.size(), 0);
+    std::string line;
+    std::getline(csv, line);    // header
+    while (std::getline(csv, line)) {
+        std::vector<std::string> f = splitCsv(line);
+        if (f.size() < 3 || f[0] != "MA-L" || f[1].size() != 6) continue;
+        uint32_t oui = (uint32_t)strtoul(f[1].c_str(), nullptr, 16);
+        std::string org = lower(f[2]);
+        for (size_t v = 0; v < vendors.size(); v++) {
+            bool hit = false;
+            for (const std::string& p : vendors[v].patterns) {
+                if (org.find(p) != std::string::npos) { hit = true; break; }
+            }
+            if (hit) {
+                entries.push_back(oui << 8 | (uint32_t)(v + 1));
+                perVendor[v]++;
+                break;
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](uint32_t a, uint32_t b) { return a >> 8 == b >> 8; }),
+                  entries.end());
+
+    FILE* out = fopen(outPath, "w");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    fprintf(out,
+        "#ifndef OUI_TABLE_H\n"
+        "#define OUI_TABLE_H\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "\n"
+        "// Generated by tools/ouigen from the IEEE MA-L registry for the vendors in\n"
+        "// tools/ouigen/vendors.txt. Do not edit by hand. Included only by\n"
+        "// OuiLookup.cpp; both arrays live in flash.\n"
+        "//\n"
+        "// Source: %s, %zu assignments\n"
+        "\n"
+        "static constexpr const char* const OUI_VENDORS[] = {\n"
+        "    \"\",\n", baseName(csvPath), entries.size());
+    for (const Vendor& v : vendors) {
+        fprintf(out, "    \"%s\",\n", v.name.c_str());
+    }
+    fprintf(out,
+        "};\n"
+        "\n"
+        "// (oui << 8) | index into OUI_VENDORS, ascending\n"
+        "static constexpr uint32_t OUI_TABLE[] = {\n");
+    for (size_t i = 0; i < entries.size(); i++) {
+        fprintf(out, "%s0x%06Xu << 8 | %2u,%s", i % 4 == 0 ? "    " : " ",
+                entries[i] >> 8, entries[i] & 0xFF, i % 4 == 3 || i + 1 == entries.size() ? "\n" : "");
+    }
+    fprintf(out,
+        "};\n"
+        "\n"
+        "#endif\n");
+    fclose(out);
+
+    for (size_t v = 0; v < vendors.size(); v++) {
+        printf("%-14s %zu\n", vendors[v].name.c_str(), perVendor[v]);
+    }
+    printf("%zu entries, %zu bytes\n", entries.size(), entries.size() * sizeof(uint32_t));
+    return 0;
+}